@@ -25,25 +25,46 @@
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
 #include "common_cpp/macros/macros.h"
-#include "google/protobuf/text_format.h"
+#include "google/protobuf/arena.h"
 #include "src/farmhash.h"
 #include "wfa/virtual_people/common/event.pb.h"
 #include "wfa/virtual_people/common/label.pb.h"
 #include "wfa/virtual_people/common/model.pb.h"
+#include "wfa/virtual_people/core/model/flat_model.h"
 #include "wfa/virtual_people/core/model/model_node.h"
+#include "wfa/virtual_people/core/model/model_stats.h"
+#include "wfa/virtual_people/core/model/utils/path_trace.h"
 
 namespace wfa_virtual_people {
 
+// The size of the initial block of the arena used by LabelBatch. The initial
+// block is kept when the arena is reset, so any event which fits in it is
+// labeled without allocating memory for the LabelerEvent and its clones.
+constexpr size_t kBatchArenaInitialBlockSize = 64 * 1024;
+
 absl::StatusOr<std::unique_ptr<Labeler>> Labeler::Build(
     const CompiledNode& root) {
+  return Build(root, LabelerOptions());
+}
+
+absl::StatusOr<std::unique_ptr<Labeler>> Labeler::Build(
+    const std::vector<CompiledNode>& nodes) {
+  return Build(nodes, LabelerOptions());
+}
+
+absl::StatusOr<std::unique_ptr<Labeler>> Labeler::Build(
+    const CompiledNode& root, const LabelerOptions& options) {
   ASSIGN_OR_RETURN(std::unique_ptr<ModelNode> root_node,
                    ModelNode::Build(root));
-  return absl::make_unique<Labeler>(std::move(root_node));
+  ASSIGN_OR_RETURN(std::unique_ptr<FlatModel> model,
+                   FlatModel::Build(std::move(root_node), options.stats));
+  return absl::make_unique<Labeler>(std::move(model), options);
 }
 
 absl::StatusOr<std::unique_ptr<Labeler>> Labeler::Build(
-    const std::vector<CompiledNode>& nodes) {
+    const std::vector<CompiledNode>& nodes, const LabelerOptions& options) {
   std::unique_ptr<ModelNode> root = nullptr;
   absl::flat_hash_map<uint32_t, std::unique_ptr<ModelNode>> node_refs;
 
@@ -82,83 +103,117 @@ absl::StatusOr<std::unique_ptr<Labeler>> Labeler::Build(
     return absl::InvalidArgumentError("Some nodes are not in the model tree.");
   }
 
-  return absl::make_unique<Labeler>(std::move(root));
+  ASSIGN_OR_RETURN(std::unique_ptr<FlatModel> model,
+                   FlatModel::Build(std::move(root), options.stats));
+  return absl::make_unique<Labeler>(std::move(model), options);
 }
 
-void SetUserInfoFingerprint(UserInfo& user_info) {
+// Sets the fingerprint of user_id. If @keep_precomputed is true, an already
+// set user_id_fingerprint is not changed.
+void SetUserInfoFingerprint(UserInfo& user_info, bool keep_precomputed) {
+  if (keep_precomputed && user_info.has_user_id_fingerprint()) {
+    return;
+  }
   if (user_info.has_user_id()) {
     user_info.set_user_id_fingerprint(util::Fingerprint64(user_info.user_id()));
   }
 }
 
-// Generates fingerprints for event_id and user_id.
-// The default value of acting_fingerprint is the fingerprint of event_id.
-void SetFingerprints(LabelerEvent& event) {
-  LabelerInput* labeler_input = event.mutable_labeler_input();
-
-  if (labeler_input->has_event_id()) {
-    uint64_t event_id_fingerprint =
-        util::Fingerprint64(labeler_input->event_id().id());
-    labeler_input->mutable_event_id()->set_id_fingerprint(event_id_fingerprint);
-    event.set_acting_fingerprint(event_id_fingerprint);
+// Generates fingerprints for event_id and user_id. If @keep_precomputed is
+// true, the fingerprints which are already set are not changed.
+void SetInputFingerprints(LabelerInput& labeler_input, bool keep_precomputed) {
+  if (labeler_input.has_event_id() &&
+      !(keep_precomputed && labeler_input.event_id().has_id_fingerprint())) {
+    labeler_input.mutable_event_id()->set_id_fingerprint(
+        util::Fingerprint64(labeler_input.event_id().id()));
   }
 
-  if (!labeler_input->has_profile_info()) {
+  if (!labeler_input.has_profile_info()) {
     return;
   }
 
-  ProfileInfo* profile_info = labeler_input->mutable_profile_info();
+  ProfileInfo* profile_info = labeler_input.mutable_profile_info();
   if (profile_info->has_email_user_info()) {
-    SetUserInfoFingerprint(*profile_info->mutable_email_user_info());
+    SetUserInfoFingerprint(*profile_info->mutable_email_user_info(),
+                           keep_precomputed);
   }
   if (profile_info->has_phone_user_info()) {
-    SetUserInfoFingerprint(*profile_info->mutable_phone_user_info());
+    SetUserInfoFingerprint(*profile_info->mutable_phone_user_info(),
+                           keep_precomputed);
   }
   if (profile_info->has_logged_in_id_user_info()) {
-    SetUserInfoFingerprint(*profile_info->mutable_logged_in_id_user_info());
+    SetUserInfoFingerprint(*profile_info->mutable_logged_in_id_user_info(),
+                           keep_precomputed);
   }
   if (profile_info->has_logged_out_id_user_info()) {
-    SetUserInfoFingerprint(*profile_info->mutable_logged_out_id_user_info());
+    SetUserInfoFingerprint(*profile_info->mutable_logged_out_id_user_info(),
+                           keep_precomputed);
   }
   if (profile_info->has_proprietary_id_space_1_user_info()) {
     SetUserInfoFingerprint(
-        *profile_info->mutable_proprietary_id_space_1_user_info());
+        *profile_info->mutable_proprietary_id_space_1_user_info(),
+        keep_precomputed);
   }
   if (profile_info->has_proprietary_id_space_2_user_info()) {
     SetUserInfoFingerprint(
-        *profile_info->mutable_proprietary_id_space_2_user_info());
+        *profile_info->mutable_proprietary_id_space_2_user_info(),
+        keep_precomputed);
   }
   if (profile_info->has_proprietary_id_space_3_user_info()) {
     SetUserInfoFingerprint(
-        *profile_info->mutable_proprietary_id_space_3_user_info());
+        *profile_info->mutable_proprietary_id_space_3_user_info(),
+        keep_precomputed);
   }
   if (profile_info->has_proprietary_id_space_4_user_info()) {
     SetUserInfoFingerprint(
-        *profile_info->mutable_proprietary_id_space_4_user_info());
+        *profile_info->mutable_proprietary_id_space_4_user_info(),
+        keep_precomputed);
   }
   if (profile_info->has_proprietary_id_space_5_user_info()) {
     SetUserInfoFingerprint(
-        *profile_info->mutable_proprietary_id_space_5_user_info());
+        *profile_info->mutable_proprietary_id_space_5_user_info(),
+        keep_precomputed);
   }
   if (profile_info->has_proprietary_id_space_6_user_info()) {
     SetUserInfoFingerprint(
-        *profile_info->mutable_proprietary_id_space_6_user_info());
+        *profile_info->mutable_proprietary_id_space_6_user_info(),
+        keep_precomputed);
   }
   if (profile_info->has_proprietary_id_space_7_user_info()) {
     SetUserInfoFingerprint(
-        *profile_info->mutable_proprietary_id_space_7_user_info());
+        *profile_info->mutable_proprietary_id_space_7_user_info(),
+        keep_precomputed);
   }
   if (profile_info->has_proprietary_id_space_8_user_info()) {
     SetUserInfoFingerprint(
-        *profile_info->mutable_proprietary_id_space_8_user_info());
+        *profile_info->mutable_proprietary_id_space_8_user_info(),
+        keep_precomputed);
   }
   if (profile_info->has_proprietary_id_space_9_user_info()) {
     SetUserInfoFingerprint(
-        *profile_info->mutable_proprietary_id_space_9_user_info());
+        *profile_info->mutable_proprietary_id_space_9_user_info(),
+        keep_precomputed);
   }
   if (profile_info->has_proprietary_id_space_10_user_info()) {
     SetUserInfoFingerprint(
-        *profile_info->mutable_proprietary_id_space_10_user_info());
+        *profile_info->mutable_proprietary_id_space_10_user_info(),
+        keep_precomputed);
+  }
+}
+
+// Generates fingerprints of the labeler_input of @event.
+// The default value of acting_fingerprint is the fingerprint of event_id.
+void SetFingerprints(LabelerEvent& event, bool keep_precomputed) {
+  SetInputFingerprints(*event.mutable_labeler_input(), keep_precomputed);
+  if (event.labeler_input().has_event_id()) {
+    event.set_acting_fingerprint(
+        event.labeler_input().event_id().id_fingerprint());
+  }
+}
+
+void FingerprintLabelerInputs(absl::Span<LabelerInput> inputs) {
+  for (LabelerInput& input : inputs) {
+    SetInputFingerprints(input, /* keep_precomputed = */ false);
   }
 }
 
@@ -169,33 +224,153 @@ absl::Status Labeler::Label(const LabelerInput& input,
 
 absl::Status Labeler::Label(const LabelerInput& input, LabelerOutput& output,
                             LabelingMode mode) const {
-  // Prepare labeler event.
   LabelerEvent event;
+  return LabelEvent(input, mode, event, output);
+}
+
+absl::Status Labeler::Label(const LabelerInput& input, LabelerOutput& output,
+                            LabelingMode mode,
+                            google::protobuf::Arena* arena) const {
+  if (arena == nullptr) {
+    return Label(input, output, mode);
+  }
+  LabelerEvent* event = google::protobuf::Arena::Create<LabelerEvent>(arena);
+  return LabelEvent(input, mode, *event, output);
+}
+
+absl::Status Labeler::Label(LabelerInput&& input, LabelerOutput& output) const {
+  return Label(std::move(input), output, LabelingMode::kFull);
+}
+
+absl::Status Labeler::Label(LabelerInput&& input, LabelerOutput& output,
+                            LabelingMode mode) const {
+  LabelerEvent event;
+  return LabelEvent(std::move(input), mode, event, output);
+}
+
+absl::StatusOr<std::string> Labeler::RenderDebugTrace(
+    absl::string_view serialized_debug_trace) {
+  return PathTrace::Render(serialized_debug_trace);
+}
+
+absl::StatusOr<ModelStats> Labeler::GetStats() const {
+  return model_->GetStats();
+}
+
+absl::Status Labeler::LabelBatch(absl::Span<const LabelerInput> inputs,
+                                 absl::Span<LabelerOutput> outputs) const {
+  return LabelBatch(inputs, outputs, LabelingMode::kFull);
+}
+
+// Returns error status if @inputs and @outputs have different sizes.
+absl::Status CheckBatchSizes(absl::Span<const LabelerInput> inputs,
+                             absl::Span<LabelerOutput> outputs) {
+  if (inputs.size() != outputs.size()) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("The sizes of inputs and outputs are different: ",
+                     inputs.size(), " vs ", outputs.size()));
+  }
+  return absl::OkStatus();
+}
+
+// Adds the @index of the failed input to the message of @status.
+absl::Status AnnotateBatchError(const absl::Status& status, size_t index) {
+  return absl::Status(status.code(),
+                      absl::StrCat("Failed to label input at index ", index,
+                                   ": ", status.message()));
+}
+
+absl::Status Labeler::LabelBatch(absl::Span<const LabelerInput> inputs,
+                                 absl::Span<LabelerOutput> outputs,
+                                 LabelingMode mode) const {
+  RETURN_IF_ERROR(CheckBatchSizes(inputs, outputs));
+
+  // The arena must be destroyed before its initial block.
+  auto initial_block = absl::make_unique<char[]>(kBatchArenaInitialBlockSize);
+  google::protobuf::Arena arena(initial_block.get(),
+                                kBatchArenaInitialBlockSize);
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    LabelerEvent* event = google::protobuf::Arena::Create<LabelerEvent>(&arena);
+    absl::Status status = LabelEvent(inputs[i], mode, *event, outputs[i]);
+    if (!status.ok()) {
+      return AnnotateBatchError(status, i);
+    }
+    // Releases the event and its clones at once.
+    arena.Reset();
+  }
+  return absl::OkStatus();
+}
+
+absl::Status Labeler::LabelBatch(absl::Span<const LabelerInput> inputs,
+                                 absl::Span<LabelerOutput> outputs,
+                                 LabelingMode mode,
+                                 google::protobuf::Arena* arena) const {
+  if (arena == nullptr) {
+    return LabelBatch(inputs, outputs, mode);
+  }
+  RETURN_IF_ERROR(CheckBatchSizes(inputs, outputs));
+
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    LabelerEvent* event = google::protobuf::Arena::Create<LabelerEvent>(arena);
+    absl::Status status = LabelEvent(inputs[i], mode, *event, outputs[i]);
+    if (!status.ok()) {
+      return AnnotateBatchError(status, i);
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status Labeler::LabelEvent(const LabelerInput& input, LabelingMode mode,
+                                 LabelerEvent& event,
+                                 LabelerOutput& output) const {
   *event.mutable_labeler_input() = input;
-  SetFingerprints(event);
+  return ApplyModel(mode, event, output);
+}
+
+absl::Status Labeler::LabelEvent(LabelerInput&& input, LabelingMode mode,
+                                 LabelerEvent& event,
+                                 LabelerOutput& output) const {
+  // Swap is a pointer swap when @input and @event are on the same arena, or
+  // both on the heap.
+  event.mutable_labeler_input()->Swap(&input);
+  return ApplyModel(mode, event, output);
+}
+
+absl::Status Labeler::ApplyModel(LabelingMode mode, LabelerEvent& event,
+                                 LabelerOutput& output) const {
+  // Prepare labeler event.
+  SetFingerprints(event, options_.use_precomputed_fingerprints);
 
   if (mode == LabelingMode::kPoolIdentity) {
     event.set_pool_identity_mode(true);
   }
 
   // Apply model.
-  RETURN_IF_ERROR(root_->Apply(event));
+  if (event.labeler_input().enable_debug_trace()) {
+    // The model nodes record the path of the event to the trace. The trace of
+    // each thread is reused, so recording does not allocate memory once the
+    // buffer is large enough.
+    thread_local PathTrace trace;
+    trace.Clear();
+    {
+      ScopedPathTrace scoped_trace(&trace);
+      RETURN_IF_ERROR(model_->Apply(event));
+    }
+    output.set_serialized_debug_trace(trace.Serialize());
+  } else {
+    RETURN_IF_ERROR(model_->Apply(event));
+  }
 
-  // Populate data to output.
-  *output.mutable_people() = event.virtual_person_activities();
+  // Populate data to output. The event is discarded after labeling, so the
+  // labels are moved rather than copied. This is a swap when @event and
+  // @output are on the same arena, or both on the heap.
+  *output.mutable_people() =
+      std::move(*event.mutable_virtual_person_activities());
 
-  // Copy pool assignments from event to output (populated in pass-1 mode).
-  *output.mutable_pool_assignments() = event.pool_assignments();
+  // Move pool assignments from event to output (populated in pass-1 mode).
+  *output.mutable_pool_assignments() =
+      std::move(*event.mutable_pool_assignments());
 
-  if (input.enable_debug_trace()) {
-    // TODO(@tcsnfkx): Update the content of debug trace. Currently only set the
-    // debug trace to be the LabelerEvent. Use TextFormat::PrintToString rather
-    // than DebugString(): newer protobuf intentionally makes DebugString()
-    // emit a non-roundtrippable redaction marker.
-    std::string trace;
-    google::protobuf::TextFormat::PrintToString(event, &trace);
-    output.set_serialized_debug_trace(trace);
-  }
   return absl::OkStatus();
 }
 
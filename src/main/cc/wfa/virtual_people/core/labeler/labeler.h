@@ -16,15 +16,20 @@
 #define SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_LABELER_LABELER_H_
 
 #include <memory>
+#include <string>
 #include <utility>
 #include <vector>
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "google/protobuf/arena.h"
 #include "wfa/virtual_people/common/event.pb.h"
 #include "wfa/virtual_people/common/label.pb.h"
 #include "wfa/virtual_people/common/model.pb.h"
-#include "wfa/virtual_people/core/model/model_node.h"
+#include "wfa/virtual_people/core/model/flat_model.h"
+#include "wfa/virtual_people/core/model/model_stats.h"
 
 namespace wfa_virtual_people {
 
@@ -33,6 +38,31 @@ enum class LabelingMode {
   kPoolIdentity,  // Pass 1: emit pool assignment, no VID.
 };
 
+struct LabelerOptions {
+  // When true, the fingerprints already set in the LabelerInput are used as
+  // is, and only the missing ones are computed. This covers
+  // event_id.id_fingerprint, and user_id_fingerprint of every UserInfo in
+  // profile_info.
+  //
+  // Only enable this when the fingerprints are set by a trusted upstream, e.g.
+  // by FingerprintLabelerInputs, as the labels are computed from the
+  // fingerprints rather than from the ids.
+  bool use_precomputed_fingerprints = false;
+
+  // Collects the execution statistics of each model node, which can be read
+  // with Labeler::GetStats. Disabled by default.
+  ModelStatsOptions stats;
+};
+
+// Sets event_id.id_fingerprint and user_id_fingerprint of every UserInfo in
+// profile_info, for each of @inputs. Only the fingerprints of the ids which are
+// set are updated.
+//
+// Events labeled more than once, e.g. in pass 1 and pass 2, can be
+// fingerprinted once with this, and then labeled by a Labeler with
+// use_precomputed_fingerprints set.
+void FingerprintLabelerInputs(absl::Span<LabelerInput> inputs);
+
 class Labeler {
  public:
   // Always use Labeler::Build to get a Labeler object.
@@ -95,13 +125,27 @@ class Labeler {
   static absl::StatusOr<std::unique_ptr<Labeler>> Build(
       const std::vector<CompiledNode>& nodes);
 
-  explicit Labeler(std::unique_ptr<ModelNode> root) : root_(std::move(root)) {}
+  // Same as the above Build methods, with labeling @options.
+  static absl::StatusOr<std::unique_ptr<Labeler>> Build(
+      const CompiledNode& root, const LabelerOptions& options);
+  static absl::StatusOr<std::unique_ptr<Labeler>> Build(
+      const std::vector<CompiledNode>& nodes, const LabelerOptions& options);
+
+  explicit Labeler(std::unique_ptr<FlatModel> model)
+      : model_(std::move(model)) {}
+
+  Labeler(std::unique_ptr<FlatModel> model, const LabelerOptions& options)
+      : model_(std::move(model)), options_(options) {}
 
   Labeler(const Labeler&) = delete;
   Labeler& operator=(const Labeler&) = delete;
 
   // Apply the model to generate the labels.
   // Invalid inputs will result in an error status.
+  //
+  // If enable_debug_trace is set in @input, the path of the event through the
+  // model is set to serialized_debug_trace of @output, in a compact binary
+  // format. Use RenderDebugTrace to get the human readable trace.
   absl::Status Label(const LabelerInput& input, LabelerOutput& output) const;
 
   // Apply the model with a specific labeling mode.
@@ -110,8 +154,91 @@ class Labeler {
   absl::Status Label(const LabelerInput& input, LabelerOutput& output,
                      LabelingMode mode) const;
 
+  // Apply the model with a specific labeling mode, allocating the LabelerEvent
+  // and all the events cloned by multiplicity on @arena.
+  //
+  // The caller owns @arena and controls its lifetime, e.g. by resetting it
+  // after each event or after each batch of events. The memory used for this
+  // event is only released when @arena is reset or destroyed. @output can be
+  // allocated on any arena, or on the heap.
+  //
+  // If @arena is null, this is the same as Label(input, output, mode).
+  absl::Status Label(const LabelerInput& input, LabelerOutput& output,
+                     LabelingMode mode, google::protobuf::Arena* arena) const;
+
+  // Apply the model to generate the labels, taking the ownership of @input.
+  //
+  // Same as Label(const LabelerInput&, LabelerOutput&), but @input is swapped
+  // into the LabelerEvent instead of being copied. @input is left in a valid
+  // but unspecified state.
+  absl::Status Label(LabelerInput&& input, LabelerOutput& output) const;
+
+  // Apply the model with a specific labeling mode, taking the ownership of
+  // @input.
+  absl::Status Label(LabelerInput&& input, LabelerOutput& output,
+                     LabelingMode mode) const;
+
+  // Renders the serialized_debug_trace of a LabelerOutput as human readable
+  // text, with one line for each node applied, branch selected, row and column
+  // selected by attributes updaters, and multiplicity clone count.
+  static absl::StatusOr<std::string> RenderDebugTrace(
+      absl::string_view serialized_debug_trace);
+
+  // Apply the model to each entry of @inputs, and write the labels to the
+  // entry of @outputs at the same position.
+  //
+  // The LabelerEvents and the events cloned by multiplicity are allocated on
+  // an arena owned by the batch, which is reset between events, so that the
+  // memory allocated when labeling one event is reused when labeling the next
+  // one.
+  //
+  // Returns error status if @inputs and @outputs have different sizes, or when
+  // labeling any of @inputs fails. Labeling stops at the first failure, and
+  // only the outputs before the failed input are populated.
+  absl::Status LabelBatch(absl::Span<const LabelerInput> inputs,
+                          absl::Span<LabelerOutput> outputs) const;
+
+  // Apply the model to a batch of inputs with a specific labeling mode.
+  absl::Status LabelBatch(absl::Span<const LabelerInput> inputs,
+                          absl::Span<LabelerOutput> outputs,
+                          LabelingMode mode) const;
+
+  // Apply the model to a batch of inputs with a specific labeling mode,
+  // allocating all the LabelerEvents on @arena.
+  //
+  // @arena is never reset by the Labeler, so the memory used by the whole
+  // batch is only released when the caller resets or destroys @arena.
+  //
+  // If @arena is null, this is the same as LabelBatch(inputs, outputs, mode).
+  absl::Status LabelBatch(absl::Span<const LabelerInput> inputs,
+                          absl::Span<LabelerOutput> outputs, LabelingMode mode,
+                          google::protobuf::Arena* arena) const;
+
+  // Returns the execution statistics of each model node, for all the events
+  // labeled so far by all the threads. The nodes are in depth first pre-order,
+  // with the root node first.
+  //
+  // Returns error status if stats is not enabled in the LabelerOptions.
+  absl::StatusOr<ModelStats> GetStats() const;
+
  private:
-  std::unique_ptr<ModelNode> root_;
+  // Labels @input using @event as the working LabelerEvent. @event must be
+  // empty when this is called.
+  absl::Status LabelEvent(const LabelerInput& input, LabelingMode mode,
+                          LabelerEvent& event, LabelerOutput& output) const;
+
+  // Same as above, but @input is swapped into @event.
+  absl::Status LabelEvent(LabelerInput&& input, LabelingMode mode,
+                          LabelerEvent& event, LabelerOutput& output) const;
+
+  // Applies the model to @event, which has labeler_input set, and moves the
+  // labels to @output.
+  absl::Status ApplyModel(LabelingMode mode, LabelerEvent& event,
+                          LabelerOutput& output) const;
+
+  // The model tree, flattened when the Labeler is built.
+  std::unique_ptr<FlatModel> model_;
+  LabelerOptions options_;
 };
 
 }  // namespace wfa_virtual_people
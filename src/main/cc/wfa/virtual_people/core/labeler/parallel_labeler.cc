@@ -0,0 +1,258 @@
+// Copyright 2026 The Cross-Media Measurement Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "wfa/virtual_people/core/labeler/parallel_labeler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "google/protobuf/arena.h"
+#include "wfa/virtual_people/common/event.pb.h"
+#include "wfa/virtual_people/common/label.pb.h"
+#include "wfa/virtual_people/core/labeler/labeler.h"
+
+namespace wfa_virtual_people {
+
+// Each worker gets about this number of chunks per batch, so that there are
+// chunks left to steal when the workers progress at different speeds.
+constexpr size_t kChunksPerWorker = 8;
+
+// The upper bound of the chunk size. Larger chunks reduce the overhead of
+// taking chunks, but make the load less balanced at the end of the batch.
+constexpr size_t kMaxChunkSize = 1024;
+
+// The size of the initial block of the arena of each worker. The initial block
+// is kept when the arena is reset after each event.
+constexpr size_t kWorkerArenaInitialBlockSize = 64 * 1024;
+
+double ParallelLabeler::WorkerStats::EventsPerSecond() const {
+  double seconds = absl::ToDoubleSeconds(busy_time);
+  if (seconds <= 0) {
+    return 0;
+  }
+  return labeled_events / seconds;
+}
+
+absl::StatusOr<std::unique_ptr<ParallelLabeler>> ParallelLabeler::Build(
+    std::unique_ptr<Labeler> labeler, int num_threads) {
+  if (!labeler) {
+    return absl::InvalidArgumentError("The labeler must not be null.");
+  }
+  if (num_threads <= 0) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "The number of threads must be positive, got ", num_threads));
+  }
+  return absl::make_unique<ParallelLabeler>(std::move(labeler), num_threads);
+}
+
+ParallelLabeler::ParallelLabeler(std::unique_ptr<Labeler> labeler,
+                                 int num_threads)
+    : labeler_(std::move(labeler)), workers_(num_threads) {
+  threads_.reserve(num_threads);
+  for (size_t i = 0; i < workers_.size(); ++i) {
+    threads_.emplace_back(&ParallelLabeler::WorkerLoop, this, i);
+  }
+}
+
+ParallelLabeler::~ParallelLabeler() {
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    shutdown_ = true;
+  }
+  batch_ready_.notify_all();
+  for (std::thread& thread : threads_) {
+    thread.join();
+  }
+}
+
+absl::Status ParallelLabeler::LabelBatch(absl::Span<const LabelerInput> inputs,
+                                         absl::Span<LabelerOutput> outputs) {
+  return LabelBatch(inputs, outputs, LabelingMode::kFull);
+}
+
+absl::Status ParallelLabeler::LabelBatch(absl::Span<const LabelerInput> inputs,
+                                         absl::Span<LabelerOutput> outputs,
+                                         LabelingMode mode) {
+  if (inputs.size() != outputs.size()) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("The sizes of inputs and outputs are different: ",
+                     inputs.size(), " vs ", outputs.size()));
+  }
+  if (inputs.empty()) {
+    return absl::OkStatus();
+  }
+
+  std::lock_guard<std::mutex> batch_lock(batch_mtx_);
+
+  // Split the batch into chunks, and assign a contiguous range of chunks to
+  // each worker.
+  size_t worker_count = workers_.size();
+  size_t chunk_size = (inputs.size() + worker_count * kChunksPerWorker - 1) /
+                      (worker_count * kChunksPerWorker);
+  chunk_size = std::clamp<size_t>(chunk_size, 1, kMaxChunkSize);
+  size_t chunk_count = (inputs.size() + chunk_size - 1) / chunk_size;
+  for (size_t i = 0; i < worker_count; ++i) {
+    std::lock_guard<std::mutex> lock(workers_[i].mtx);
+    workers_[i].next_chunk = chunk_count * i / worker_count;
+    workers_[i].end_chunk = chunk_count * (i + 1) / worker_count;
+  }
+
+  batch_.inputs = inputs;
+  batch_.outputs = outputs;
+  batch_.mode = mode;
+  batch_.chunk_size = chunk_size;
+  batch_.first_failed_chunk.store(std::numeric_limits<size_t>::max(),
+                                  std::memory_order_relaxed);
+  batch_.status = absl::OkStatus();
+
+  // Wake up the workers, and wait for all of them to finish.
+  {
+    std::unique_lock<std::mutex> lock(mtx_);
+    ++batch_generation_;
+    running_workers_ = worker_count;
+    batch_ready_.notify_all();
+    batch_done_.wait(lock, [this] { return running_workers_ == 0; });
+  }
+
+  std::lock_guard<std::mutex> failure_lock(batch_.failure_mtx);
+  return batch_.status;
+}
+
+std::vector<ParallelLabeler::WorkerStats> ParallelLabeler::GetWorkerStats()
+    const {
+  std::lock_guard<std::mutex> batch_lock(batch_mtx_);
+  std::vector<WorkerStats> stats;
+  stats.reserve(workers_.size());
+  for (const Worker& worker : workers_) {
+    stats.push_back(worker.stats);
+  }
+  return stats;
+}
+
+void ParallelLabeler::WorkerLoop(size_t worker_index) {
+  uint64_t seen_generation = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mtx_);
+      batch_ready_.wait(lock, [this, seen_generation] {
+        return shutdown_ || batch_generation_ != seen_generation;
+      });
+      if (shutdown_) {
+        return;
+      }
+      seen_generation = batch_generation_;
+    }
+
+    LabelChunks(worker_index);
+
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      if (--running_workers_ == 0) {
+        batch_done_.notify_one();
+      }
+    }
+  }
+}
+
+void ParallelLabeler::LabelChunks(size_t worker_index) {
+  WorkerStats& stats = workers_[worker_index].stats;
+
+  // Each event is labeled on the arena of the worker, which is reset after each
+  // event, so that labeling does not allocate memory in the common case.
+  auto initial_block = absl::make_unique<char[]>(kWorkerArenaInitialBlockSize);
+  google::protobuf::Arena arena(initial_block.get(),
+                                kWorkerArenaInitialBlockSize);
+
+  size_t chunk = 0;
+  bool stolen = false;
+  while (NextChunk(worker_index, chunk, stolen)) {
+    if (chunk > batch_.first_failed_chunk.load(std::memory_order_relaxed)) {
+      // The result of this chunk is not used.
+      continue;
+    }
+    size_t begin = chunk * batch_.chunk_size;
+    size_t end = std::min(begin + batch_.chunk_size, batch_.inputs.size());
+
+    absl::Time start_time = absl::Now();
+    for (size_t i = begin; i < end; ++i) {
+      absl::Status status = labeler_->Label(
+          batch_.inputs[i], batch_.outputs[i], batch_.mode, &arena);
+      arena.Reset();
+      if (!status.ok()) {
+        RecordFailure(chunk, i, status);
+        end = i + 1;
+        break;
+      }
+    }
+    stats.busy_time += absl::Now() - start_time;
+    stats.labeled_events += end - begin;
+    ++stats.labeled_chunks;
+    if (stolen) {
+      ++stats.stolen_chunks;
+    }
+  }
+}
+
+bool ParallelLabeler::NextChunk(size_t worker_index, size_t& chunk,
+                                bool& stolen) {
+  {
+    Worker& worker = workers_[worker_index];
+    std::lock_guard<std::mutex> lock(worker.mtx);
+    if (worker.next_chunk < worker.end_chunk) {
+      chunk = worker.next_chunk++;
+      stolen = false;
+      return true;
+    }
+  }
+  for (size_t i = 1; i < workers_.size(); ++i) {
+    Worker& victim = workers_[(worker_index + i) % workers_.size()];
+    std::lock_guard<std::mutex> lock(victim.mtx);
+    if (victim.next_chunk < victim.end_chunk) {
+      chunk = --victim.end_chunk;
+      stolen = true;
+      return true;
+    }
+  }
+  return false;
+}
+
+void ParallelLabeler::RecordFailure(size_t chunk, size_t input_index,
+                                    const absl::Status& status) {
+  std::lock_guard<std::mutex> lock(batch_.failure_mtx);
+  // Every chunk before the first failed chunk is always labeled, so the
+  // returned error does not depend on the scheduling.
+  if (chunk >= batch_.first_failed_chunk.load(std::memory_order_relaxed)) {
+    return;
+  }
+  batch_.first_failed_chunk.store(chunk, std::memory_order_relaxed);
+  batch_.status = absl::Status(
+      status.code(), absl::StrCat("Failed to label input at index ",
+                                  input_index, ": ", status.message()));
+}
+
+}  // namespace wfa_virtual_people
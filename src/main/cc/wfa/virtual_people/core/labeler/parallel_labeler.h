@@ -0,0 +1,166 @@
+// Copyright 2026 The Cross-Media Measurement Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_LABELER_PARALLEL_LABELER_H_
+#define SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_LABELER_PARALLEL_LABELER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "wfa/virtual_people/common/event.pb.h"
+#include "wfa/virtual_people/common/label.pb.h"
+#include "wfa/virtual_people/core/labeler/labeler.h"
+
+namespace wfa_virtual_people {
+
+// Labels batches of events on a pool of worker threads, all sharing the same
+// immutable Labeler.
+//
+// Each batch is split into chunks of consecutive inputs. Every worker starts
+// with a contiguous range of chunks, and takes chunks from the front of its own
+// range. A worker without chunks left steals from the back of the range of
+// another worker, so that slow events do not leave the other workers idle.
+// Each output is written at the same position as its input, so the result does
+// not depend on the scheduling.
+class ParallelLabeler {
+ public:
+  // Labeling statistics of a single worker thread, accumulated over all the
+  // batches labeled by the ParallelLabeler.
+  struct WorkerStats {
+    // The number of inputs labeled by the worker.
+    int64_t labeled_events = 0;
+    // The number of chunks labeled by the worker, including the stolen ones.
+    int64_t labeled_chunks = 0;
+    // The number of chunks the worker stole from other workers.
+    int64_t stolen_chunks = 0;
+    // The total time spent by the worker on labeling.
+    absl::Duration busy_time = absl::ZeroDuration();
+
+    // The number of inputs labeled per second of busy time.
+    double EventsPerSecond() const;
+  };
+
+  // Always use ParallelLabeler::Build to get a ParallelLabeler object.
+  // Users should never call the constructor directly.
+  //
+  // Starts @num_threads worker threads, which are used to label the batches
+  // with @labeler.
+  //
+  // Returns error status if @labeler is null or @num_threads is not positive.
+  static absl::StatusOr<std::unique_ptr<ParallelLabeler>> Build(
+      std::unique_ptr<Labeler> labeler, int num_threads);
+
+  ParallelLabeler(std::unique_ptr<Labeler> labeler, int num_threads);
+
+  // Stops and joins all the worker threads.
+  ~ParallelLabeler();
+
+  ParallelLabeler(const ParallelLabeler&) = delete;
+  ParallelLabeler& operator=(const ParallelLabeler&) = delete;
+
+  // Apply the model to each entry of @inputs, and write the labels to the
+  // entry of @outputs at the same position.
+  //
+  // Blocks until the whole batch is labeled. Concurrent calls are serialized.
+  //
+  // Returns error status if @inputs and @outputs have different sizes, or when
+  // labeling any of @inputs fails. When more than one input fails, the error of
+  // the first failed input is returned. The outputs of the inputs after the
+  // first failed input might not be populated.
+  absl::Status LabelBatch(absl::Span<const LabelerInput> inputs,
+                          absl::Span<LabelerOutput> outputs);
+
+  // Apply the model to a batch of inputs with a specific labeling mode.
+  absl::Status LabelBatch(absl::Span<const LabelerInput> inputs,
+                          absl::Span<LabelerOutput> outputs, LabelingMode mode);
+
+  // Returns the statistics of each worker thread, indexed by worker.
+  std::vector<WorkerStats> GetWorkerStats() const;
+
+  int num_threads() const { return static_cast<int>(workers_.size()); }
+
+  const Labeler& labeler() const { return *labeler_; }
+
+ private:
+  // The state owned by a single worker thread. Aligned to avoid false sharing
+  // between workers.
+  struct alignas(64) Worker {
+    // Guards the chunk range, which is also accessed by stealing workers.
+    std::mutex mtx;
+    // The chunks [next_chunk, end_chunk) are not labeled yet.
+    size_t next_chunk = 0;
+    size_t end_chunk = 0;
+    // Only accessed by the worker thread while a batch is running.
+    WorkerStats stats;
+  };
+
+  // The batch being labeled. Set before the workers are woken up, and not
+  // changed until all of them are done.
+  struct Batch {
+    absl::Span<const LabelerInput> inputs;
+    absl::Span<LabelerOutput> outputs;
+    LabelingMode mode = LabelingMode::kFull;
+    size_t chunk_size = 1;
+    // Chunks after the first failed chunk are skipped.
+    std::atomic<size_t> first_failed_chunk{0};
+    // The error of the first failed chunk. Guarded by failure_mtx.
+    std::mutex failure_mtx;
+    absl::Status status;
+  };
+
+  // Waits for batches and labels them, until the ParallelLabeler is
+  // destroyed.
+  void WorkerLoop(size_t worker_index);
+
+  // Labels chunks of the current batch until no chunk is left to label.
+  void LabelChunks(size_t worker_index);
+
+  // Gets the next chunk to be labeled by the worker of @worker_index, stealing
+  // from other workers if needed. Returns false when no chunk is left.
+  bool NextChunk(size_t worker_index, size_t& chunk, bool& stolen);
+
+  // Records the @status of the failed input at @input_index in @chunk.
+  void RecordFailure(size_t chunk, size_t input_index,
+                     const absl::Status& status);
+
+  std::unique_ptr<Labeler> labeler_;
+  std::vector<Worker> workers_;
+  std::vector<std::thread> threads_;
+
+  // Serializes LabelBatch calls, and GetWorkerStats with the batches.
+  mutable std::mutex batch_mtx_;
+  Batch batch_;
+
+  // Guards the fields below, which hand over batches to the workers.
+  std::mutex mtx_;
+  std::condition_variable batch_ready_;
+  std::condition_variable batch_done_;
+  uint64_t batch_generation_ = 0;
+  size_t running_workers_ = 0;
+  bool shutdown_ = false;
+};
+
+}  // namespace wfa_virtual_people
+
+#endif  // SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_LABELER_PARALLEL_LABELER_H_
@@ -22,6 +22,8 @@
 #include "absl/status/statusor.h"
 #include "wfa/virtual_people/common/model.pb.h"
 #include "wfa/virtual_people/core/model/model_node.h"
+#include "wfa/virtual_people/core/model/utils/predicate_cache.h"
+#include "wfa/virtual_people/core/model/utils/row_patch_pool.h"
 
 namespace wfa_virtual_people {
 
@@ -58,6 +60,20 @@ class AttributesUpdaterInterface {
   // 2. Merge the attributes into @event.
   virtual absl::Status Update(LabelerEvent& event) const = 0;
 
+  // Returns the top level fields of LabelerEvent that Update may write. The
+  // cached results of the predicates reading these fields are dropped after
+  // Update.
+  virtual EventFieldMask WrittenFields() const { return kAllEventFields; }
+
+  // Assigns ids to the conditions of the updater from @registry, so that their
+  // results are cached by the PredicateCache of the current thread.
+  virtual void RegisterPredicates(PredicateRegistry& registry) {}
+
+  // Replaces the rows merged by the updater with the equal rows in @pool, and
+  // adds the rows not in @pool to it, so that the equal rows of all the
+  // updaters in the model are stored once.
+  virtual void InternRows(RowPatchPool& pool) {}
+
  protected:
   AttributesUpdaterInterface() = default;
 };
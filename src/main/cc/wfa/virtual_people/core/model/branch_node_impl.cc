@@ -19,13 +19,14 @@
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/functional/function_ref.h"
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "common_cpp/macros/macros.h"
-#include "wfa/virtual_people/common/field_filter/utils/field_util.h"
+#include "google/protobuf/arena.h"
 #include "wfa/virtual_people/common/label.pb.h"
 #include "wfa/virtual_people/common/model.pb.h"
 #include "wfa/virtual_people/core/model/attributes_updater.h"
@@ -33,6 +34,8 @@
 #include "wfa/virtual_people/core/model/utils/constants.h"
 #include "wfa/virtual_people/core/model/utils/distributed_consistent_hashing.h"
 #include "wfa/virtual_people/core/model/utils/field_filters_matcher.h"
+#include "wfa/virtual_people/core/model/utils/path_trace.h"
+#include "wfa/virtual_people/core/model/utils/predicate_cache.h"
 
 namespace wfa_virtual_people {
 
@@ -106,16 +109,18 @@ BuildUpdaters(const BranchNode::AttributesUpdaters& attr_updaters) {
   return updaters;
 }
 
-// Clones @source_event and appends to @clones. The clone uses @fingerprint as
-// acting_fingerprint and sets @person_index in @person_index_field.
+// Clones @source_event on @arena and appends to @clones. The clone uses
+// @fingerprint as acting_fingerprint and sets @person_index in
+// @person_index_field.
 absl::Status CloneAndAppendEvent(
     const LabelerEvent& source_event, uint64_t fingerprint, int person_index,
-    const std::vector<const google::protobuf::FieldDescriptor*>&
-        person_index_field,
-    std::vector<LabelerEvent>& clones) {
-  clones.emplace_back(LabelerEvent(source_event));
-  clones.back().set_acting_fingerprint(fingerprint);
-  SetValueToProto(clones.back(), person_index_field, person_index);
+    const MultiplicityImpl& multiplicity, google::protobuf::Arena& arena,
+    std::vector<LabelerEvent*>& clones) {
+  LabelerEvent* clone = google::protobuf::Arena::Create<LabelerEvent>(&arena);
+  clone->CopyFrom(source_event);
+  clone->set_acting_fingerprint(fingerprint);
+  multiplicity.SetPersonIndex(*clone, person_index);
+  clones.push_back(clone);
 
   return absl::OkStatus();
 }
@@ -208,32 +213,57 @@ BranchNodeImpl::BranchNodeImpl(
       random_seed_(random_seed),
       matcher_(std::move(matcher)),
       updaters_(std::move(updaters)),
-      multiplicity_(std::move(multiplicity)) {}
+      multiplicity_(std::move(multiplicity)) {
+  for (const auto& updater : updaters_) {
+    updater_written_fields_.push_back(updater->WrittenFields());
+  }
+}
 
 absl::Status BranchNodeImpl::Apply(LabelerEvent& event) const {
+  TraceNode(name());
   if (multiplicity_ && !updaters_.empty()) {
     return absl::InternalError(
         "BranchNode cannot have both updaters and multiplicity.");
   }
 
   if (multiplicity_) {
-    return ApplyMultiplicity(event);
+    return ApplyMultiplicity(
+        event, [this](LabelerEvent& clone) { return ApplyChild(clone); });
+  }
+
+  RETURN_IF_ERROR(ApplyUpdaters(event));
+  return ApplyChild(event);
+}
+
+absl::Status BranchNodeImpl::ApplyUpdaters(LabelerEvent& event) const {
+  for (int i = 0; i < updaters_.size(); ++i) {
+    RETURN_IF_ERROR(updaters_[i]->Update(event));
+    InvalidatePredicates(event, updater_written_fields_[i]);
   }
+  return absl::OkStatus();
+}
 
-  // Applies attributes updaters.
+void BranchNodeImpl::RegisterPredicates(PredicateRegistry& registry) {
+  if (matcher_) {
+    matcher_->RegisterPredicates(registry);
+  }
   for (auto& updater : updaters_) {
-    RETURN_IF_ERROR(updater->Update(event));
+    updater->RegisterPredicates(registry);
   }
+}
 
-  return ApplyChild(event);
+void BranchNodeImpl::InternRows(RowPatchPool& pool) {
+  for (auto& updater : updaters_) {
+    updater->InternRows(pool);
+  }
 }
 
-absl::Status BranchNodeImpl::ApplyChild(LabelerEvent& event) const {
+absl::StatusOr<int> BranchNodeImpl::SelectChild(
+    const LabelerEvent& event) const {
   int selected_index = kNoMatchingIndex;
   if (hashing_) {
     // Select by chance.
-    selected_index =
-        hashing_->Hash(absl::StrCat(random_seed_, event.acting_fingerprint()));
+    selected_index = hashing_->Hash(random_seed_, event.acting_fingerprint());
   } else if (matcher_) {
     // Select by condition.
     selected_index = matcher_->GetFirstMatch(event);
@@ -250,10 +280,18 @@ absl::Status BranchNodeImpl::ApplyChild(LabelerEvent& event) const {
     return absl::InternalError("The returned index is out of range.");
   }
 
+  TraceBranch(selected_index);
+  return selected_index;
+}
+
+absl::Status BranchNodeImpl::ApplyChild(LabelerEvent& event) const {
+  ASSIGN_OR_RETURN(int selected_index, SelectChild(event));
   return child_nodes_[selected_index]->Apply(event);
 }
 
-absl::Status BranchNodeImpl::ApplyMultiplicity(LabelerEvent& event) const {
+absl::Status BranchNodeImpl::ApplyMultiplicity(
+    LabelerEvent& event,
+    absl::FunctionRef<absl::Status(LabelerEvent&)> apply_child) const {
   if (!multiplicity_) {
     return absl::InternalError(
         "ApplyMultiplicity is called with null multiplicity.");
@@ -261,41 +299,50 @@ absl::Status BranchNodeImpl::ApplyMultiplicity(LabelerEvent& event) const {
 
   ASSIGN_OR_RETURN(int clone_count,
                    multiplicity_->ComputeEventMultiplicity(event));
+  TraceMultiplicity(clone_count);
   if (clone_count == 1) {
     // Don't need to copy. Still need to set index.
-    int person_index = 0;
-    SetValueToProto(event, multiplicity_->PersonIndexFieldDescriptor(),
-                    person_index);
-    return ApplyChild(event);
+    multiplicity_->SetPersonIndex(event, /*person_index=*/0);
+    InvalidatePredicates(
+        event, GetEventFieldMask(multiplicity_->PersonIndexFieldDescriptor()));
+    return apply_child(event);
   }
 
-  // Clone events.
-  std::vector<LabelerEvent> clones;
-  const std::vector<const google::protobuf::FieldDescriptor*>&
-      person_index_field = multiplicity_->PersonIndexFieldDescriptor();
+  // Clone events. The clones are allocated on the arena of @event when there is
+  // one, so that they are released together with @event. Otherwise they are
+  // allocated on a local arena, which releases all of them at once when
+  // returning, rather than destroying each clone field by field.
+  google::protobuf::Arena local_arena;
+  google::protobuf::Arena* arena = event.GetArena();
+  if (arena == nullptr) {
+    arena = &local_arena;
+  }
+  std::vector<LabelerEvent*> clones;
+  clones.reserve(clone_count);
   uint64_t original_fingerprint = event.acting_fingerprint();
   for (int i = 0; i < clone_count; ++i) {
     uint64_t clone_fingerprint =
         multiplicity_->GetFingerprintForIndex(original_fingerprint, i);
     RETURN_IF_ERROR(CloneAndAppendEvent(event, clone_fingerprint, i,
-                                        person_index_field, clones));
+                                        *multiplicity_, *arena, clones));
   }
 
   // Apply child to each clone.
-  for (LabelerEvent& clone : clones) {
-    RETURN_IF_ERROR(ApplyChild(clone));
+  for (LabelerEvent* clone : clones) {
+    RETURN_IF_ERROR(apply_child(*clone));
   }
 
-  // Merge labels.
-  for (const LabelerEvent& clone : clones) {
-    for (const auto& person : clone.virtual_person_activities()) {
-      *(event.add_virtual_person_activities()) = person;
+  // Merge labels. The clones are not used after merging, so the labels are
+  // moved, which is a swap when @event and the clones share the arena.
+  for (LabelerEvent* clone : clones) {
+    for (auto& person : *clone->mutable_virtual_person_activities()) {
+      *(event.add_virtual_person_activities()) = std::move(person);
     }
     // Fold back pool assignments too. In pool-identity (pass-1) mode, leaf
     // nodes emit pool assignments instead of virtual person activities; without
     // this, assignments from cloned multiplicity events would be dropped.
-    for (const auto& pool_assignment : clone.pool_assignments()) {
-      *(event.add_pool_assignments()) = pool_assignment;
+    for (auto& pool_assignment : *clone->mutable_pool_assignments()) {
+      *(event.add_pool_assignments()) = std::move(pool_assignment);
     }
   }
 
@@ -20,6 +20,7 @@
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/functional/function_ref.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
@@ -30,13 +31,15 @@
 #include "wfa/virtual_people/core/model/multiplicity_impl.h"
 #include "wfa/virtual_people/core/model/utils/distributed_consistent_hashing.h"
 #include "wfa/virtual_people/core/model/utils/field_filters_matcher.h"
+#include "wfa/virtual_people/core/model/utils/predicate_cache.h"
+#include "wfa/virtual_people/core/model/utils/row_patch_pool.h"
 
 namespace wfa_virtual_people {
 
 // The implementation of the CompiledNode with branch_node set.
 //
 // The field branch_node in @node_config must be set.
-class BranchNodeImpl : public ModelNode {
+class BranchNodeImpl final : public ModelNode {
  public:
   // Always use ModelNode::Build to get a ModelNode object.
   // Users should never call the factory function or constructor of the derived
@@ -82,16 +85,43 @@ class BranchNodeImpl : public ModelNode {
   //   then merge labeling outputs.
   absl::Status Apply(LabelerEvent& event) const override;
 
- private:
-  // Uses @hashing_ or @matcher_ to select one of @child_nodes_, and apply
-  // the selected node to @event.
-  absl::Status ApplyChild(LabelerEvent& event) const;
+  // The steps of Apply, used by FlatModel to apply the child nodes without
+  // recursing into them through Apply.
+
+  // Uses @hashing_ or @matcher_ to select one of @child_nodes_ for @event.
+  // Returns the index of the selected child node.
+  absl::StatusOr<int> SelectChild(const LabelerEvent& event) const;
+
+  // Applies @updaters_ to @event in order.
+  absl::Status ApplyUpdaters(LabelerEvent& event) const;
 
   // Steps:
   // 1. Compute multiplicity for @event, clone the event accordingly.
-  // 2. Apply child node to each clone.
+  // 2. Call @apply_child for each clone.
   // 3. Merge the labeling outputs.
-  absl::Status ApplyMultiplicity(LabelerEvent& event) const;
+  absl::Status ApplyMultiplicity(
+      LabelerEvent& event,
+      absl::FunctionRef<absl::Status(LabelerEvent&)> apply_child) const;
+
+  bool has_multiplicity() const { return multiplicity_ != nullptr; }
+
+  // Assigns ids to the conditions of @matcher_ and @updaters_ from @registry,
+  // so that their results are cached by the PredicateCache of the current
+  // thread. Does not recurse into the child nodes.
+  void RegisterPredicates(PredicateRegistry& registry);
+
+  // Interns the rows merged by @updaters_ in @pool. Does not recurse into the
+  // child nodes.
+  void InternRows(RowPatchPool& pool);
+
+  const std::vector<std::unique_ptr<ModelNode>>& child_nodes() const {
+    return child_nodes_;
+  }
+
+ private:
+  // Uses @hashing_ or @matcher_ to select one of @child_nodes_, and apply
+  // the selected node to @event.
+  absl::Status ApplyChild(LabelerEvent& event) const;
 
   // Include the child nodes in all the branches, in the same order as the
   // branches in @node_config.
@@ -111,6 +141,8 @@ class BranchNodeImpl : public ModelNode {
   // When calling Apply, entries of @updaters_ is applied to the event in order.
   // Each entry of @updaters_ updates the value of some fields in the event.
   std::vector<std::unique_ptr<AttributesUpdaterInterface>> updaters_;
+  // The fields written by each entry of @updaters_.
+  std::vector<EventFieldMask> updater_written_fields_;
 
   // If multiplicity is set in @node_config, multiplicity_ is set.
   // When calling Apply, call ApplyMultiplicity.
@@ -26,51 +26,33 @@
 #include "common_cpp/macros/macros.h"
 #include "google/protobuf/descriptor.h"
 #include "wfa/virtual_people/common/field_filter/field_filter.h"
-#include "wfa/virtual_people/common/field_filter/utils/field_util.h"
 #include "wfa/virtual_people/common/model.pb.h"
 #include "wfa/virtual_people/core/model/attributes_updater.h"
+#include "wfa/virtual_people/core/model/utils/field_accessor.h"
+#include "wfa/virtual_people/core/model/utils/predicate_cache.h"
 
 namespace wfa_virtual_people {
 
-template <typename ValueType, EnableIfProtoValueType<ValueType> = true>
-void Assign(
-    LabelerEvent& event,
-    const std::vector<const google::protobuf::FieldDescriptor*>& source,
-    const std::vector<const google::protobuf::FieldDescriptor*>& target) {
-  ProtoFieldValue<ValueType> field_value =
-      GetValueFromProto<ValueType>(event, source);
-  if (!field_value.is_set) {
-    return;
-  }
-  SetValueToProto<ValueType>(event, target, field_value.value);
-}
+namespace {
 
-absl::StatusOr<std::function<void(
-    LabelerEvent&, const std::vector<const google::protobuf::FieldDescriptor*>&,
-    const std::vector<const google::protobuf::FieldDescriptor*>&)>>
-GetAssignmentFunction(
-    const google::protobuf::FieldDescriptor::CppType cpp_type) {
+// Returns whether ConditionalAssignment supports fields of @cpp_type.
+bool IsSupportedType(google::protobuf::FieldDescriptor::CppType cpp_type) {
   switch (cpp_type) {
     case google::protobuf::FieldDescriptor::CppType::CPPTYPE_INT32:
-      return Assign<int32_t>;
     case google::protobuf::FieldDescriptor::CppType::CPPTYPE_INT64:
-      return Assign<int64_t>;
     case google::protobuf::FieldDescriptor::CppType::CPPTYPE_UINT32:
-      return Assign<uint32_t>;
     case google::protobuf::FieldDescriptor::CppType::CPPTYPE_UINT64:
-      return Assign<uint64_t>;
     case google::protobuf::FieldDescriptor::CppType::CPPTYPE_BOOL:
-      return Assign<bool>;
     case google::protobuf::FieldDescriptor::CppType::CPPTYPE_ENUM:
-      return Assign<const google::protobuf::EnumValueDescriptor*>;
     case google::protobuf::FieldDescriptor::CppType::CPPTYPE_STRING:
-      return Assign<const std::string&>;
+      return true;
     default:
-      return absl::InvalidArgumentError(
-          "Unsupported field type for ConditionalAssignment.");
+      return false;
   }
 }
 
+}  // namespace
+
 absl::StatusOr<std::unique_ptr<ConditionalAssignmentImpl>>
 ConditionalAssignmentImpl::Build(const ConditionalAssignment& config) {
   if (!config.has_condition()) {
@@ -108,40 +90,56 @@ ConditionalAssignmentImpl::Build(const ConditionalAssignment& config) {
                        config.DebugString()));
     }
 
-    ConditionalAssignmentImpl::Assignment& assignment =
-        assignments.emplace_back();
-
-    ASSIGN_OR_RETURN(assignment.source,
-                     GetFieldFromProto(LabelerEvent().GetDescriptor(),
-                                       assignment_config.source_field()));
-    ASSIGN_OR_RETURN(assignment.target,
-                     GetFieldFromProto(LabelerEvent().GetDescriptor(),
-                                       assignment_config.target_field()));
-    if (assignment.source.back()->cpp_type() !=
-        assignment.target.back()->cpp_type()) {
+    ASSIGN_OR_RETURN(FieldAccessor source,
+                     FieldAccessor::Build(assignment_config.source_field()));
+    ASSIGN_OR_RETURN(FieldAccessor target,
+                     FieldAccessor::Build(assignment_config.target_field()));
+    if (source.cpp_type() != target.cpp_type()) {
       return absl::InvalidArgumentError(absl::StrCat(
           "All assignments must have source_field and target_field being the "
           "same type in ConditionalAssignment: ",
           config.DebugString()));
     }
+    if (!IsSupportedType(source.cpp_type())) {
+      return absl::InvalidArgumentError(
+          "Unsupported field type for ConditionalAssignment.");
+    }
 
-    ASSIGN_OR_RETURN(
-        assignment.assign,
-        GetAssignmentFunction(assignment.source.back()->cpp_type()));
+    assignments.push_back({std::move(source), std::move(target)});
   }
 
-  return absl::make_unique<ConditionalAssignmentImpl>(std::move(condition),
-                                                      std::move(assignments));
+  auto conditional_assignment = absl::make_unique<ConditionalAssignmentImpl>(
+      std::move(condition), std::move(assignments));
+  conditional_assignment->condition_config_ =
+      MakePredicateConfig(config.condition());
+  return conditional_assignment;
 }
 
 absl::Status ConditionalAssignmentImpl::Update(LabelerEvent& event) const {
-  if (condition_->IsMatch(event)) {
+  if (MatchPredicate(condition_id_, *condition_, event)) {
     for (const ConditionalAssignmentImpl::Assignment& assignment :
          assignments_) {
-      assignment.assign(event, assignment.source, assignment.target);
+      assignment.source.CopyTo(assignment.target, event);
     }
   }
   return absl::OkStatus();
 }
 
+EventFieldMask ConditionalAssignmentImpl::WrittenFields() const {
+  EventFieldMask written_fields = 0;
+  for (const ConditionalAssignmentImpl::Assignment& assignment :
+       assignments_) {
+    written_fields |= GetEventFieldMask(assignment.target.path());
+  }
+  return written_fields;
+}
+
+void ConditionalAssignmentImpl::RegisterPredicates(
+    PredicateRegistry& registry) {
+  if (condition_id_ == kNoPredicateId) {
+    condition_id_ = registry.Register(condition_config_);
+    condition_config_ = PredicateConfig();
+  }
+}
+
 }  // namespace wfa_virtual_people
@@ -21,10 +21,11 @@
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
-#include "google/protobuf/descriptor.h"
 #include "wfa/virtual_people/common/field_filter/field_filter.h"
 #include "wfa/virtual_people/common/model.pb.h"
 #include "wfa/virtual_people/core/model/attributes_updater.h"
+#include "wfa/virtual_people/core/model/utils/field_accessor.h"
+#include "wfa/virtual_people/core/model/utils/predicate_cache.h"
 
 namespace wfa_virtual_people {
 
@@ -47,13 +48,8 @@ class ConditionalAssignmentImpl : public AttributesUpdaterInterface {
       const ConditionalAssignment& config);
 
   struct Assignment {
-    std::vector<const google::protobuf::FieldDescriptor*> source;
-    std::vector<const google::protobuf::FieldDescriptor*> target;
-    std::function<void(
-        LabelerEvent&,
-        const std::vector<const google::protobuf::FieldDescriptor*>&,
-        const std::vector<const google::protobuf::FieldDescriptor*>&)>
-        assign;
+    FieldAccessor source;
+    FieldAccessor target;
   };
 
   explicit ConditionalAssignmentImpl(std::unique_ptr<FieldFilter> condition,
@@ -70,9 +66,17 @@ class ConditionalAssignmentImpl : public AttributesUpdaterInterface {
   // If condition_ is not matched, does nothing and returns OK status.
   absl::Status Update(LabelerEvent& event) const override;
 
+  EventFieldMask WrittenFields() const override;
+
+  void RegisterPredicates(PredicateRegistry& registry) override;
+
  private:
   // Applies the assignments if condition_ is matched.
   std::unique_ptr<FieldFilter> condition_;
+  // The config of condition_ until it is registered.
+  PredicateConfig condition_config_;
+  // The id of condition_ in the PredicateRegistry, if registered.
+  int condition_id_ = kNoPredicateId;
   // Each entry in assignments_ contains a source field and a target field.
   std::vector<Assignment> assignments_;
 };
@@ -14,6 +14,7 @@
 
 #include "wfa/virtual_people/core/model/conditional_merge_impl.h"
 
+#include <cstdint>
 #include <memory>
 #include <utility>
 #include <vector>
@@ -22,10 +23,14 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "common_cpp/macros/macros.h"
-#include "wfa/virtual_people/common/field_filter/field_filter.h"
+#include "wfa/virtual_people/common/field_filter.pb.h"
 #include "wfa/virtual_people/common/model.pb.h"
 #include "wfa/virtual_people/core/model/utils/constants.h"
 #include "wfa/virtual_people/core/model/utils/field_filters_matcher.h"
+#include "wfa/virtual_people/core/model/utils/path_trace.h"
+#include "wfa/virtual_people/core/model/utils/predicate_cache.h"
+#include "wfa/virtual_people/core/model/utils/row_patch.h"
+#include "wfa/virtual_people/core/model/utils/row_patch_pool.h"
 
 namespace wfa_virtual_people {
 
@@ -36,11 +41,11 @@ ConditionalMergeImpl::Build(const ConditionalMerge& config) {
         absl::StrCat("No nodes in ConditionalMerge: ", config.DebugString()));
   }
 
-  // Converts each condition to a FieldFilter, and builds a FieldFiltersMatcher
-  // with all the FieldFilters.
-  std::vector<std::unique_ptr<FieldFilter>> filters;
-  // Gets all the updates.
-  std::vector<LabelerEvent> updates;
+  // Builds a FieldFiltersMatcher with all the conditions.
+  std::vector<const FieldFilterProto*> conditions;
+  // Gets all the updates. Equal updates are compiled once.
+  RowPatchPool pool;
+  std::vector<std::shared_ptr<const RowPatch>> updates;
   for (const ConditionalMerge::ConditionalMergeNode& node : config.nodes()) {
     if (!node.has_condition()) {
       return absl::InvalidArgumentError(
@@ -52,18 +57,12 @@ ConditionalMergeImpl::Build(const ConditionalMerge& config) {
           "No update in the node in ConditionalMerge: ", node.DebugString()));
     }
 
-    ASSIGN_OR_RETURN(
-        filters.emplace_back(),
-        FieldFilter::New(LabelerEvent().GetDescriptor(), node.condition()));
-
-    if (!filters.back()) {
-      return absl::InternalError("FieldFilter::New should never return NULL.");
-    }
-
-    updates.emplace_back(node.update());
+    conditions.push_back(&node.condition());
+    ASSIGN_OR_RETURN(int32_t update_id, pool.Add(node.update()));
+    updates.push_back(pool.patches()[update_id]);
   }
   ASSIGN_OR_RETURN(std::unique_ptr<FieldFiltersMatcher> matcher,
-                   FieldFiltersMatcher::Build(std::move(filters)));
+                   FieldFiltersMatcher::Build(conditions));
 
   if (!matcher) {
     return absl::InternalError(
@@ -80,6 +79,8 @@ ConditionalMergeImpl::Build(const ConditionalMerge& config) {
 
 absl::Status ConditionalMergeImpl::Update(LabelerEvent& event) const {
   int index = matcher_->GetFirstMatch(event);
+  // The matched node is recorded as the row.
+  TraceUpdate(index, kNoMatchingIndex);
   if (index == kNoMatchingIndex) {
     if (pass_through_non_matches_ == PassThroughNonMatches::kYes) {
       return absl::OkStatus();
@@ -94,8 +95,26 @@ absl::Status ConditionalMergeImpl::Update(LabelerEvent& event) const {
     return absl::InternalError("The returned index is out of range.");
   }
 
-  event.MergeFrom(updates_[index]);
+  updates_[index]->Apply(event);
   return absl::OkStatus();
 }
 
+EventFieldMask ConditionalMergeImpl::WrittenFields() const {
+  EventFieldMask written_fields = 0;
+  for (const std::shared_ptr<const RowPatch>& update : updates_) {
+    written_fields |= GetSetEventFields(update->row());
+  }
+  return written_fields;
+}
+
+void ConditionalMergeImpl::RegisterPredicates(PredicateRegistry& registry) {
+  matcher_->RegisterPredicates(registry);
+}
+
+void ConditionalMergeImpl::InternRows(RowPatchPool& pool) {
+  for (std::shared_ptr<const RowPatch>& update : updates_) {
+    update = pool.Intern(std::move(update));
+  }
+}
+
 }  // namespace wfa_virtual_people
@@ -24,6 +24,9 @@
 #include "wfa/virtual_people/common/model.pb.h"
 #include "wfa/virtual_people/core/model/attributes_updater.h"
 #include "wfa/virtual_people/core/model/utils/field_filters_matcher.h"
+#include "wfa/virtual_people/core/model/utils/predicate_cache.h"
+#include "wfa/virtual_people/core/model/utils/row_patch.h"
+#include "wfa/virtual_people/core/model/utils/row_patch_pool.h"
 
 namespace wfa_virtual_people {
 
@@ -44,9 +47,10 @@ class ConditionalMergeImpl : public AttributesUpdaterInterface {
 
   enum class PassThroughNonMatches { kNo, kYes };
 
-  explicit ConditionalMergeImpl(std::unique_ptr<FieldFiltersMatcher> matcher,
-                                std::vector<LabelerEvent>&& updates,
-                                PassThroughNonMatches pass_through_non_matches)
+  explicit ConditionalMergeImpl(
+      std::unique_ptr<FieldFiltersMatcher> matcher,
+      std::vector<std::shared_ptr<const RowPatch>>&& updates,
+      PassThroughNonMatches pass_through_non_matches)
       : matcher_(std::move(matcher)),
         updates_(std::move(updates)),
         pass_through_non_matches_(pass_through_non_matches) {}
@@ -62,11 +66,18 @@ class ConditionalMergeImpl : public AttributesUpdaterInterface {
   // pass_through_non_matches_ is kNo.
   absl::Status Update(LabelerEvent& event) const override;
 
+  EventFieldMask WrittenFields() const override;
+
+  void RegisterPredicates(PredicateRegistry& registry) override;
+
+  void InternRows(RowPatchPool& pool) override;
+
  private:
   // The matcher used to match input events to the conditions.
   std::unique_ptr<FieldFiltersMatcher> matcher_;
-  // The selected update will be merged to the input event.
-  std::vector<LabelerEvent> updates_;
+  // The selected update will be merged to the input event. Equal updates share
+  // the same patch.
+  std::vector<std::shared_ptr<const RowPatch>> updates_;
   // When calling Update, if no condition matches, returns OkStatus if
   // pass_through_non_matches_ is kYes, otherwise returns error status.
   PassThroughNonMatches pass_through_non_matches_;
@@ -0,0 +1,299 @@
+// Copyright 2026 The Cross-Media Measurement Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "wfa/virtual_people/core/model/flat_model.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "common_cpp/macros/macros.h"
+#include "wfa/virtual_people/common/label.pb.h"
+#include "wfa/virtual_people/common/model.pb.h"
+#include "wfa/virtual_people/core/model/branch_node_impl.h"
+#include "wfa/virtual_people/core/model/model_node.h"
+#include "wfa/virtual_people/core/model/model_stats.h"
+#include "wfa/virtual_people/core/model/population_node_impl.h"
+#include "wfa/virtual_people/core/model/ranked_population_node_impl.h"
+#include "wfa/virtual_people/core/model/stop_node_impl.h"
+#include "wfa/virtual_people/core/model/utils/path_trace.h"
+#include "wfa/virtual_people/core/model/utils/population_node_helper.h"
+#include "wfa/virtual_people/core/model/utils/predicate_cache.h"
+#include "wfa/virtual_people/core/model/utils/row_patch.h"
+#include "wfa/virtual_people/core/model/utils/row_patch_pool.h"
+
+namespace wfa_virtual_people {
+
+namespace {
+
+absl::StatusOr<FlatModel::NodeKind> GetNodeKind(const ModelNode& node) {
+  if (dynamic_cast<const BranchNodeImpl*>(&node)) {
+    return FlatModel::NodeKind::kBranch;
+  }
+  if (dynamic_cast<const PopulationNodeImpl*>(&node)) {
+    return FlatModel::NodeKind::kPopulation;
+  }
+  if (dynamic_cast<const RankedPopulationNodeImpl*>(&node)) {
+    return FlatModel::NodeKind::kRankedPopulation;
+  }
+  if (dynamic_cast<const StopNodeImpl*>(&node)) {
+    return FlatModel::NodeKind::kStop;
+  }
+  return absl::InvalidArgumentError("Unknown model node type.");
+}
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<FlatModel>> FlatModel::Build(
+    std::unique_ptr<ModelNode> root) {
+  return Build(std::move(root), ModelStatsOptions());
+}
+
+absl::StatusOr<std::unique_ptr<FlatModel>> FlatModel::Build(
+    std::unique_ptr<ModelNode> root, const ModelStatsOptions& stats_options) {
+  if (!root) {
+    return absl::InvalidArgumentError("The root node must not be null.");
+  }
+
+  std::vector<Node> nodes;
+  std::vector<uint32_t> child_indexes;
+  auto predicate_registry = absl::make_unique<PredicateRegistry>();
+  // Only used while building. The interned rows are owned by the updaters.
+  RowPatchPool row_pool;
+  std::vector<PopulationNodeImpl*> population_nodes;
+  std::vector<RankedPopulationNodeImpl*> ranked_population_nodes;
+
+  // Depth first traversal with an explicit stack, so that deep models do not
+  // overflow the call stack. Each entry is a node, and the position in
+  // @child_indexes to write its index to, if it is a child node.
+  struct PendingNode {
+    ModelNode* node;
+    size_t child_slot;
+  };
+  constexpr size_t kNoChildSlot = static_cast<size_t>(-1);
+  std::vector<PendingNode> stack = {{root.get(), kNoChildSlot}};
+  while (!stack.empty()) {
+    PendingNode pending = stack.back();
+    stack.pop_back();
+
+    uint32_t node_index = static_cast<uint32_t>(nodes.size());
+    if (pending.child_slot != kNoChildSlot) {
+      child_indexes[pending.child_slot] = node_index;
+    }
+    ASSIGN_OR_RETURN(NodeKind kind, GetNodeKind(*pending.node));
+    nodes.push_back({kind, 0, pending.node});
+    if (kind == NodeKind::kPopulation) {
+      population_nodes.push_back(
+          static_cast<PopulationNodeImpl*>(pending.node));
+    } else if (kind == NodeKind::kRankedPopulation) {
+      ranked_population_nodes.push_back(
+          static_cast<RankedPopulationNodeImpl*>(pending.node));
+    }
+    if (kind != NodeKind::kBranch) {
+      continue;
+    }
+
+    auto* branch = static_cast<BranchNodeImpl*>(pending.node);
+    branch->RegisterPredicates(*predicate_registry);
+    branch->InternRows(row_pool);
+    const std::vector<std::unique_ptr<ModelNode>>& child_nodes =
+        branch->child_nodes();
+    size_t first_child = child_indexes.size();
+    nodes.back().first_child = static_cast<uint32_t>(first_child);
+    child_indexes.resize(first_child + child_nodes.size());
+    // Pushed in reverse order, so that the first child is visited first.
+    for (size_t i = child_nodes.size(); i > 0; --i) {
+      stack.push_back({child_nodes[i - 1].get(), first_child + i - 1});
+    }
+  }
+
+  // The quantum labels of the events are set by the rows of the updaters.
+  std::vector<const QuantumLabel*> quantum_labels;
+  for (const std::shared_ptr<const RowPatch>& row : row_pool.patches()) {
+    for (const QuantumLabel& quantum_label :
+         row->row().quantum_labels().quantum_labels()) {
+      quantum_labels.push_back(&quantum_label);
+    }
+  }
+  std::shared_ptr<const QuantumLabelCollapser::Precompiled>
+      precompiled_quantum_labels =
+          QuantumLabelCollapser::Precompile(quantum_labels);
+  for (PopulationNodeImpl* node : population_nodes) {
+    node->UsePrecompiledQuantumLabels(precompiled_quantum_labels);
+  }
+  for (RankedPopulationNodeImpl* node : ranked_population_nodes) {
+    node->UsePrecompiledQuantumLabels(precompiled_quantum_labels);
+  }
+
+  std::unique_ptr<ModelStatsCollector> stats = nullptr;
+  if (stats_options.enabled) {
+    if (stats_options.latency_sample_period <= 0) {
+      return absl::InvalidArgumentError(
+          "The latency sample period must be positive.");
+    }
+    std::vector<std::string> node_names;
+    std::vector<uint32_t> branch_counts;
+    node_names.reserve(nodes.size());
+    branch_counts.reserve(nodes.size());
+    for (const Node& node : nodes) {
+      node_names.push_back(node.impl->name());
+      branch_counts.push_back(
+          node.kind == NodeKind::kBranch
+              ? static_cast<const BranchNodeImpl*>(node.impl)
+                    ->child_nodes()
+                    .size()
+              : 0);
+    }
+    stats = absl::make_unique<ModelStatsCollector>(
+        stats_options, std::move(node_names), std::move(branch_counts));
+  }
+
+  return absl::make_unique<FlatModel>(std::move(root), std::move(nodes),
+                                      std::move(child_indexes),
+                                      std::move(predicate_registry),
+                                      std::move(stats));
+}
+
+FlatModel::FlatModel(std::unique_ptr<ModelNode> root,
+                     std::vector<Node>&& nodes,
+                     std::vector<uint32_t>&& child_indexes,
+                     std::unique_ptr<PredicateRegistry> predicate_registry,
+                     std::unique_ptr<ModelStatsCollector> stats)
+    : root_(std::move(root)),
+      nodes_(std::move(nodes)),
+      child_indexes_(std::move(child_indexes)),
+      predicate_registry_(std::move(predicate_registry)),
+      stats_(std::move(stats)) {}
+
+absl::Status FlatModel::Apply(LabelerEvent& event) const {
+  // The buffers of the cache are reused across events.
+  thread_local PredicateCache predicate_cache;
+  predicate_cache.Reset(*predicate_registry_, event);
+  ScopedPredicateCache scoped_predicate_cache(&predicate_cache);
+
+  if (!stats_) {
+    return ApplyFrom<false>(0, event, nullptr, false);
+  }
+  ModelStatsCollector::Shard& shard = stats_->GetShard();
+  bool sampled = stats_->StartEvent(shard);
+  return ApplyFrom<true>(0, event, &shard, sampled);
+}
+
+absl::StatusOr<ModelStats> FlatModel::GetStats() const {
+  if (!stats_) {
+    return absl::FailedPreconditionError("Statistics are not enabled.");
+  }
+  return stats_->GetStats();
+}
+
+template <bool kCollectStats>
+absl::Status FlatModel::ApplyFrom(uint32_t node_index, LabelerEvent& event,
+                                  ModelStatsCollector::Shard* shard,
+                                  bool sampled) const {
+  if constexpr (kCollectStats) {
+    if (sampled) {
+      size_t path_begin = shard->path.size();
+      absl::Status status =
+          ApplyPath<kCollectStats>(node_index, event, shard, sampled);
+      stats_->EndPath(*shard, path_begin);
+      return status;
+    }
+  }
+  return ApplyPath<kCollectStats>(node_index, event, shard, sampled);
+}
+
+template <bool kCollectStats>
+absl::Status FlatModel::ApplyPath(uint32_t node_index, LabelerEvent& event,
+                                  ModelStatsCollector::Shard* shard,
+                                  bool sampled) const {
+  while (true) {
+    const Node& node = nodes_[node_index];
+    if constexpr (kCollectStats) {
+      stats_->RecordVisit(*shard, node_index, sampled);
+    }
+
+    // The node classes are final, so the calls below are not virtual.
+    absl::Status status;
+    switch (node.kind) {
+      case NodeKind::kBranch: {
+        const auto& branch = *static_cast<const BranchNodeImpl*>(node.impl);
+        TraceNode(branch.name());
+        if (branch.has_multiplicity()) {
+          bool child_failed = false;
+          status = branch.ApplyMultiplicity(
+              event, [&](LabelerEvent& clone) -> absl::Status {
+                absl::StatusOr<int> selected_index = branch.SelectChild(clone);
+                if (!selected_index.ok()) {
+                  return selected_index.status();
+                }
+                if constexpr (kCollectStats) {
+                  stats_->RecordBranch(*shard,
+                                       node.first_child + *selected_index);
+                }
+                absl::Status child_status = ApplyFrom<kCollectStats>(
+                    child_index(node_index, *selected_index), clone, shard,
+                    sampled);
+                child_failed = !child_status.ok();
+                return child_status;
+              });
+          if constexpr (kCollectStats) {
+            if (!status.ok() && !child_failed) {
+              stats_->RecordError(*shard, node_index);
+            }
+          }
+          return status;
+        }
+        status = branch.ApplyUpdaters(event);
+        if (!status.ok()) {
+          break;
+        }
+        absl::StatusOr<int> selected_index = branch.SelectChild(event);
+        if (!selected_index.ok()) {
+          status = selected_index.status();
+          break;
+        }
+        if constexpr (kCollectStats) {
+          stats_->RecordBranch(*shard, node.first_child + *selected_index);
+        }
+        node_index = child_index(node_index, *selected_index);
+        continue;
+      }
+      case NodeKind::kPopulation:
+        status =
+            static_cast<const PopulationNodeImpl*>(node.impl)->Apply(event);
+        break;
+      case NodeKind::kRankedPopulation:
+        status = static_cast<const RankedPopulationNodeImpl*>(node.impl)->Apply(
+            event);
+        break;
+      case NodeKind::kStop:
+        status = static_cast<const StopNodeImpl*>(node.impl)->Apply(event);
+        break;
+    }
+
+    if constexpr (kCollectStats) {
+      if (!status.ok()) {
+        stats_->RecordError(*shard, node_index);
+      }
+    }
+    return status;
+  }
+}
+
+}  // namespace wfa_virtual_people
@@ -0,0 +1,141 @@
+// Copyright 2026 The Cross-Media Measurement Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_MODEL_FLAT_MODEL_H_
+#define SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_MODEL_FLAT_MODEL_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "wfa/virtual_people/common/label.pb.h"
+#include "wfa/virtual_people/core/model/model_node.h"
+#include "wfa/virtual_people/core/model/model_stats.h"
+#include "wfa/virtual_people/core/model/utils/predicate_cache.h"
+#include "wfa/virtual_people/core/model/utils/row_patch_pool.h"
+
+namespace wfa_virtual_people {
+
+// The model tree flattened into a contiguous table of nodes, for labeling.
+//
+// The nodes are stored in depth first pre-order, so the nodes along a path are
+// close to each other in memory, and the children of each branch node are
+// referenced by their indexes in the table. Apply walks the table in a loop,
+// dispatching on the kind of each node, instead of recursing through the
+// virtual ModelNode::Apply of every node on the path. Only multiplicity, which
+// applies the child node to several clones, recurses.
+//
+// The payload of each node, e.g. the hashing, the matcher and the attributes
+// updaters, stays in the ModelNode tree, which is owned by the FlatModel.
+//
+// The structurally identical conditions of the branch nodes and attributes
+// updaters along the paths are registered to one PredicateRegistry, so that
+// each of them is evaluated about once per event. The equal rows merged by
+// the attributes updaters of all the nodes are interned, so that each of them
+// is stored once. The quantum labels in these rows are compiled ahead of
+// labeling, and shared by all the population nodes.
+//
+// When statistics are enabled, the visits, branch selections, errors and
+// sampled latency of each node are recorded, which can be read by GetStats.
+class FlatModel {
+ public:
+  // Always use FlatModel::Build to get a FlatModel object.
+  // Users should never call the constructor directly.
+  //
+  // Returns error status if @root is null, or the tree has a node of unknown
+  // type.
+  static absl::StatusOr<std::unique_ptr<FlatModel>> Build(
+      std::unique_ptr<ModelNode> root);
+
+  // Same as above, collecting statistics as configured by @stats_options.
+  static absl::StatusOr<std::unique_ptr<FlatModel>> Build(
+      std::unique_ptr<ModelNode> root, const ModelStatsOptions& stats_options);
+
+  enum class NodeKind : uint8_t {
+    kBranch,
+    kPopulation,
+    kRankedPopulation,
+    kStop,
+  };
+
+  struct Node {
+    NodeKind kind;
+    // For branch nodes, the position in child_indexes_ of the index of the
+    // first child node. The indexes of the child nodes are contiguous, in the
+    // same order as the branches.
+    uint32_t first_child;
+    // Points to the ModelNode of the kind above.
+    const ModelNode* impl;
+  };
+
+  // Never call the constructor directly.
+  FlatModel(std::unique_ptr<ModelNode> root, std::vector<Node>&& nodes,
+            std::vector<uint32_t>&& child_indexes,
+            std::unique_ptr<PredicateRegistry> predicate_registry,
+            std::unique_ptr<ModelStatsCollector> stats);
+
+  FlatModel(const FlatModel&) = delete;
+  FlatModel& operator=(const FlatModel&) = delete;
+
+  // Applies the model to the @event. Same as calling Apply of the root node.
+  absl::Status Apply(LabelerEvent& event) const;
+
+  // Returns the statistics of all the events labeled so far, merged from all
+  // the threads. Returns error status if statistics are not enabled.
+  absl::StatusOr<ModelStats> GetStats() const;
+
+  // The nodes of the model, with the root node at index 0.
+  const std::vector<Node>& nodes() const { return nodes_; }
+
+  // The distinct conditions registered from the nodes.
+  const PredicateRegistry& predicate_registry() const {
+    return *predicate_registry_;
+  }
+
+  // Returns the index of the child node at @branch_index of the branch node at
+  // @node_index.
+  uint32_t child_index(uint32_t node_index, int branch_index) const {
+    return child_indexes_[nodes_[node_index].first_child + branch_index];
+  }
+
+ private:
+  // Applies the sub-tree of the node at @node_index to the @event.
+  //
+  // If @kCollectStats is true, the statistics are recorded to @shard, and the
+  // latency is measured if @sampled is true. Otherwise @shard is not used.
+  template <bool kCollectStats>
+  absl::Status ApplyFrom(uint32_t node_index, LabelerEvent& event,
+                         ModelStatsCollector::Shard* shard,
+                         bool sampled) const;
+
+  // Same as ApplyFrom, but does not measure the latency.
+  template <bool kCollectStats>
+  absl::Status ApplyPath(uint32_t node_index, LabelerEvent& event,
+                         ModelStatsCollector::Shard* shard,
+                         bool sampled) const;
+
+  std::unique_ptr<ModelNode> root_;
+  std::vector<Node> nodes_;
+  std::vector<uint32_t> child_indexes_;
+  std::unique_ptr<PredicateRegistry> predicate_registry_;
+
+  // Null if statistics are not enabled.
+  std::unique_ptr<ModelStatsCollector> stats_;
+};
+
+}  // namespace wfa_virtual_people
+
+#endif  // SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_MODEL_FLAT_MODEL_H_
@@ -14,26 +14,50 @@
 
 #include "wfa/virtual_people/core/model/geometric_shredder_impl.h"
 
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/container/fixed_array.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
-#include "absl/strings/str_format.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "common_cpp/macros/macros.h"
 #include "google/protobuf/descriptor.h"
 #include "src/farmhash.h"
 #include "wfa/virtual_people/common/field_filter/utils/field_util.h"
 #include "wfa/virtual_people/common/model.pb.h"
 #include "wfa/virtual_people/core/model/attributes_updater.h"
+#include "wfa/virtual_people/core/model/utils/field_accessor.h"
 #include "wfa/virtual_people/core/model/utils/hash.h"
+#include "wfa/virtual_people/core/model/utils/predicate_cache.h"
 
 namespace wfa_virtual_people {
 
+namespace {
+
+// The number of decimal digits of the max uint64_t.
+constexpr size_t kMaxUint64Digits = 20;
+
+constexpr absl::string_view kShredSeedInfix = "-shred-";
+
+// Returns the Fingerprint64 of the decimal representation of
+// @randomness_value, of which the ExpHash is used to compute the shred hash.
+uint64_t RandomnessFingerprint(uint64_t randomness_value) {
+  absl::AlphaNum digits(randomness_value);
+  return util::Fingerprint64(digits.data(), digits.size());
+}
+
+}  // namespace
+
 absl::StatusOr<std::unique_ptr<GeometricShredderImpl>>
 GeometricShredderImpl::Build(const GeometricShredder& config) {
   float psi = config.psi();
@@ -42,21 +66,18 @@ GeometricShredderImpl::Build(const GeometricShredder& config) {
         "Psi is not in [0, 1] in GeometricShredder: ", config.DebugString()));
   }
 
-  ASSIGN_OR_RETURN(
-      std::vector<const google::protobuf::FieldDescriptor*> randomness_field,
-      GetFieldFromProto(LabelerEvent().GetDescriptor(),
-                        config.randomness_field()));
-  if (randomness_field.back()->cpp_type() !=
+  ASSIGN_OR_RETURN(FieldAccessor randomness_field,
+                   FieldAccessor::Build(config.randomness_field()));
+  if (randomness_field.cpp_type() !=
       google::protobuf::FieldDescriptor::CPPTYPE_UINT64) {
     return absl::InvalidArgumentError(absl::StrCat(
         "randomness_field type is not uint64 in GeometricShredder: ",
         config.DebugString()));
   }
 
-  ASSIGN_OR_RETURN(
-      std::vector<const google::protobuf::FieldDescriptor*> target_field,
-      GetFieldFromProto(LabelerEvent().GetDescriptor(), config.target_field()));
-  if (target_field.back()->cpp_type() !=
+  ASSIGN_OR_RETURN(FieldAccessor target_field,
+                   FieldAccessor::Build(config.target_field()));
+  if (target_field.cpp_type() !=
       google::protobuf::FieldDescriptor::CPPTYPE_UINT64) {
     return absl::InvalidArgumentError(
         absl::StrCat("target_field type is not uint64 in GeometricShredder: ",
@@ -70,25 +91,82 @@ GeometricShredderImpl::Build(const GeometricShredder& config) {
 
 absl::Status GeometricShredderImpl::Update(LabelerEvent& event) const {
   ASSIGN_OR_RETURN(uint64_t shred_hash, ShredHash(event));
+  return Shred(event, shred_hash);
+}
+
+absl::Status GeometricShredderImpl::UpdateBatch(
+    absl::Span<LabelerEvent* const> events) const {
+  // The shred hashes do not depend on ExpHash.
+  if (psi_ == 0.0f || psi_ == 1.0f) {
+    for (LabelerEvent* event : events) {
+      RETURN_IF_ERROR(Update(*event));
+    }
+    return absl::OkStatus();
+  }
+
+  std::array<uint64_t, kUpdateBatchBlockSize> fingerprints;
+  std::array<double, kUpdateBatchBlockSize> exp_hashes;
+  for (size_t begin = 0; begin < events.size();
+       begin += kUpdateBatchBlockSize) {
+    size_t count = std::min(kUpdateBatchBlockSize, events.size() - begin);
+    // Stops at the first event without the randomness field, after updating
+    // the events before it.
+    size_t hashed_count = 0;
+    for (; hashed_count < count; ++hashed_count) {
+      ProtoFieldValue<uint64_t> randomness_field_value =
+          randomness_field_.Get<uint64_t>(*events[begin + hashed_count]);
+      if (!randomness_field_value.is_set) {
+        break;
+      }
+      fingerprints[hashed_count] =
+          RandomnessFingerprint(randomness_field_value.value);
+    }
+    ExpHashBatch(absl::MakeConstSpan(fingerprints.data(), hashed_count),
+                 absl::MakeSpan(exp_hashes.data(), hashed_count));
+    for (size_t i = 0; i < hashed_count; ++i) {
+      RETURN_IF_ERROR(
+          Shred(*events[begin + i], ShredHashFromExpHash(exp_hashes[i])));
+    }
+    if (hashed_count < count) {
+      return absl::InvalidArgumentError(
+          "The randomness field is not set in the event.");
+    }
+  }
+  return absl::OkStatus();
+}
 
+absl::Status GeometricShredderImpl::Shred(LabelerEvent& event,
+                                          uint64_t shred_hash) const {
   if (shred_hash == 0) {
     return absl::OkStatus();
   }
 
   ProtoFieldValue<uint64_t> target_field_value =
-      GetValueFromProto<uint64_t>(event, target_field_);
+      target_field_.Get<uint64_t>(event);
   if (!target_field_value.is_set) {
     return absl::InvalidArgumentError(
         "The target field is not set in the event.");
   }
-  uint64_t target_value = target_field_value.value;
 
-  std::string full_seed =
-      absl::StrFormat("%d-shred-%d-%s", target_value, shred_hash, random_seed_);
-
-  uint64_t shred = util::Fingerprint64(full_seed);
-
-  SetValueToProto<uint64_t>(event, target_field_, shred);
+  // The full seed is "<target value>-shred-<shred hash>-<random seed>".
+  absl::FixedArray<char, kInlineSeedSize> full_seed(
+      kMaxUint64Digits + kShredSeedInfix.size() + kMaxUint64Digits + 1 +
+      random_seed_.size());
+  absl::AlphaNum target_value(target_field_value.value);
+  char* end = std::copy(target_value.data(),
+                        target_value.data() + target_value.size(),
+                        full_seed.begin());
+  end = std::copy(kShredSeedInfix.begin(), kShredSeedInfix.end(), end);
+  absl::AlphaNum shred_hash_digits(shred_hash);
+  end = std::copy(shred_hash_digits.data(),
+                  shred_hash_digits.data() + shred_hash_digits.size(), end);
+  *end++ = '-';
+  end = std::copy(random_seed_.begin(), random_seed_.end(), end);
+
+  uint64_t shred =
+      util::Fingerprint64(full_seed.data(), end - full_seed.data());
+
+  target_field_.Set<uint64_t>(event, shred);
 
   return absl::OkStatus();
 }
@@ -101,7 +179,7 @@ absl::StatusOr<uint64_t> GeometricShredderImpl::ShredHash(
   }
 
   ProtoFieldValue<uint64_t> randomness_field_value =
-      GetValueFromProto<uint64_t>(event, randomness_field_);
+      randomness_field_.Get<uint64_t>(event);
   if (!randomness_field_value.is_set) {
     return absl::InvalidArgumentError(
         "The randomness field is not set in the event.");
@@ -114,8 +192,12 @@ absl::StatusOr<uint64_t> GeometricShredderImpl::ShredHash(
   }
 
   // shred_hash = Floor(ExpHash(randomness_value) / (- Log(psi)))
-  double exp_hash = ExpHash(std::to_string(randomness_value));
-  return static_cast<uint64_t>(std::floor(exp_hash / (-std::log(psi_))));
+  absl::AlphaNum randomness_digits(randomness_value);
+  return ShredHashFromExpHash(ExpHash(randomness_digits.Piece()));
+}
+
+EventFieldMask GeometricShredderImpl::WrittenFields() const {
+  return GetEventFieldMask(target_field_.path());
 }
 
 }  // namespace wfa_virtual_people
@@ -15,17 +15,21 @@
 #ifndef SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_MODEL_GEOMETRIC_SHREDDER_IMPL_H_
 #define SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_MODEL_GEOMETRIC_SHREDDER_IMPL_H_
 
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <utility>
-#include <vector>
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
-#include "google/protobuf/descriptor.h"
+#include "absl/types/span.h"
 #include "wfa/virtual_people/common/model.pb.h"
 #include "wfa/virtual_people/core/model/attributes_updater.h"
+#include "wfa/virtual_people/core/model/utils/field_accessor.h"
+#include "wfa/virtual_people/core/model/utils/predicate_cache.h"
 
 namespace wfa_virtual_people {
 
@@ -50,12 +54,11 @@ class GeometricShredderImpl : public AttributesUpdaterInterface {
   static absl::StatusOr<std::unique_ptr<GeometricShredderImpl>> Build(
       const GeometricShredder& config);
 
-  explicit GeometricShredderImpl(
-      float psi,
-      std::vector<const google::protobuf::FieldDescriptor*>&& randomness_field,
-      std::vector<const google::protobuf::FieldDescriptor*>&& target_field,
-      absl::string_view random_seed)
+  explicit GeometricShredderImpl(float psi, FieldAccessor&& randomness_field,
+                                 FieldAccessor&& target_field,
+                                 absl::string_view random_seed)
       : psi_(psi),
+        neg_log_psi_(-std::log(psi)),
         randomness_field_(std::move(randomness_field)),
         target_field_(std::move(target_field)),
         random_seed_(random_seed) {}
@@ -67,19 +70,44 @@ class GeometricShredderImpl : public AttributesUpdaterInterface {
   // Returns error if the randomness field or target field is not set.
   absl::Status Update(LabelerEvent& event) const override;
 
+  // Updates a batch of events. Same as calling Update for each of @events in
+  // order, but the hashes of the randomness values are computed in blocks.
+  //
+  // Returns error status at the first event failing to update. The events
+  // before it are updated, and the events after it are not.
+  absl::Status UpdateBatch(absl::Span<LabelerEvent* const> events) const;
+
+  EventFieldMask WrittenFields() const override;
+
+  // The full seeds up to this size are built on the stack.
+  static constexpr size_t kInlineSeedSize = 256;
+
+  // The number of events processed together by UpdateBatch.
+  static constexpr size_t kUpdateBatchBlockSize = 64;
+
  private:
   // Compute the shred hash.
   absl::StatusOr<uint64_t> ShredHash(const LabelerEvent& event) const;
 
+  // Returns the shred hash from the ExpHash of the randomness value, when psi_
+  // is in (0, 1).
+  uint64_t ShredHashFromExpHash(double exp_hash) const {
+    return static_cast<uint64_t>(std::floor(exp_hash / neg_log_psi_));
+  }
+
+  // Updates the target field in @event with the shred value of @shred_hash.
+  absl::Status Shred(LabelerEvent& event, uint64_t shred_hash) const;
+
   // The shredding probability parameter psi, which corresponds to the success
   // probability parameter of geometric distribution as p = 1 − psi.
   float psi_;
-  // The descriptors of the field in LabelerEvent, which provides the randomness
-  // for the geometric shredding.
-  std::vector<const google::protobuf::FieldDescriptor*> randomness_field_;
-  // The descriptors of the field in LabelerEvent, which is to be updated by
-  // the shred value.
-  std::vector<const google::protobuf::FieldDescriptor*> target_field_;
+  // -log(psi_), used to compute the shred hash.
+  float neg_log_psi_;
+  // The field in LabelerEvent, which provides the randomness for the geometric
+  // shredding.
+  FieldAccessor randomness_field_;
+  // The field in LabelerEvent, which is to be updated by the shred value.
+  FieldAccessor target_field_;
   // The seed used to generate the shred hash output.
   std::string random_seed_;
 };
@@ -54,6 +54,8 @@ class ModelNode {
   // Applies the node to the @event.
   virtual absl::Status Apply(LabelerEvent& event) const = 0;
 
+  const std::string& name() const { return name_; }
+
   ModelNode(const ModelNode&) = delete;
   ModelNode& operator=(const ModelNode&) = delete;
 
@@ -0,0 +1,178 @@
+// Copyright 2026 The Cross-Media Measurement Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "wfa/virtual_people/core/model/model_stats.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/numeric/bits.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+namespace wfa_virtual_people {
+
+namespace {
+
+// The log2 of the upper bound of bucket 0 in nanoseconds.
+constexpr int kFirstBucketBits = 7;
+
+std::atomic<uint64_t> next_collector_id{1};
+
+}  // namespace
+
+int LatencyHistogram::GetBucket(int64_t latency_nanos) {
+  if (latency_nanos < (int64_t{1} << kFirstBucketBits)) {
+    return 0;
+  }
+  int bits = absl::bit_width(static_cast<uint64_t>(latency_nanos));
+  return std::min(bits - kFirstBucketBits, kBucketCount - 1);
+}
+
+absl::Duration LatencyHistogram::GetBucketUpperBound(int bucket) {
+  if (bucket >= kBucketCount - 1) {
+    return absl::InfiniteDuration();
+  }
+  return absl::Nanoseconds(int64_t{1} << (bucket + kFirstBucketBits));
+}
+
+absl::Duration LatencyHistogram::Mean() const {
+  if (count == 0) {
+    return absl::ZeroDuration();
+  }
+  return total / count;
+}
+
+absl::Duration LatencyHistogram::Quantile(double quantile) const {
+  if (count == 0) {
+    return absl::ZeroDuration();
+  }
+  int64_t rank = static_cast<int64_t>(std::ceil(quantile * count));
+  int64_t seen = 0;
+  for (int bucket = 0; bucket < kBucketCount; ++bucket) {
+    seen += buckets[bucket];
+    if (seen >= rank && seen > 0) {
+      return GetBucketUpperBound(bucket);
+    }
+  }
+  return GetBucketUpperBound(kBucketCount - 1);
+}
+
+ModelStatsCollector::Shard::Shard(size_t node_count, size_t branch_count)
+    : visits(node_count),
+      errors(node_count),
+      branch_selections(branch_count),
+      latency_buckets(node_count * LatencyHistogram::kBucketCount),
+      latency_total_nanos(node_count) {}
+
+ModelStatsCollector::ModelStatsCollector(const ModelStatsOptions& options,
+                                         std::vector<std::string> node_names,
+                                         std::vector<uint32_t> branch_counts)
+    : latency_sample_period_(std::max(options.latency_sample_period, 1)),
+      node_names_(std::move(node_names)),
+      branch_counts_(std::move(branch_counts)),
+      id_(next_collector_id.fetch_add(1, std::memory_order_relaxed)) {
+  for (uint32_t branch_count : branch_counts_) {
+    total_branch_count_ += branch_count;
+  }
+}
+
+ModelStatsCollector::Shard& ModelStatsCollector::GetShard() const {
+  // Caches the shard of the last collector used by this thread, so that the
+  // lock is only taken when a thread switches between collectors.
+  struct CachedShard {
+    uint64_t collector_id = 0;
+    Shard* shard = nullptr;
+  };
+  thread_local CachedShard cached_shard;
+  if (cached_shard.collector_id == id_) {
+    return *cached_shard.shard;
+  }
+
+  std::lock_guard<std::mutex> lock(mtx_);
+  std::unique_ptr<Shard>& shard = shards_[std::this_thread::get_id()];
+  if (!shard) {
+    shard = absl::make_unique<Shard>(node_names_.size(), total_branch_count_);
+  }
+  cached_shard = {id_, shard.get()};
+  return *shard;
+}
+
+void ModelStatsCollector::RecordVisit(Shard& shard, uint32_t node_index,
+                                      bool sampled) const {
+  shard.visits[node_index].Add(1);
+  if (sampled) {
+    shard.path.emplace_back(node_index, absl::GetCurrentTimeNanos());
+  }
+}
+
+void ModelStatsCollector::EndPath(Shard& shard, size_t path_begin) const {
+  int64_t end_nanos = absl::GetCurrentTimeNanos();
+  for (size_t i = path_begin; i < shard.path.size(); ++i) {
+    auto [node_index, start_nanos] = shard.path[i];
+    int64_t latency_nanos = end_nanos - start_nanos;
+    int bucket = LatencyHistogram::GetBucket(latency_nanos);
+    shard.latency_buckets[node_index * LatencyHistogram::kBucketCount + bucket]
+        .Add(1);
+    shard.latency_total_nanos[node_index].Add(latency_nanos);
+  }
+  shard.path.resize(path_begin);
+}
+
+ModelStats ModelStatsCollector::GetStats() const {
+  ModelStats stats;
+  stats.nodes.resize(node_names_.size());
+  for (size_t i = 0; i < node_names_.size(); ++i) {
+    stats.nodes[i].name = node_names_[i];
+    stats.nodes[i].branch_selections.resize(branch_counts_[i]);
+  }
+
+  std::lock_guard<std::mutex> lock(mtx_);
+  for (const auto& [thread_id, shard] : shards_) {
+    stats.labeled_events += shard->labeled_events.Get();
+    stats.sampled_events += shard->sampled_events.Get();
+    size_t branch_slot = 0;
+    for (size_t i = 0; i < stats.nodes.size(); ++i) {
+      NodeStats& node_stats = stats.nodes[i];
+      node_stats.visits += shard->visits[i].Get();
+      node_stats.errors += shard->errors[i].Get();
+      for (int64_t& selections : node_stats.branch_selections) {
+        selections += shard->branch_selections[branch_slot++].Get();
+      }
+      for (int bucket = 0; bucket < LatencyHistogram::kBucketCount; ++bucket) {
+        int64_t samples =
+            shard
+                ->latency_buckets[i * LatencyHistogram::kBucketCount + bucket]
+                .Get();
+        node_stats.latency.buckets[bucket] += samples;
+        node_stats.latency.count += samples;
+      }
+      node_stats.latency.total +=
+          absl::Nanoseconds(shard->latency_total_nanos[i].Get());
+    }
+  }
+  return stats;
+}
+
+}  // namespace wfa_virtual_people
@@ -0,0 +1,200 @@
+// Copyright 2026 The Cross-Media Measurement Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_MODEL_MODEL_STATS_H_
+#define SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_MODEL_MODEL_STATS_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/time/time.h"
+
+namespace wfa_virtual_people {
+
+struct ModelStatsOptions {
+  // When true, the execution statistics of each node are collected, and can
+  // be read with GetStats.
+  bool enabled = false;
+
+  // The latency is measured for one in every @latency_sample_period events
+  // labeled by each thread. Must be positive.
+  int latency_sample_period = 64;
+};
+
+// A histogram of latencies with exponential buckets. Bucket 0 counts the
+// latencies below 128ns, bucket i counts the latencies in
+// [2^(i + 6), 2^(i + 7)) ns, and the last bucket counts all the latencies
+// above its lower bound.
+struct LatencyHistogram {
+  static constexpr int kBucketCount = 24;
+
+  // Returns the bucket of @latency_nanos.
+  static int GetBucket(int64_t latency_nanos);
+
+  // Returns the upper bound of the @bucket.
+  static absl::Duration GetBucketUpperBound(int bucket);
+
+  // Returns the mean latency, or zero if there is no sample.
+  absl::Duration Mean() const;
+
+  // Returns the upper bound of the bucket which contains the @quantile of the
+  // samples, e.g. 0.99 for the 99th percentile. Returns zero if there is no
+  // sample.
+  absl::Duration Quantile(double quantile) const;
+
+  std::array<int64_t, kBucketCount> buckets = {};
+  int64_t count = 0;
+  absl::Duration total = absl::ZeroDuration();
+};
+
+// The execution statistics of a model node.
+struct NodeStats {
+  // The name of the node, which is empty if not set in the model.
+  std::string name;
+
+  // The number of times the node is applied. Each clone created by
+  // multiplicity is counted separately.
+  int64_t visits = 0;
+
+  // The number of times applying the node itself fails, e.g. no condition
+  // matches, or an attributes updater fails. The failures of the child nodes
+  // are counted in the child nodes.
+  int64_t errors = 0;
+
+  // For branch nodes, the number of times each branch is selected, in the same
+  // order as the branches. Empty for other nodes.
+  std::vector<int64_t> branch_selections;
+
+  // The sampled latency of applying the sub-tree of this node.
+  LatencyHistogram latency;
+};
+
+// The execution statistics of a model.
+struct ModelStats {
+  // The number of events labeled.
+  int64_t labeled_events = 0;
+
+  // The number of events for which the latency is measured.
+  int64_t sampled_events = 0;
+
+  // The statistics of each node, in the order of FlatModel::nodes.
+  std::vector<NodeStats> nodes;
+};
+
+// Collects the execution statistics of the nodes of a model.
+//
+// Each thread records to its own shard, so recording never contends with
+// other threads. The shards are merged by GetStats. The shards are kept until
+// the collector is destroyed, so the statistics of threads which have exited
+// are not lost.
+class ModelStatsCollector {
+ public:
+  // A counter written by a single thread and read by any thread.
+  class Counter {
+   public:
+    void Add(int64_t value) {
+      value_.store(value_.load(std::memory_order_relaxed) + value,
+                   std::memory_order_relaxed);
+    }
+    int64_t Get() const { return value_.load(std::memory_order_relaxed); }
+
+   private:
+    std::atomic<int64_t> value_{0};
+  };
+
+  // The statistics recorded by one thread.
+  struct Shard {
+    Shard(size_t node_count, size_t branch_count);
+
+    Counter labeled_events;
+    Counter sampled_events;
+    std::vector<Counter> visits;
+    std::vector<Counter> errors;
+    std::vector<Counter> branch_selections;
+    // kBucketCount buckets for each node.
+    std::vector<Counter> latency_buckets;
+    std::vector<Counter> latency_total_nanos;
+
+    // The nodes on the path of the sampled event being labeled, with the time
+    // each node is entered. Only used by the owner thread.
+    std::vector<std::pair<uint32_t, int64_t>> path;
+  };
+
+  // @branch_counts has the number of branches of each node, which is 0 for
+  // nodes other than branch nodes.
+  ModelStatsCollector(const ModelStatsOptions& options,
+                      std::vector<std::string> node_names,
+                      std::vector<uint32_t> branch_counts);
+
+  ModelStatsCollector(const ModelStatsCollector&) = delete;
+  ModelStatsCollector& operator=(const ModelStatsCollector&) = delete;
+
+  // Returns the shard of the current thread.
+  Shard& GetShard() const;
+
+  // Counts an event labeled with @shard, and returns whether its latency should
+  // be measured.
+  bool StartEvent(Shard& shard) const {
+    shard.labeled_events.Add(1);
+    if (shard.labeled_events.Get() % latency_sample_period_ != 0) {
+      return false;
+    }
+    shard.sampled_events.Add(1);
+    return true;
+  }
+
+  void RecordVisit(Shard& shard, uint32_t node_index, bool sampled) const;
+
+  // @branch_slot is the index of the branch among the branches of all the
+  // nodes, in the order of the nodes.
+  void RecordBranch(Shard& shard, uint32_t branch_slot) const {
+    shard.branch_selections[branch_slot].Add(1);
+  }
+
+  void RecordError(Shard& shard, uint32_t node_index) const {
+    shard.errors[node_index].Add(1);
+  }
+
+  // Records the latency of the nodes on the path entered since the path had
+  // @path_begin entries, and removes them from the path.
+  void EndPath(Shard& shard, size_t path_begin) const;
+
+  // Merges the statistics of all the threads.
+  ModelStats GetStats() const;
+
+ private:
+  const int latency_sample_period_;
+  const std::vector<std::string> node_names_;
+  const std::vector<uint32_t> branch_counts_;
+  size_t total_branch_count_ = 0;
+
+  // Identifies this collector in the shard cache of each thread. Never reused.
+  const uint64_t id_;
+
+  mutable std::mutex mtx_;
+  mutable absl::flat_hash_map<std::thread::id, std::unique_ptr<Shard>> shards_;
+};
+
+}  // namespace wfa_virtual_people
+
+#endif  // SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_MODEL_MODEL_STATS_H_
@@ -16,6 +16,7 @@
 
 #include <limits>
 #include <memory>
+#include <optional>
 #include <utility>
 #include <vector>
 
@@ -26,6 +27,7 @@
 #include "src/farmhash.h"
 #include "wfa/virtual_people/common/field_filter/utils/field_util.h"
 #include "wfa/virtual_people/common/model.pb.h"
+#include "wfa/virtual_people/core/model/utils/field_accessor.h"
 
 namespace wfa_virtual_people {
 
@@ -47,51 +49,18 @@ absl::StatusOr<int> ComputeBimodalInteger(double expectation, uint64_t seed) {
   }
 }
 
-template <typename ValueType>
-using IsIntegerFloatType =
-    absl::disjunction<IsIntegerType<ValueType>, std::is_same<ValueType, float>,
-                      std::is_same<ValueType, double>>;
-
-template <typename ValueType>
-using EnableIfIntegerFloatType =
-    absl::enable_if_t<IsIntegerFloatType<ValueType>::value, bool>;
-
-// Extracts a double value from the @source field in @event.
-template <typename ValueType, EnableIfIntegerFloatType<ValueType> = true>
-absl::StatusOr<double> ExtractDoubleValue(
-    const LabelerEvent& event,
-    const std::vector<const google::protobuf::FieldDescriptor*>& source) {
-  ProtoFieldValue<ValueType> field_value =
-      GetValueFromProto<ValueType>(event, source);
-  if (field_value.is_set) {
-    return field_value.value;
-  }
-
-  return absl::InvalidArgumentError("The multiplicity field is not set.");
-}
-
-// Gets a function to extract multiplicity value from a field.
-absl::StatusOr<std::function<absl::StatusOr<double>(
-    const LabelerEvent&,
-    const std::vector<const google::protobuf::FieldDescriptor*>&)>>
-GetExtractMultiplicityFunction(
+bool IsIntegerFloatFieldType(
     const google::protobuf::FieldDescriptor::CppType cpp_type) {
   switch (cpp_type) {
     case google::protobuf::FieldDescriptor::CppType::CPPTYPE_INT32:
-      return ExtractDoubleValue<int32_t>;
     case google::protobuf::FieldDescriptor::CppType::CPPTYPE_INT64:
-      return ExtractDoubleValue<int64_t>;
     case google::protobuf::FieldDescriptor::CppType::CPPTYPE_UINT32:
-      return ExtractDoubleValue<uint32_t>;
     case google::protobuf::FieldDescriptor::CppType::CPPTYPE_UINT64:
-      return ExtractDoubleValue<uint64_t>;
     case google::protobuf::FieldDescriptor::CppType::CPPTYPE_FLOAT:
-      return ExtractDoubleValue<float>;
     case google::protobuf::FieldDescriptor::CppType::CPPTYPE_DOUBLE:
-      return ExtractDoubleValue<double>;
+      return true;
     default:
-      return absl::InvalidArgumentError(
-          "Unsupported field type for multiplicity.");
+      return false;
   }
 }
 
@@ -123,11 +92,26 @@ absl::StatusOr<std::unique_ptr<MultiplicityImpl>> MultiplicityImpl::Build(
                            field_descriptor,
                        GetFieldFromProto(LabelerEvent().GetDescriptor(),
                                          config.expected_multiplicity_field()));
+      if (!IsIntegerFloatFieldType(field_descriptor.back()->cpp_type())) {
+        return absl::InvalidArgumentError(
+            "Unsupported field type for multiplicity.");
+      }
+      ASSIGN_OR_RETURN(FieldAccessor field,
+                       FieldAccessor::Build(std::move(field_descriptor)));
       MultiplicityFromField from_field;
-      from_field.field_descriptor = std::move(field_descriptor);
-      ASSIGN_OR_RETURN(from_field.get_value_function,
-                       GetExtractMultiplicityFunction(
-                           from_field.field_descriptor.back()->cpp_type()));
+      from_field.field_descriptor = field.path();
+      from_field.get_value_function =
+          [field = std::move(field)](
+              const LabelerEvent& event,
+              const std::vector<const google::protobuf::FieldDescriptor*>&)
+          -> absl::StatusOr<double> {
+        ProtoFieldValue<double> field_value = field.GetAsDouble(event);
+        if (!field_value.is_set) {
+          return absl::InvalidArgumentError(
+              "The multiplicity field is not set.");
+        }
+        return field_value.value;
+      };
       multiplicity_extractor = std::move(from_field);
       break;
     }
@@ -142,13 +126,15 @@ absl::StatusOr<std::unique_ptr<MultiplicityImpl>> MultiplicityImpl::Build(
         "Multiplicity must set person_index_field.", config.DebugString()));
   }
   ASSIGN_OR_RETURN(
-      std::vector<const google::protobuf::FieldDescriptor*> person_index_field,
+      std::vector<const google::protobuf::FieldDescriptor*> person_index_path,
       GetFieldFromProto(LabelerEvent().GetDescriptor(),
                         config.person_index_field()));
-  if (!IsIntegerFieldType(person_index_field.back()->cpp_type())) {
+  if (!IsIntegerFieldType(person_index_path.back()->cpp_type())) {
     return absl::InvalidArgumentError(absl::StrCat(
         "Invalid type for person_index_field.", config.DebugString()));
   }
+  ASSIGN_OR_RETURN(FieldAccessor person_index_field,
+                   FieldAccessor::Build(std::move(person_index_path)));
 
   if (!config.has_max_value()) {
     return absl::InvalidArgumentError(
@@ -174,13 +160,13 @@ absl::StatusOr<std::unique_ptr<MultiplicityImpl>> MultiplicityImpl::Build(
 MultiplicityImpl::MultiplicityImpl(
     MultiplicityExtractor& multiplicity_extractor,
     CapMultiplicityAtMax cap_at_max, double max_value,
-    std::vector<const google::protobuf::FieldDescriptor*>&& person_index_field,
-    absl::string_view random_seed)
+    FieldAccessor&& person_index_field, absl::string_view random_seed)
     : multiplicity_extractor_(std::move(multiplicity_extractor)),
       cap_at_max_(cap_at_max),
       max_value_(max_value),
       person_index_field_(std::move(person_index_field)),
-      random_seed_(random_seed) {}
+      random_seed_(random_seed),
+      fingerprinter_(random_seed) {}
 
 absl::StatusOr<int> MultiplicityImpl::ComputeEventMultiplicity(
     const LabelerEvent& event) const {
@@ -221,14 +207,18 @@ absl::StatusOr<int> MultiplicityImpl::ComputeEventMultiplicity(
                      ", but multiplicity must >= 0."));
   }
 
-  uint64_t event_seed = util::Fingerprint64(
-      absl::StrCat(random_seed_, event.acting_fingerprint()));
+  uint64_t event_seed = fingerprinter_.Fingerprint(event.acting_fingerprint());
   return ComputeBimodalInteger(expected_multiplicity, event_seed);
 }
 
 const std::vector<const google::protobuf::FieldDescriptor*>&
 MultiplicityImpl::PersonIndexFieldDescriptor() const {
-  return person_index_field_;
+  return person_index_field_.path();
+}
+
+void MultiplicityImpl::SetPersonIndex(LabelerEvent& event,
+                                      int person_index) const {
+  person_index_field_.SetInteger(event, person_index);
 }
 
 uint64_t MultiplicityImpl::GetFingerprintForIndex(uint64_t input,
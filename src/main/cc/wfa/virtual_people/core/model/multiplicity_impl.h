@@ -23,6 +23,8 @@
 #include "absl/strings/string_view.h"
 #include "absl/types/variant.h"
 #include "wfa/virtual_people/common/model.pb.h"
+#include "wfa/virtual_people/core/model/utils/field_accessor.h"
+#include "wfa/virtual_people/core/model/utils/seeded_fingerprinter.h"
 
 namespace wfa_virtual_people {
 
@@ -67,9 +69,7 @@ class MultiplicityImpl {
   explicit MultiplicityImpl(
       MultiplicityExtractor& multiplicity_extractor,
       CapMultiplicityAtMax cap_at_max, double max_value,
-      std::vector<const google::protobuf::FieldDescriptor*>&&
-          person_index_field,
-      absl::string_view random_seed);
+      FieldAccessor&& person_index_field, absl::string_view random_seed);
 
   MultiplicityImpl(const MultiplicityImpl&) = delete;
   MultiplicityImpl& operator=(const MultiplicityImpl&) = delete;
@@ -89,6 +89,9 @@ class MultiplicityImpl {
   const std::vector<const google::protobuf::FieldDescriptor*>&
   PersonIndexFieldDescriptor() const;
 
+  // Sets the person_index field in @event to @person_index.
+  void SetPersonIndex(LabelerEvent& event, int person_index) const;
+
   // Gets fingerprint for @index using @input and @random_seed_.
   // Returns @input as is for index = 0.
   uint64_t GetFingerprintForIndex(uint64_t input, int index) const;
@@ -103,12 +106,13 @@ class MultiplicityImpl {
   double max_value_;
 
   // The field to set person index in.
-  std::vector<const google::protobuf::FieldDescriptor*> person_index_field_;
+  FieldAccessor person_index_field_;
 
   // The random seed. It is used to
   // - compute multiplicity for a given event and
   // - compute fingerprint for cloned event
   std::string random_seed_;
+  SeededFingerprinter fingerprinter_;
 };
 
 }  // namespace wfa_virtual_people
@@ -14,6 +14,7 @@
 
 #include "wfa/virtual_people/core/model/population_node_impl.h"
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <utility>
@@ -25,11 +26,11 @@
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "common_cpp/macros/macros.h"
-#include "src/farmhash.h"
 #include "wfa/virtual_people/common/demographic.pb.h"
 #include "wfa/virtual_people/common/label.pb.h"
 #include "wfa/virtual_people/common/model.pb.h"
 #include "wfa/virtual_people/core/model/model_node.h"
+#include "wfa/virtual_people/core/model/utils/path_trace.h"
 #include "wfa/virtual_people/core/model/utils/population_node_helper.h"
 #include "wfa/virtual_people/core/model/utils/virtual_person_selector.h"
 
@@ -91,9 +92,10 @@ PopulationNodeImpl::PopulationNodeImpl(
     absl::string_view random_seed)
     : ModelNode(node_config),
       virtual_person_selector_(std::move(virtual_person_selector)),
-      random_seed_(random_seed) {}
+      fingerprinter_(random_seed) {}
 
 absl::Status PopulationNodeImpl::Apply(LabelerEvent& event) const {
+  TraceNode(name());
   // Pass-1 (pool-identity) mode: a plain PopulationNode has no ranked pool to
   // announce, so it produces no output. This lets a model mix ranked and
   // unranked leaves; events routing here are labeled normally in pass-2.
@@ -114,8 +116,7 @@ absl::Status PopulationNodeImpl::Apply(LabelerEvent& event) const {
   if (!virtual_person_selector_) {
     return absl::InternalError("Failed to build population pools.");
   }
-  uint64_t seed = util::Fingerprint64(
-      absl::StrCat(random_seed_, event.acting_fingerprint()));
+  uint64_t seed = fingerprinter_.Fingerprint(event.acting_fingerprint());
   // Gets virtual person id from the pools.
   uint64_t virtual_person_id =
       virtual_person_selector_->GetVirtualPersonId(seed);
@@ -123,18 +124,14 @@ absl::Status PopulationNodeImpl::Apply(LabelerEvent& event) const {
 
   // Write to virtual_person_activity.label from quantum labels.
   if (event.has_quantum_labels()) {
-    std::string seed_suffix;
-    if (virtual_person_activity->has_virtual_person_id()) {
-      seed_suffix =
-          std::to_string(virtual_person_activity->virtual_person_id());
-    } else {
-      seed_suffix = std::to_string(event.acting_fingerprint());
-    }
+    uint64_t seed_suffix = virtual_person_activity->has_virtual_person_id()
+                               ? virtual_person_activity->virtual_person_id()
+                               : event.acting_fingerprint();
     for (const QuantumLabel& quantum_label :
          event.quantum_labels().quantum_labels()) {
-      RETURN_IF_ERROR(
-          CollapseQuantumLabel(quantum_label, seed_suffix,
-                               *virtual_person_activity->mutable_label()));
+      RETURN_IF_ERROR(quantum_label_collapser_.Collapse(
+          quantum_label, seed_suffix,
+          *virtual_person_activity->mutable_label()));
     }
   }
   // Write to virtual_person_activity.label from classic label.
@@ -17,6 +17,7 @@
 
 #include <memory>
 #include <string>
+#include <utility>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
@@ -24,12 +25,14 @@
 #include "absl/strings/string_view.h"
 #include "wfa/virtual_people/common/model.pb.h"
 #include "wfa/virtual_people/core/model/model_node.h"
+#include "wfa/virtual_people/core/model/utils/population_node_helper.h"
+#include "wfa/virtual_people/core/model/utils/seeded_fingerprinter.h"
 #include "wfa/virtual_people/core/model/utils/virtual_person_selector.h"
 
 namespace wfa_virtual_people {
 
 // The implementation of the CompiledNode with population_node set.
-class PopulationNodeImpl : public ModelNode {
+class PopulationNodeImpl final : public ModelNode {
  public:
   // Always use ModelNode::Build to get a ModelNode object.
   // Users should never call the factory function or constructor of the derived
@@ -57,11 +60,19 @@ class PopulationNodeImpl : public ModelNode {
   // population_node, and assigned to virtual_person_activities[0] in @event.
   absl::Status Apply(LabelerEvent& event) const override;
 
+  // Collapses the quantum labels in @precompiled without taking a lock. Must
+  // be called before Apply is called from any thread.
+  void UsePrecompiledQuantumLabels(
+      std::shared_ptr<const QuantumLabelCollapser::Precompiled> precompiled) {
+    quantum_label_collapser_.UsePrecompiled(std::move(precompiled));
+  }
+
  private:
   // Used to get a virtual person id. Is nullptr when the pools represent an
   // empty population pool.
   std::unique_ptr<VirtualPersonSelector> virtual_person_selector_;
-  const std::string random_seed_;
+  const SeededFingerprinter fingerprinter_;
+  QuantumLabelCollapser quantum_label_collapser_;
 };
 
 }  // namespace wfa_virtual_people
@@ -25,12 +25,12 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "common_cpp/macros/macros.h"
-#include "src/farmhash.h"
 #include "wfa/virtual_people/common/label.pb.h"
 #include "wfa/virtual_people/common/model.pb.h"
 #include "wfa/virtual_people/core/model/model_node.h"
 #include "wfa/virtual_people/core/model/utils/consistent_hash.h"
 #include "wfa/virtual_people/core/model/utils/feistel.h"
+#include "wfa/virtual_people/core/model/utils/path_trace.h"
 #include "wfa/virtual_people/core/model/utils/population_node_helper.h"
 
 namespace wfa_virtual_people {
@@ -56,13 +56,13 @@ RankedPopulationNodeImpl::Build(const CompiledNode& node_config) {
         "RankedPopulationNode total pool size must be > 0.");
   }
 
-  // JumpConsistentHash takes an int32_t bucket count, so the pool must fit in
-  // INT32_MAX. The design worst case (~1.5B) fits; guard larger pools so a
-  // future model fails loudly instead of silently wrapping to a wrong VID.
-  if (pool_size > static_cast<uint64_t>(std::numeric_limits<int32_t>::max())) {
+  // JumpConsistentHash64 takes an int64_t bucket count, so the pool must fit
+  // in INT64_MAX. Guard larger pools so a model fails loudly instead of
+  // silently wrapping to a wrong VID.
+  if (pool_size > static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
     return absl::InvalidArgumentError(absl::StrCat(
         "pool_size (", pool_size, ") exceeds the maximum supported size (",
-        std::numeric_limits<int32_t>::max(), ")."));
+        std::numeric_limits<int64_t>::max(), ")."));
   }
 
   if (config.ranked_size() > pool_size) {
@@ -81,13 +81,15 @@ RankedPopulationNodeImpl::RankedPopulationNodeImpl(
     uint64_t ranked_size, RankedPopulationNode::UnrankedMode unranked_mode,
     uint64_t pool_offset, uint64_t pool_size)
     : ModelNode(node_config),
-      random_seed_(std::move(random_seed)),
+      fingerprinter_(random_seed),
+      permutation_(ranked_size, random_seed),
       ranked_size_(ranked_size),
       unranked_mode_(unranked_mode),
       pool_offset_(pool_offset),
       pool_size_(pool_size) {}
 
 absl::Status RankedPopulationNodeImpl::Apply(LabelerEvent& event) const {
+  TraceNode(name());
   // Pass-1 mode: emit pool identity and return without assigning a VID.
   if (event.pool_identity_mode()) {
     PoolAssignment* pa = event.add_pool_assignments();
@@ -129,13 +131,10 @@ absl::Status RankedPopulationNodeImpl::Apply(LabelerEvent& event) const {
 
   if (has_rank && local_rank < ranked_size_) {
     // RANKED path: Feistel bijection — zero collisions.
-    virtual_person_id =
-        pool_offset_ + FeistelPermute(local_rank, ranked_size_, random_seed_);
+    virtual_person_id = pool_offset_ + permutation_.Permute(local_rank);
   } else {
     // UNRANKED path: hash-based (mode-dependent scope).
-    std::string seed_str =
-        absl::StrCat(random_seed_, event.acting_fingerprint());
-    uint64_t seed = util::Fingerprint64(seed_str.data(), seed_str.size());
+    uint64_t seed = fingerprinter_.Fingerprint(event.acting_fingerprint());
 
     if (unranked_mode_ == RankedPopulationNode::DISJOINT) {
       uint64_t unranked_size = pool_size_ - ranked_size_;
@@ -146,12 +145,12 @@ absl::Status RankedPopulationNodeImpl::Apply(LabelerEvent& event) const {
       }
       virtual_person_id =
           pool_offset_ + ranked_size_ +
-          JumpConsistentHash(seed, static_cast<int32_t>(unranked_size));
+          JumpConsistentHash64(seed, static_cast<int64_t>(unranked_size));
     } else if (unranked_mode_ == RankedPopulationNode::FULL_POOL) {
       // FULL_POOL: hash into the entire pool.
       virtual_person_id =
           pool_offset_ +
-          JumpConsistentHash(seed, static_cast<int32_t>(pool_size_));
+          JumpConsistentHash64(seed, static_cast<int64_t>(pool_size_));
     } else {
       return absl::InvalidArgumentError(
           "UnrankedMode must be DISJOINT or FULL_POOL.");
@@ -162,11 +161,10 @@ absl::Status RankedPopulationNodeImpl::Apply(LabelerEvent& event) const {
 
   // Collapse quantum labels from the event (same as PopulationNodeImpl).
   if (event.has_quantum_labels()) {
-    std::string seed_suffix = std::to_string(virtual_person_id);
     for (const QuantumLabel& quantum_label :
          event.quantum_labels().quantum_labels()) {
-      RETURN_IF_ERROR(CollapseQuantumLabel(quantum_label, seed_suffix,
-                                           *activity->mutable_label()));
+      RETURN_IF_ERROR(quantum_label_collapser_.Collapse(
+          quantum_label, virtual_person_id, *activity->mutable_label()));
     }
   }
   // Merge classic label from the event.
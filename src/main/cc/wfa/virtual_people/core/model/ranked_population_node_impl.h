@@ -18,18 +18,22 @@
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <utility>
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "wfa/virtual_people/common/model.pb.h"
 #include "wfa/virtual_people/core/model/model_node.h"
+#include "wfa/virtual_people/core/model/utils/feistel.h"
+#include "wfa/virtual_people/core/model/utils/population_node_helper.h"
+#include "wfa/virtual_people/core/model/utils/seeded_fingerprinter.h"
 
 namespace wfa_virtual_people {
 
 // Implementation of CompiledNode with ranked_population_node set.
 // Splits VID assignment into ranked (Feistel, collision-free) and unranked
 // (hash-based) sub-ranges. Supports DISJOINT and FULL_POOL modes.
-class RankedPopulationNodeImpl : public ModelNode {
+class RankedPopulationNodeImpl final : public ModelNode {
  public:
   static absl::StatusOr<std::unique_ptr<RankedPopulationNodeImpl>> Build(
       const CompiledNode& node_config);
@@ -46,8 +50,18 @@ class RankedPopulationNodeImpl : public ModelNode {
 
   absl::Status Apply(LabelerEvent& event) const override;
 
+  // Collapses the quantum labels in @precompiled without taking a lock. Must
+  // be called before Apply is called from any thread.
+  void UsePrecompiledQuantumLabels(
+      std::shared_ptr<const QuantumLabelCollapser::Precompiled> precompiled) {
+    quantum_label_collapser_.UsePrecompiled(std::move(precompiled));
+  }
+
  private:
-  const std::string random_seed_;
+  const SeededFingerprinter fingerprinter_;
+  // Maps the ranks in [0, ranked_size_) to the ranked VIDs.
+  const FeistelPermutation permutation_;
+  QuantumLabelCollapser quantum_label_collapser_;
   const uint64_t ranked_size_;
   const RankedPopulationNode::UnrankedMode unranked_mode_;
   const uint64_t pool_offset_;
@@ -14,6 +14,7 @@
 
 #include "wfa/virtual_people/core/model/sparse_update_matrix_impl.h"
 
+#include <cstdint>
 #include <memory>
 #include <utility>
 #include <vector>
@@ -29,7 +30,12 @@
 #include "wfa/virtual_people/common/field_filter/field_filter.h"
 #include "wfa/virtual_people/common/model.pb.h"
 #include "wfa/virtual_people/core/model/attributes_updater.h"
+#include "wfa/virtual_people/core/model/utils/column_distributions.h"
 #include "wfa/virtual_people/core/model/utils/constants.h"
+#include "wfa/virtual_people/core/model/utils/path_trace.h"
+#include "wfa/virtual_people/core/model/utils/predicate_cache.h"
+#include "wfa/virtual_people/core/model/utils/row_patch.h"
+#include "wfa/virtual_people/core/model/utils/row_patch_pool.h"
 #include "wfa/virtual_people/core/model/utils/update_matrix_helper.h"
 
 namespace wfa_virtual_people {
@@ -62,17 +68,6 @@ absl::StatusOr<std::unique_ptr<FieldFiltersMatcher>> BuildFieldFiltersMatcher(
   return FieldFiltersMatcher::Build(std::move(filters));
 }
 
-absl::StatusOr<std::unique_ptr<DistributedConsistentHashing>> BuildRowsHashing(
-    const SparseUpdateMatrix::Column& column) {
-  // Gets the probabilities distribution of the rows, and build the hashing.
-  std::vector<DistributionChoice> distribution;
-  for (int i = 0; i < column.probabilities_size(); i++) {
-    distribution.push_back(
-        DistributionChoice({i, static_cast<double>(column.probabilities(i))}));
-  }
-  return DistributedConsistentHashing::Build(std::move(distribution));
-}
-
 absl::StatusOr<std::unique_ptr<SparseUpdateMatrixImpl>>
 SparseUpdateMatrixImpl::Build(const SparseUpdateMatrix& config) {
   if (config.columns_size() == 0) {
@@ -118,23 +113,26 @@ SparseUpdateMatrixImpl::Build(const SparseUpdateMatrix& config) {
     }
   }
 
-  // Converts the probabilities distribution of each column to
-  // DistributedConsistentHashing.
-  std::vector<std::unique_ptr<DistributedConsistentHashing>> row_hashings;
-  // Keeps the rows of each column.
-  std::vector<std::vector<LabelerEvent>> rows;
+  // Gets the probabilities distribution of each column. The rows are interned,
+  // so that each distinct row is compiled and stored once.
+  std::vector<ColumnChoice> choices;
+  std::vector<uint32_t> column_offsets;
+  column_offsets.reserve(config.columns_size() + 1);
+  RowPatchPool pool;
   for (const SparseUpdateMatrix::Column& column : config.columns()) {
-    row_hashings.emplace_back();
-    ASSIGN_OR_RETURN(row_hashings.back(), BuildRowsHashing(column));
-
-    if (!row_hashings.back()) {
-      return absl::InternalError(
-          "DistributedConsistentHashing::Build should never return NULL.");
+    column_offsets.push_back(choices.size());
+    for (int row_index = 0; row_index < column.rows_size(); ++row_index) {
+      ASSIGN_OR_RETURN(int32_t row_id, pool.Add(column.rows(row_index)));
+      choices.push_back(ColumnChoice(
+          {row_index, row_id,
+           static_cast<double>(column.probabilities(row_index))}));
     }
-
-    // Gets the rows.
-    rows.emplace_back(column.rows().begin(), column.rows().end());
   }
+  std::vector<std::shared_ptr<const RowPatch>> rows = pool.patches();
+  column_offsets.push_back(choices.size());
+  ASSIGN_OR_RETURN(std::unique_ptr<ColumnDistributions> row_distributions,
+                   ColumnDistributions::Build(std::move(choices),
+                                              std::move(column_offsets)));
 
   PassThroughNonMatches pass_through_non_matches =
       config.pass_through_non_matches() ? PassThroughNonMatches::kYes
@@ -142,16 +140,17 @@ SparseUpdateMatrixImpl::Build(const SparseUpdateMatrix& config) {
 
   return absl::make_unique<SparseUpdateMatrixImpl>(
       std::move(hash_matcher), std::move(filters_matcher),
-      std::move(row_hashings), config.random_seed(), std::move(rows),
+      std::move(row_distributions), config.random_seed(), std::move(rows),
       pass_through_non_matches);
 }
 
 absl::Status SparseUpdateMatrixImpl::Update(LabelerEvent& event) const {
   ASSIGN_OR_RETURN(MatrixIndexes indexes,
                    SelectFromMatrix(hash_matcher_.get(), filters_matcher_.get(),
-                                    row_hashings_, random_seed_, event));
+                                    *row_distributions_, random_seed_, event));
   int column_index = indexes.column_index;
   int row_index = indexes.row_index;
+  TraceUpdate(row_index, column_index);
   if (column_index == kNoMatchingIndex) {
     if (pass_through_non_matches_ == PassThroughNonMatches::kYes) {
       return absl::OkStatus();
@@ -161,15 +160,26 @@ absl::Status SparseUpdateMatrixImpl::Update(LabelerEvent& event) const {
     }
   }
 
-  if (column_index < 0 || column_index >= rows_.size()) {
-    return absl::InternalError("The returned column index is out of range.");
-  }
-  if (row_index < 0 || row_index >= rows_[column_index].size()) {
+  if (indexes.row_id < 0 || indexes.row_id >= rows_.size()) {
     return absl::InternalError("The returned row index is out of range.");
   }
 
-  event.MergeFrom(rows_[column_index][row_index]);
+  rows_[indexes.row_id]->Apply(event);
   return absl::OkStatus();
 }
 
+EventFieldMask SparseUpdateMatrixImpl::WrittenFields() const {
+  EventFieldMask written_fields = 0;
+  for (const std::shared_ptr<const RowPatch>& row : rows_) {
+    written_fields |= GetSetEventFields(row->row());
+  }
+  return written_fields;
+}
+
+void SparseUpdateMatrixImpl::InternRows(RowPatchPool& pool) {
+  for (std::shared_ptr<const RowPatch>& row : rows_) {
+    row = pool.Intern(std::move(row));
+  }
+}
+
 }  // namespace wfa_virtual_people
@@ -22,11 +22,12 @@
 #include "absl/status/statusor.h"
 #include "wfa/virtual_people/common/model.pb.h"
 #include "wfa/virtual_people/core/model/model_node.h"
+#include "wfa/virtual_people/core/model/utils/path_trace.h"
 
 namespace wfa_virtual_people {
 
 // The implementation of the CompiledNode with stop_node set.
-class StopNodeImpl : public ModelNode {
+class StopNodeImpl final : public ModelNode {
  public:
   // Always use ModelNode::Build to get a ModelNode object.
   // Users should never call the factory function or constructor of the derived
@@ -46,6 +47,7 @@ class StopNodeImpl : public ModelNode {
 
   // No operation is needed when applying a StopNode.
   absl::Status Apply(LabelerEvent& event) const override {
+    TraceNode(name());
     return absl::OkStatus();
   }
 };
@@ -14,6 +14,7 @@
 
 #include "wfa/virtual_people/core/model/update_matrix_impl.h"
 
+#include <cstdint>
 #include <memory>
 #include <utility>
 #include <vector>
@@ -29,7 +30,12 @@
 #include "wfa/virtual_people/common/field_filter/field_filter.h"
 #include "wfa/virtual_people/common/model.pb.h"
 #include "wfa/virtual_people/core/model/attributes_updater.h"
+#include "wfa/virtual_people/core/model/utils/column_distributions.h"
 #include "wfa/virtual_people/core/model/utils/constants.h"
+#include "wfa/virtual_people/core/model/utils/path_trace.h"
+#include "wfa/virtual_people/core/model/utils/predicate_cache.h"
+#include "wfa/virtual_people/core/model/utils/row_patch.h"
+#include "wfa/virtual_people/core/model/utils/row_patch_pool.h"
 #include "wfa/virtual_people/core/model/utils/update_matrix_helper.h"
 
 namespace wfa_virtual_people {
@@ -85,24 +91,34 @@ absl::StatusOr<std::unique_ptr<UpdateMatrixImpl>> UpdateMatrixImpl::Build(
                      BuildFieldFiltersMatcher(config.columns()));
   }
 
-  // Converts the probabilities distribution of each column to
-  // DistributedConsistentHashing.
-  std::vector<std::unique_ptr<DistributedConsistentHashing>> row_hashings;
+  // Gets the probabilities distribution of each column. The probabilities
+  // are stored row by row in @config.
+  std::vector<ColumnChoice> choices;
+  choices.reserve(config.probabilities_size());
+  std::vector<uint32_t> column_offsets;
+  column_offsets.reserve(column_count + 1);
   for (int column_index = 0; column_index < column_count; ++column_index) {
-    // Gets the probabilities distribution of the column, and build the hashing.
-    std::vector<DistributionChoice> distribution;
+    column_offsets.push_back(choices.size());
     for (int row_index = 0; row_index < row_count; ++row_index) {
       float probability =
           config.probabilities(row_index * column_count + column_index);
-      distribution.push_back(
-          DistributionChoice({row_index, static_cast<double>(probability)}));
+      choices.push_back(ColumnChoice(
+          {row_index, row_index, static_cast<double>(probability)}));
     }
-    row_hashings.emplace_back();
-    ASSIGN_OR_RETURN(row_hashings.back(), DistributedConsistentHashing::Build(
-                                              std::move(distribution)));
   }
-
-  std::vector<LabelerEvent> rows = {config.rows().begin(), config.rows().end()};
+  column_offsets.push_back(choices.size());
+  ASSIGN_OR_RETURN(std::unique_ptr<ColumnDistributions> row_distributions,
+                   ColumnDistributions::Build(std::move(choices),
+                                              std::move(column_offsets)));
+
+  // Equal rows are compiled once.
+  RowPatchPool pool;
+  std::vector<std::shared_ptr<const RowPatch>> rows;
+  rows.reserve(row_count);
+  for (const LabelerEvent& row : config.rows()) {
+    ASSIGN_OR_RETURN(int32_t row_id, pool.Add(row));
+    rows.push_back(pool.patches()[row_id]);
+  }
 
   PassThroughNonMatches pass_through_non_matches =
       config.pass_through_non_matches() ? PassThroughNonMatches::kYes
@@ -110,14 +126,15 @@ absl::StatusOr<std::unique_ptr<UpdateMatrixImpl>> UpdateMatrixImpl::Build(
 
   return absl::make_unique<UpdateMatrixImpl>(
       std::move(hash_matcher), std::move(filters_matcher),
-      std::move(row_hashings), config.random_seed(), std::move(rows),
+      std::move(row_distributions), config.random_seed(), std::move(rows),
       pass_through_non_matches);
 }
 
 absl::Status UpdateMatrixImpl::Update(LabelerEvent& event) const {
   ASSIGN_OR_RETURN(MatrixIndexes indexes,
                    SelectFromMatrix(hash_matcher_.get(), filters_matcher_.get(),
-                                    row_hashings_, random_seed_, event));
+                                    *row_distributions_, random_seed_, event));
+  TraceUpdate(indexes.row_index, indexes.column_index);
 
   if (indexes.column_index == kNoMatchingIndex) {
     if (pass_through_non_matches_ == PassThroughNonMatches::kYes) {
@@ -133,8 +150,22 @@ absl::Status UpdateMatrixImpl::Update(LabelerEvent& event) const {
     return absl::InternalError("The returned row index is out of range.");
   }
 
-  event.MergeFrom(rows_[row_index]);
+  rows_[row_index]->Apply(event);
   return absl::OkStatus();
 }
 
+EventFieldMask UpdateMatrixImpl::WrittenFields() const {
+  EventFieldMask written_fields = 0;
+  for (const std::shared_ptr<const RowPatch>& row : rows_) {
+    written_fields |= GetSetEventFields(row->row());
+  }
+  return written_fields;
+}
+
+void UpdateMatrixImpl::InternRows(RowPatchPool& pool) {
+  for (std::shared_ptr<const RowPatch>& row : rows_) {
+    row = pool.Intern(std::move(row));
+  }
+}
+
 }  // namespace wfa_virtual_people
@@ -25,9 +25,12 @@
 #include "absl/strings/string_view.h"
 #include "wfa/virtual_people/common/model.pb.h"
 #include "wfa/virtual_people/core/model/attributes_updater.h"
-#include "wfa/virtual_people/core/model/utils/distributed_consistent_hashing.h"
+#include "wfa/virtual_people/core/model/utils/column_distributions.h"
 #include "wfa/virtual_people/core/model/utils/field_filters_matcher.h"
 #include "wfa/virtual_people/core/model/utils/hash_field_mask_matcher.h"
+#include "wfa/virtual_people/core/model/utils/predicate_cache.h"
+#include "wfa/virtual_people/core/model/utils/row_patch.h"
+#include "wfa/virtual_people/core/model/utils/row_patch_pool.h"
 
 namespace wfa_virtual_people {
 
@@ -44,8 +47,8 @@ class UpdateMatrixImpl : public AttributesUpdaterInterface {
   //   In @config, the probabilities count does not equal to rows count
   //     multiplies columns count.
   //   Fails to build FieldFilter from any column.
-  //   Fails to build DistributedConsistentHashing from the probabilities
-  //     distribution of any column.
+  //   The probabilities distribution of any column is invalid, i.e. it has
+  //     negative probabilities, or does not sum to 1.
   static absl::StatusOr<std::unique_ptr<UpdateMatrixImpl>> Build(
       const UpdateMatrix& config);
 
@@ -54,12 +57,13 @@ class UpdateMatrixImpl : public AttributesUpdaterInterface {
   explicit UpdateMatrixImpl(
       std::unique_ptr<HashFieldMaskMatcher> hash_matcher,
       std::unique_ptr<FieldFiltersMatcher> filters_matcher,
-      std::vector<std::unique_ptr<DistributedConsistentHashing>>&& row_hashings,
-      absl::string_view random_seed, std::vector<LabelerEvent>&& rows,
+      std::unique_ptr<ColumnDistributions> row_distributions,
+      absl::string_view random_seed,
+      std::vector<std::shared_ptr<const RowPatch>>&& rows,
       PassThroughNonMatches pass_through_non_matches)
       : hash_matcher_(std::move(hash_matcher)),
         filters_matcher_(std::move(filters_matcher)),
-        row_hashings_(std::move(row_hashings)),
+        row_distributions_(std::move(row_distributions)),
         random_seed_(random_seed),
         rows_(std::move(rows)),
         pass_through_non_matches_(pass_through_non_matches) {}
@@ -77,6 +81,10 @@ class UpdateMatrixImpl : public AttributesUpdaterInterface {
   // pass_through_non_matches_ is kNo.
   absl::Status Update(LabelerEvent& event) const override;
 
+  EventFieldMask WrittenFields() const override;
+
+  void InternRows(RowPatchPool& pool) override;
+
  private:
   // The matcher used to match input events to the column events when using hash
   // field mask.
@@ -84,14 +92,13 @@ class UpdateMatrixImpl : public AttributesUpdaterInterface {
   // The matcher used to match input events to the column conditions when not
   // using hash field mask.
   std::unique_ptr<FieldFiltersMatcher> filters_matcher_;
-  // Each entry of the vector represents a hashing based on the probability
-  // distribution of a column.
-  // The size of the vector is the columns count.
-  std::vector<std::unique_ptr<DistributedConsistentHashing>> row_hashings_;
+  // The probabilities distributions of the columns, used to select the row.
+  std::unique_ptr<ColumnDistributions> row_distributions_;
   // The seed used in hashing.
   std::string random_seed_;
   // All the rows, of which the selected row will be merged to the input event.
-  std::vector<LabelerEvent> rows_;
+  // Equal rows share the same patch.
+  std::vector<std::shared_ptr<const RowPatch>> rows_;
   // When calling Update, if no column matches, returns OkStatus if
   // pass_through_non_matches_ is kYes, otherwise returns error status.
   PassThroughNonMatches pass_through_non_matches_;
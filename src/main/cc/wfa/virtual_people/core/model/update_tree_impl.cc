@@ -16,6 +16,7 @@
 
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/memory/memory.h"
@@ -24,7 +25,9 @@
 #include "common_cpp/macros/macros.h"
 #include "wfa/virtual_people/common/model.pb.h"
 #include "wfa/virtual_people/core/model/attributes_updater.h"
+#include "wfa/virtual_people/core/model/branch_node_impl.h"
 #include "wfa/virtual_people/core/model/model_node.h"
+#include "wfa/virtual_people/core/model/utils/row_patch_pool.h"
 
 namespace wfa_virtual_people {
 
@@ -45,4 +48,19 @@ absl::Status UpdateTreeImpl::Update(LabelerEvent& event) const {
   return root_->Apply(event);
 }
 
+void UpdateTreeImpl::InternRows(RowPatchPool& pool) {
+  std::vector<ModelNode*> stack = {root_.get()};
+  while (!stack.empty()) {
+    auto* branch = dynamic_cast<BranchNodeImpl*>(stack.back());
+    stack.pop_back();
+    if (!branch) {
+      continue;
+    }
+    branch->InternRows(pool);
+    for (const std::unique_ptr<ModelNode>& child : branch->child_nodes()) {
+      stack.push_back(child.get());
+    }
+  }
+}
+
 }  // namespace wfa_virtual_people
@@ -24,6 +24,7 @@
 #include "wfa/virtual_people/common/model.pb.h"
 #include "wfa/virtual_people/core/model/attributes_updater.h"
 #include "wfa/virtual_people/core/model/model_node.h"
+#include "wfa/virtual_people/core/model/utils/row_patch_pool.h"
 
 namespace wfa_virtual_people {
 
@@ -49,6 +50,10 @@ class UpdateTreeImpl : public AttributesUpdaterInterface {
   // the @event.
   absl::Status Update(LabelerEvent& event) const override;
 
+  // Interns the rows of the updaters of all the branch nodes in the attached
+  // model tree.
+  void InternRows(RowPatchPool& pool) override;
+
  private:
   std::unique_ptr<ModelNode> root_;
 };
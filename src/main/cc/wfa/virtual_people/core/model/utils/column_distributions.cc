@@ -0,0 +1,140 @@
+// Copyright 2026 The Cross-Media Measurement Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "wfa/virtual_people/core/model/utils/column_distributions.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/container/fixed_array.h"
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "wfa/virtual_people/core/model/utils/hash.h"
+
+namespace wfa_virtual_people {
+
+namespace {
+
+constexpr double kNormalizeError = 0.0000001;
+
+// The seed prefix of DistributedConsistentHashing.
+constexpr absl::string_view kSeedPrefix = "consistent-hashing-";
+
+// The number of decimal digits of the max uint64_t.
+constexpr size_t kMaxUint64Digits = 20;
+
+// The size of the longest seed suffix "-<choice_id>".
+constexpr size_t kMaxSeedSuffixSize = 12;
+
+// The full seeds up to this size are built on the stack.
+constexpr size_t kInlineSeedSize = 256;
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<ColumnDistributions>> ColumnDistributions::Build(
+    std::vector<ColumnChoice>&& choices,
+    std::vector<uint32_t>&& column_offsets) {
+  if (column_offsets.empty() || column_offsets.front() != 0 ||
+      column_offsets.back() != choices.size() ||
+      !std::is_sorted(column_offsets.begin(), column_offsets.end())) {
+    return absl::InvalidArgumentError("Invalid column offsets.");
+  }
+
+  // Normalizes the probabilities of each column, and drops the choices with
+  // zero probability in place.
+  size_t kept_count = 0;
+  for (size_t column = 0; column + 1 < column_offsets.size(); ++column) {
+    uint32_t begin = column_offsets[column];
+    uint32_t end = column_offsets[column + 1];
+    if (begin == end) {
+      return absl::InvalidArgumentError("The given distribution is empty.");
+    }
+    double probabilities_sum = 0.0;
+    for (uint32_t i = begin; i < end; ++i) {
+      if (choices[i].probability < 0) {
+        return absl::InvalidArgumentError("Negative probability is provided.");
+      }
+      probabilities_sum += choices[i].probability;
+    }
+    if (probabilities_sum < 1 - kNormalizeError ||
+        probabilities_sum > 1 + kNormalizeError) {
+      return absl::InvalidArgumentError("Probabilities do not sum to 1.");
+    }
+
+    column_offsets[column] = kept_count;
+    for (uint32_t i = begin; i < end; ++i) {
+      if (i == begin || choices[i].probability > 0) {
+        ColumnChoice& choice = choices[kept_count++];
+        choice = choices[i];
+        choice.probability /= probabilities_sum;
+      }
+    }
+  }
+  column_offsets.back() = kept_count;
+  choices.resize(kept_count);
+  choices.shrink_to_fit();
+
+  return absl::make_unique<ColumnDistributions>(std::move(choices),
+                                                std::move(column_offsets));
+}
+
+// The same algorithm as DistributedConsistentHashing::Hash.
+const ColumnChoice& ColumnDistributions::Hash(
+    int column_index, absl::string_view seed_prefix,
+    uint64_t acting_fingerprint) const {
+  absl::FixedArray<char, kInlineSeedSize> full_seed(
+      kSeedPrefix.size() + seed_prefix.size() + kMaxUint64Digits +
+      kMaxSeedSuffixSize);
+  char* end = std::copy(kSeedPrefix.begin(), kSeedPrefix.end(),
+                        full_seed.begin());
+  end = std::copy(seed_prefix.begin(), seed_prefix.end(), end);
+  absl::AlphaNum fingerprint(acting_fingerprint);
+  end = std::copy(fingerprint.data(), fingerprint.data() + fingerprint.size(),
+                  end);
+  *end++ = '-';
+  size_t prefix_size = end - full_seed.data();
+
+  const ColumnChoice* begin = choices_.data() + column_offsets_[column_index];
+  const ColumnChoice* last =
+      choices_.data() + column_offsets_[column_index + 1];
+  const ColumnChoice* selected = begin;
+  double choice_xi = std::numeric_limits<double>::max();
+  for (const ColumnChoice* choice = begin; choice != last; ++choice) {
+    absl::AlphaNum choice_id(choice->choice_id);
+    std::copy(choice_id.data(), choice_id.data() + choice_id.size(), end);
+    double xi = ExpHash(absl::string_view(full_seed.data(),
+                                          prefix_size + choice_id.size())) /
+                choice->probability;
+    if (choice_xi > xi) {
+      selected = choice;
+      choice_xi = xi;
+    }
+  }
+  return *selected;
+}
+
+size_t ColumnDistributions::MemoryUsage() const {
+  return sizeof(*this) + choices_.capacity() * sizeof(ColumnChoice) +
+         column_offsets_.capacity() * sizeof(uint32_t);
+}
+
+}  // namespace wfa_virtual_people
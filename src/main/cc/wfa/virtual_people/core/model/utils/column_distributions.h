@@ -0,0 +1,99 @@
+// Copyright 2026 The Cross-Media Measurement Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_MODEL_UTILS_COLUMN_DISTRIBUTIONS_H_
+#define SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_MODEL_UTILS_COLUMN_DISTRIBUTIONS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+
+namespace wfa_virtual_people {
+
+// A choice in the distribution of a column.
+struct ColumnChoice {
+  // The id of the choice in the consistent hashing, as
+  // DistributionChoice.choice_id.
+  int32_t choice_id;
+  // The row selected when the choice is selected.
+  int32_t row_id;
+  double probability;
+};
+
+// The consistent hashing of the distributions of all the columns of an update
+// matrix.
+//
+// The choices of all the columns are kept in one array, with the choices of
+// each column stored contiguously, and the offset of each column in another
+// array. Choices with zero probability, which are never selected, are not kept,
+// except the first choice of each column, which is returned when no choice is
+// selected, as DistributedConsistentHashing returns choice 0. This replaces a
+// DistributedConsistentHashing object per column, with the same results.
+class ColumnDistributions {
+ public:
+  // Always use Build to get a ColumnDistributions object. Users should not
+  // call the constructor below directly.
+  //
+  // The choices of column i are @choices[@column_offsets[i]] to
+  // @choices[@column_offsets[i + 1] - 1]. The probabilities of each column will
+  // be normalized.
+  //
+  // Returns error status if any of the following happens:
+  //   @column_offsets is empty, or is not sorted, or its last entry is not the
+  //     size of @choices.
+  //   The distribution of any column is empty.
+  //   Any probability in @choices is negative.
+  //   Sum of probabilities of any column is not 1.
+  static absl::StatusOr<std::unique_ptr<ColumnDistributions>> Build(
+      std::vector<ColumnChoice>&& choices,
+      std::vector<uint32_t>&& column_offsets);
+
+  // Never call the constructor directly.
+  explicit ColumnDistributions(std::vector<ColumnChoice>&& choices,
+                               std::vector<uint32_t>&& column_offsets)
+      : choices_(std::move(choices)),
+        column_offsets_(std::move(column_offsets)) {}
+
+  ColumnDistributions(const ColumnDistributions&) = delete;
+  ColumnDistributions& operator=(const ColumnDistributions&) = delete;
+
+  int column_count() const {
+    return static_cast<int>(column_offsets_.size()) - 1;
+  }
+
+  // Returns the choice selected from the distribution of @column_index. The
+  // choice is selected in the same way as
+  // DistributedConsistentHashing::Hash(@seed_prefix, @acting_fingerprint) of
+  // the distribution of (choice_id, probability) of the column.
+  //
+  // @column_index must be in [0, column_count() - 1].
+  const ColumnChoice& Hash(int column_index, absl::string_view seed_prefix,
+                           uint64_t acting_fingerprint) const;
+
+  // Returns the number of bytes held by this object.
+  size_t MemoryUsage() const;
+
+ private:
+  std::vector<ColumnChoice> choices_;
+  std::vector<uint32_t> column_offsets_;
+};
+
+}  // namespace wfa_virtual_people
+
+#endif  // SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_MODEL_UTILS_COLUMN_DISTRIBUTIONS_H_
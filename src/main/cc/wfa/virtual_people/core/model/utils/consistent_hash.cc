@@ -14,10 +14,36 @@
 
 #include "wfa/virtual_people/core/model/utils/consistent_hash.h"
 
+#include <cstddef>
 #include <cstdint>
+#include <limits>
+
+#include "absl/types/span.h"
 
 namespace wfa_virtual_people {
 
+namespace {
+
+constexpr uint64_t kMultiplier = 2862933555777941757ULL;
+constexpr double kTwoPow31 = static_cast<double>(1LL << 31);
+constexpr double kTwoPow63 = 0x1p63;
+
+// The number of keys stepped together by JumpConsistentHashBatch.
+constexpr size_t kLanes = 8;
+
+// Returns the next candidate bucket after bucket @b, with the already advanced
+// @key. Same as the update of j in JumpConsistentHash, but saturates at
+// INT64_MAX instead of overflowing, which ends the loop for any number of
+// buckets.
+inline int64_t NextBucket(int64_t b, uint64_t key) {
+  double next = static_cast<double>(b + 1) *
+                (kTwoPow31 / static_cast<double>((key >> 33) + 1));
+  return next >= kTwoPow63 ? std::numeric_limits<int64_t>::max()
+                           : static_cast<int64_t>(next);
+}
+
+}  // namespace
+
 // This implementation is a copy and formatting of Figure 1 on page 2 in the
 // published paper:
 //   https://arxiv.org/pdf/1406.2294.pdf
@@ -33,4 +59,48 @@ int32_t JumpConsistentHash(uint64_t key, int32_t num_buckets) {
   return b;
 }
 
+int64_t JumpConsistentHash64(uint64_t key, int64_t num_buckets) {
+  int64_t b = -1;
+  for (int64_t j = 0; j < num_buckets;) {
+    b = j;
+    key = key * kMultiplier + 1;
+    j = NextBucket(b, key);
+  }
+  return b;
+}
+
+void JumpConsistentHashBatch(absl::Span<const uint64_t> keys,
+                             int64_t num_buckets, absl::Span<int64_t> out) {
+  size_t i = 0;
+  for (; i + kLanes <= keys.size(); i += kLanes) {
+    uint64_t key[kLanes];
+    int64_t b[kLanes];
+    int64_t j[kLanes];
+    for (size_t lane = 0; lane < kLanes; ++lane) {
+      key[lane] = keys[i + lane];
+      b[lane] = -1;
+      j[lane] = 0;
+    }
+    // Steps all the lanes until every lane is done. The lanes which are done
+    // keep their values.
+    bool any_running = true;
+    while (any_running) {
+      any_running = false;
+      for (size_t lane = 0; lane < kLanes; ++lane) {
+        bool running = j[lane] < num_buckets;
+        b[lane] = running ? j[lane] : b[lane];
+        key[lane] = running ? key[lane] * kMultiplier + 1 : key[lane];
+        j[lane] = running ? NextBucket(b[lane], key[lane]) : j[lane];
+        any_running |= running;
+      }
+    }
+    for (size_t lane = 0; lane < kLanes; ++lane) {
+      out[i + lane] = b[lane];
+    }
+  }
+  for (; i < keys.size(); ++i) {
+    out[i] = JumpConsistentHash64(keys[i], num_buckets);
+  }
+}
+
 }  // namespace wfa_virtual_people
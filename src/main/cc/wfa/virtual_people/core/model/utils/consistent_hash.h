@@ -17,6 +17,8 @@
 
 #include <cstdint>
 
+#include "absl/types/span.h"
+
 namespace wfa_virtual_people {
 
 // Applies consistent hashing, to map the input key to one of the buckets.
@@ -27,6 +29,18 @@ namespace wfa_virtual_people {
 //   https://arxiv.org/pdf/1406.2294.pdf
 int32_t JumpConsistentHash(uint64_t key, int32_t num_buckets);
 
+// Same as JumpConsistentHash, but supports up to INT64_MAX buckets. The output
+// is the same as JumpConsistentHash when @num_buckets fits in int32_t.
+int64_t JumpConsistentHash64(uint64_t key, int64_t num_buckets);
+
+// Sets @out[i] to JumpConsistentHash64(@keys[i], @num_buckets). @out must have
+// the same size as @keys.
+//
+// The keys are processed in groups of lanes, stepping all the lanes of a group
+// together, so that the compiler can vectorize the steps.
+void JumpConsistentHashBatch(absl::Span<const uint64_t> keys,
+                             int64_t num_buckets, absl::Span<int64_t> out);
+
 }  // namespace wfa_virtual_people
 
 #endif  // SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_MODEL_UTILS_CONSISTENT_HASH_H_
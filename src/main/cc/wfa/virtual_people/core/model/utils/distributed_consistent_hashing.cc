@@ -14,24 +14,34 @@
 
 #include "wfa/virtual_people/core/model/utils/distributed_consistent_hashing.h"
 
-#include <cmath>
+#include <algorithm>
+#include <array>
+#include <cstddef>
 #include <limits>
 #include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/container/fixed_array.h"
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
-#include "absl/strings/str_format.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "src/farmhash.h"
 #include "wfa/virtual_people/core/model/utils/hash.h"
 
 namespace wfa_virtual_people {
 
 constexpr double kNormalizeError = 0.0000001;
 
+constexpr absl::string_view kSeedPrefix = "consistent-hashing-";
+
+// The number of decimal digits of the max uint64_t.
+constexpr size_t kMaxUint64Digits = 20;
+
 absl::StatusOr<std::unique_ptr<DistributedConsistentHashing>>
 DistributedConsistentHashing::Build(
     std::vector<DistributionChoice>&& distribution) {
@@ -60,23 +70,59 @@ DistributedConsistentHashing::Build(
       std::move(distribution));
 }
 
-std::string GetFullSeed(absl::string_view random_seed, const int32_t choice) {
-  return absl::StrFormat("consistent-hashing-%s-%d", random_seed, choice);
-}
-
-double ComputeXi(absl::string_view random_seed, const int32_t choice,
-                 const double probability) {
-  return ExpHash(GetFullSeed(random_seed, choice)) / probability;
+DistributedConsistentHashing::DistributedConsistentHashing(
+    std::vector<DistributionChoice>&& distribution)
+    : distribution_(std::move(distribution)) {
+  seed_suffixes_.reserve(distribution_.size());
+  for (const DistributionChoice& choice : distribution_) {
+    seed_suffixes_.push_back(absl::StrCat("-", choice.choice_id));
+    max_seed_suffix_size_ =
+        std::max(max_seed_suffix_size_, seed_suffixes_.back().size());
+  }
 }
 
 // A C++ version of the Python function ConsistentHashing.hash in
 // https://github.com/world-federation-of-advertisers/virtual_people_examples/blob/main/notebooks/Consistent_Hashing.ipynb
 int32_t DistributedConsistentHashing::Hash(
     absl::string_view random_seed) const {
+  // The full seed of each choice is
+  // "consistent-hashing-<random_seed>-<choice_id>". The common prefix is
+  // written once, and only the suffix is replaced for each choice.
+  size_t prefix_size = kSeedPrefix.size() + random_seed.size();
+  absl::FixedArray<char, kInlineSeedSize> full_seed(prefix_size +
+                                                    max_seed_suffix_size_);
+  char* end = std::copy(kSeedPrefix.begin(), kSeedPrefix.end(),
+                        full_seed.begin());
+  std::copy(random_seed.begin(), random_seed.end(), end);
+  return HashFullSeed(full_seed.data(), prefix_size);
+}
+
+int32_t DistributedConsistentHashing::Hash(absl::string_view seed_prefix,
+                                           uint64_t acting_fingerprint) const {
+  absl::FixedArray<char, kInlineSeedSize> full_seed(
+      kSeedPrefix.size() + seed_prefix.size() + kMaxUint64Digits +
+      max_seed_suffix_size_);
+  char* end = std::copy(kSeedPrefix.begin(), kSeedPrefix.end(),
+                        full_seed.begin());
+  end = std::copy(seed_prefix.begin(), seed_prefix.end(), end);
+  absl::AlphaNum fingerprint(acting_fingerprint);
+  end = std::copy(fingerprint.data(), fingerprint.data() + fingerprint.size(),
+                  end);
+  return HashFullSeed(full_seed.data(), end - full_seed.data());
+}
+
+int32_t DistributedConsistentHashing::HashFullSeed(char* full_seed,
+                                                   size_t prefix_size) const {
+  char* suffix = full_seed + prefix_size;
   int32_t choice_id = 0;
   double choice_xi = std::numeric_limits<double>::max();
-  for (const auto& choice : distribution_) {
-    double xi = ComputeXi(random_seed, choice.choice_id, choice.probability);
+  for (size_t i = 0; i < distribution_.size(); ++i) {
+    const DistributionChoice& choice = distribution_[i];
+    const std::string& seed_suffix = seed_suffixes_[i];
+    std::copy(seed_suffix.begin(), seed_suffix.end(), suffix);
+    double xi = ExpHash(absl::string_view(full_seed,
+                                          prefix_size + seed_suffix.size())) /
+                choice.probability;
     if (choice_xi > xi) {
       choice_id = choice.choice_id;
       choice_xi = xi;
@@ -85,4 +131,66 @@ int32_t DistributedConsistentHashing::Hash(
   return choice_id;
 }
 
+absl::Status DistributedConsistentHashing::HashBatch(
+    absl::Span<const uint64_t> acting_fingerprints,
+    absl::string_view seed_prefix, absl::Span<int32_t> out) const {
+  if (acting_fingerprints.size() != out.size()) {
+    return absl::InvalidArgumentError(
+        "The sizes of the fingerprints and the output do not match.");
+  }
+  if (acting_fingerprints.empty()) {
+    return absl::OkStatus();
+  }
+
+  // Each event of a block has its own slot of @slot_size bytes in
+  // @full_seeds, holding "consistent-hashing-<seed_prefix><fingerprint>",
+  // followed by the suffix of the current choice.
+  size_t slot_size = kSeedPrefix.size() + seed_prefix.size() +
+                     kMaxUint64Digits + max_seed_suffix_size_;
+  size_t block_size = std::min(kHashBatchBlockSize, out.size());
+  std::vector<char> full_seeds(slot_size * block_size);
+  std::array<size_t, kHashBatchBlockSize> prefix_sizes;
+  std::array<double, kHashBatchBlockSize> choice_xis;
+  std::array<uint64_t, kHashBatchBlockSize> seed_fingerprints;
+  std::array<double, kHashBatchBlockSize> exp_hashes;
+
+  for (size_t begin = 0; begin < out.size(); begin += block_size) {
+    size_t count = std::min(block_size, out.size() - begin);
+    for (size_t i = 0; i < count; ++i) {
+      char* slot = full_seeds.data() + i * slot_size;
+      char* end = std::copy(kSeedPrefix.begin(), kSeedPrefix.end(), slot);
+      end = std::copy(seed_prefix.begin(), seed_prefix.end(), end);
+      absl::AlphaNum fingerprint(acting_fingerprints[begin + i]);
+      end = std::copy(fingerprint.data(),
+                      fingerprint.data() + fingerprint.size(), end);
+      prefix_sizes[i] = end - slot;
+      choice_xis[i] = std::numeric_limits<double>::max();
+      out[begin + i] = 0;
+    }
+    // The choices are visited in the same order as Hash, so ties are broken
+    // the same way.
+    for (size_t c = 0; c < distribution_.size(); ++c) {
+      const DistributionChoice& choice = distribution_[c];
+      const std::string& seed_suffix = seed_suffixes_[c];
+      for (size_t i = 0; i < count; ++i) {
+        char* slot = full_seeds.data() + i * slot_size;
+        std::copy(seed_suffix.begin(), seed_suffix.end(),
+                  slot + prefix_sizes[i]);
+        seed_fingerprints[i] =
+            util::Fingerprint64(slot, prefix_sizes[i] + seed_suffix.size());
+      }
+      ExpHashBatch(absl::MakeConstSpan(seed_fingerprints.data(), count),
+                   absl::MakeSpan(exp_hashes.data(), count));
+      for (size_t i = 0; i < count; ++i) {
+        double xi = exp_hashes[i] / choice.probability;
+        if (choice_xis[i] > xi) {
+          out[begin + i] = choice.choice_id;
+          choice_xis[i] = xi;
+        }
+      }
+    }
+  }
+  return absl::OkStatus();
+}
+
 }  // namespace wfa_virtual_people
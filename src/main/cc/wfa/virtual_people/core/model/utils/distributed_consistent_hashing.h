@@ -15,12 +15,17 @@
 #ifndef SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_MODEL_UTILS_DISTRIBUTED_CONSISTENT_HASHING_H_
 #define SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_MODEL_UTILS_DISTRIBUTED_CONSISTENT_HASHING_H_
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 
 namespace wfa_virtual_people {
 
@@ -53,18 +58,52 @@ class DistributedConsistentHashing {
 
   // Never call the constructor directly.
   explicit DistributedConsistentHashing(
-      std::vector<DistributionChoice>&& distribution)
-      : distribution_(std::move(distribution)) {}
+      std::vector<DistributionChoice>&& distribution);
 
   DistributedConsistentHashing(const DistributedConsistentHashing&) = delete;
   DistributedConsistentHashing& operator=(const DistributedConsistentHashing&) =
       delete;
 
   // Returns the selected choice id.
+  //
+  // Does not allocate memory, unless @random_seed is longer than
+  // kInlineSeedSize.
   int32_t Hash(absl::string_view random_seed) const;
 
+  // Same as Hash(absl::StrCat(@seed_prefix, @acting_fingerprint)), without
+  // building the string.
+  int32_t Hash(absl::string_view seed_prefix,
+               uint64_t acting_fingerprint) const;
+
+  // Hashes a batch of events. Same as setting @out[i] to
+  //   Hash(absl::StrCat(@seed_prefix, @acting_fingerprints[i]))
+  // for each i, but the events are processed in blocks, with each choice
+  // evaluated for all the events of a block before moving to the next choice.
+  //
+  // Returns error status if @acting_fingerprints and @out have different
+  // sizes.
+  absl::Status HashBatch(absl::Span<const uint64_t> acting_fingerprints,
+                         absl::string_view seed_prefix,
+                         absl::Span<int32_t> out) const;
+
+  // The full seeds of the choices up to this size are built on the stack.
+  static constexpr size_t kInlineSeedSize = 256;
+
+  // The number of events processed together by HashBatch.
+  static constexpr size_t kHashBatchBlockSize = 64;
+
  private:
+  // Returns the selected choice id. The first @prefix_size bytes of
+  // @full_seed are "consistent-hashing-<random_seed>", followed by enough
+  // space for the longest suffix in @seed_suffixes_.
+  int32_t HashFullSeed(char* full_seed, size_t prefix_size) const;
+
   std::vector<DistributionChoice> distribution_;
+
+  // The suffix of the full seed of each choice, i.e. "-<choice_id>", in the
+  // same order as @distribution_.
+  std::vector<std::string> seed_suffixes_;
+  size_t max_seed_suffix_size_ = 0;
 };
 
 }  // namespace wfa_virtual_people
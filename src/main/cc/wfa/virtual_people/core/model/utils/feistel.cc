@@ -15,41 +15,106 @@
 #include "wfa/virtual_people/core/model/utils/feistel.h"
 
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
 #include <string>
 
 #include "absl/strings/str_cat.h"
-#include "src/farmhash.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "wfa/virtual_people/core/model/utils/seeded_fingerprinter.h"
 
 namespace wfa_virtual_people {
 
+namespace {
+
+SeededFingerprinter GetRoundFingerprinter(absl::string_view seed, int round) {
+  return SeededFingerprinter(absl::StrCat(seed, "-feistel-", round, "-"));
+}
+
+// Returns the smallest integer whose square is not less than @n.
+// The double estimate is exact up to 2^52. Above that it may be off by a few,
+// which would make half * half smaller than the domain, so it is corrected
+// with integer arithmetic. The products are compared through divisions so that
+// they do not overflow.
+uint64_t CeilSqrt(uint64_t n) {
+  if (n <= 1) return n;
+  uint64_t root = static_cast<uint64_t>(std::sqrt(static_cast<double>(n)));
+  // Make root the floor of the square root, i.e. root^2 <= n < (root + 1)^2.
+  while (root > n / root) --root;
+  while (root + 1 <= n / (root + 1)) ++root;
+  return root * root == n ? root : root + 1;
+}
+
+}  // namespace
+
 uint64_t FeistelPermute(uint64_t value, uint64_t domain_size,
                         const std::string& seed) {
-  if (domain_size <= 1) return 0;
+  return FeistelPermutation(domain_size, seed).Permute(value);
+}
 
-  uint64_t half = static_cast<uint64_t>(
-      std::ceil(std::sqrt(static_cast<double>(domain_size))));
-  uint64_t current = value;
+FeistelPermutation::FeistelPermutation(uint64_t domain_size,
+                                       absl::string_view seed)
+    : domain_size_(domain_size),
+      half_(CeilSqrt(domain_size)),
+      round_fingerprinters_({GetRoundFingerprinter(seed, 0),
+                             GetRoundFingerprinter(seed, 1),
+                             GetRoundFingerprinter(seed, 2),
+                             GetRoundFingerprinter(seed, 3)}) {}
+
+uint64_t FeistelPermutation::Permute(uint64_t value) const {
+  if (domain_size_ <= 1) return 0;
 
   // Cycle-walk iteratively until the result is in range.
+  uint64_t current = value;
   do {
-    uint64_t left = current / half;
-    uint64_t right = current % half;
-
-    for (int round = 0; round < 4; ++round) {
-      std::string round_input =
-          absl::StrCat(seed, "-feistel-", round, "-", right);
-      uint64_t round_hash =
-          util::Fingerprint64(round_input.data(), round_input.size());
-      uint64_t new_right = (left + (round_hash % half)) % half;
-      left = right;
-      right = new_right;
-    }
-
-    current = left * half + right;
-  } while (current >= domain_size);
+    current = Encrypt(current);
+  } while (current >= domain_size_);
+  return current;
+}
+
+void FeistelPermutation::PermuteBatch(absl::Span<const uint64_t> values,
+                                      absl::Span<uint64_t> out) const {
+  for (size_t i = 0; i < values.size(); ++i) {
+    out[i] = Permute(values[i]);
+  }
+}
 
+uint64_t FeistelPermutation::Inverse(uint64_t value) const {
+  if (domain_size_ <= 1) return 0;
+
+  // Walks the cycle backwards. Every value passed by Permute between the input
+  // and the output is out of range, so the first value in range is the input.
+  uint64_t current = value;
+  do {
+    current = Decrypt(current);
+  } while (current >= domain_size_);
   return current;
 }
 
+uint64_t FeistelPermutation::Encrypt(uint64_t value) const {
+  uint64_t left = value / half_;
+  uint64_t right = value % half_;
+  for (const SeededFingerprinter& fingerprinter : round_fingerprinters_) {
+    uint64_t round_hash = fingerprinter.Fingerprint(right);
+    uint64_t new_right = (left + (round_hash % half_)) % half_;
+    left = right;
+    right = new_right;
+  }
+  return left * half_ + right;
+}
+
+uint64_t FeistelPermutation::Decrypt(uint64_t value) const {
+  uint64_t left = value / half_;
+  uint64_t right = value % half_;
+  for (int round = kRounds - 1; round >= 0; --round) {
+    // Each round maps (left, right) to (right, (left + hash(right)) % half_).
+    uint64_t round_hash = round_fingerprinters_[round].Fingerprint(left);
+    uint64_t old_left = (right + half_ - round_hash % half_) % half_;
+    right = left;
+    left = old_left;
+  }
+  return left * half_ + right;
+}
+
 }  // namespace wfa_virtual_people
@@ -15,18 +15,65 @@
 #ifndef SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_MODEL_UTILS_FEISTEL_H_
 #define SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_MODEL_UTILS_FEISTEL_H_
 
+#include <array>
 #include <cstdint>
 #include <string>
 
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "wfa/virtual_people/core/model/utils/seeded_fingerprinter.h"
+
 namespace wfa_virtual_people {
 
 // Bijective permutation on [0, domain_size).
 // Returns a unique output for each unique input — zero collisions by
 // construction. Uses a 4-round Feistel network with FarmHash64 as the round
 // function and iterative cycle-walking for non-power-of-2 domains.
+//
+// Builds a FeistelPermutation on every call. Use FeistelPermutation directly to
+// permute many values with the same domain size and seed.
 uint64_t FeistelPermute(uint64_t value, uint64_t domain_size,
                         const std::string& seed);
 
+// The permutation computed by FeistelPermute, for a fixed domain size and
+// seed. The size of the halves and the seed prefixes of the rounds are computed
+// once, so permuting a value does not allocate memory.
+class FeistelPermutation {
+ public:
+  FeistelPermutation(uint64_t domain_size, absl::string_view seed);
+
+  FeistelPermutation(const FeistelPermutation&) = delete;
+  FeistelPermutation& operator=(const FeistelPermutation&) = delete;
+
+  // Returns FeistelPermute(@value, domain_size, seed). @value must be in
+  // [0, domain_size).
+  uint64_t Permute(uint64_t value) const;
+
+  // Sets @out[i] to Permute(@values[i]). @out must have the same size as
+  // @values.
+  void PermuteBatch(absl::Span<const uint64_t> values,
+                    absl::Span<uint64_t> out) const;
+
+  // The inverse of Permute, i.e. Inverse(Permute(x)) == x for any x in
+  // [0, domain_size). @value must be in [0, domain_size).
+  uint64_t Inverse(uint64_t value) const;
+
+  uint64_t domain_size() const { return domain_size_; }
+
+ private:
+  static constexpr int kRounds = 4;
+
+  // One pass of the Feistel network on [0, half_ * half_), and its inverse.
+  uint64_t Encrypt(uint64_t value) const;
+  uint64_t Decrypt(uint64_t value) const;
+
+  uint64_t domain_size_;
+  // The size of each half, i.e. the exact integer ceil(sqrt(domain_size_)).
+  uint64_t half_;
+  // Fingerprints "<seed>-feistel-<round>-<right>" for each round.
+  std::array<SeededFingerprinter, kRounds> round_fingerprinters_;
+};
+
 }  // namespace wfa_virtual_people
 
 #endif  // SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_MODEL_UTILS_FEISTEL_H_
@@ -0,0 +1,170 @@
+// Copyright 2026 The Cross-Media Measurement Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "wfa/virtual_people/core/model/utils/field_accessor.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "common_cpp/macros/macros.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/message.h"
+#include "wfa/virtual_people/common/field_filter/utils/field_util.h"
+#include "wfa/virtual_people/common/model.pb.h"
+
+namespace wfa_virtual_people {
+
+using ::google::protobuf::FieldDescriptor;
+using ::google::protobuf::Message;
+using ::google::protobuf::Reflection;
+
+absl::StatusOr<FieldAccessor> FieldAccessor::Build(
+    absl::string_view full_field_name) {
+  ASSIGN_OR_RETURN(
+      std::vector<const FieldDescriptor*> path,
+      GetFieldFromProto(LabelerEvent().GetDescriptor(), full_field_name));
+  return Build(std::move(path));
+}
+
+absl::StatusOr<FieldAccessor> FieldAccessor::Build(
+    std::vector<const FieldDescriptor*> path) {
+  if (path.empty()) {
+    return absl::InvalidArgumentError("The field path is empty.");
+  }
+  if (path.back()->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("The field is a message field: ", path.back()->name()));
+  }
+
+  // The Reflection of each message along the path, which is shared by all the
+  // messages of the same type. The default instances are walked to get them.
+  std::vector<const Reflection*> reflections;
+  const Message* message = &LabelerEvent::default_instance();
+  for (const FieldDescriptor* field : path) {
+    if (field->containing_type() != message->GetDescriptor()) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "The field is not in ", message->GetDescriptor()->full_name(), ": ",
+          field->full_name()));
+    }
+    if (field->is_repeated()) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("The field is a repeated field: ", field->full_name()));
+    }
+    reflections.push_back(message->GetReflection());
+    if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+      message = &message->GetReflection()->GetMessage(*message, field);
+    }
+  }
+  return FieldAccessor(std::move(path), std::move(reflections));
+}
+
+FieldAccessor::FieldAccessor(std::vector<const FieldDescriptor*>&& path,
+                             std::vector<const Reflection*>&& reflections)
+    : path_(std::move(path)),
+      reflections_(std::move(reflections)),
+      leaf_reflection_(reflections_.back()) {}
+
+ProtoFieldValue<double> FieldAccessor::GetAsDouble(
+    const LabelerEvent& event) const {
+  const Message* parent = GetParent(event);
+  if (!parent || !leaf_reflection_->HasField(*parent, path_.back())) {
+    return {false, 0.0};
+  }
+  switch (cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+      return {true, static_cast<double>(GetLeaf<int32_t>(*parent))};
+    case FieldDescriptor::CPPTYPE_INT64:
+      return {true, static_cast<double>(GetLeaf<int64_t>(*parent))};
+    case FieldDescriptor::CPPTYPE_UINT32:
+      return {true, static_cast<double>(GetLeaf<uint32_t>(*parent))};
+    case FieldDescriptor::CPPTYPE_UINT64:
+      return {true, static_cast<double>(GetLeaf<uint64_t>(*parent))};
+    case FieldDescriptor::CPPTYPE_FLOAT:
+      return {true, static_cast<double>(GetLeaf<float>(*parent))};
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+      return {true, GetLeaf<double>(*parent)};
+    default:
+      return {false, 0.0};
+  }
+}
+
+void FieldAccessor::SetInteger(LabelerEvent& event, int64_t value) const {
+  Message* parent = MutableParent(event);
+  switch (cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+      SetLeaf<int32_t>(parent, static_cast<int32_t>(value));
+      break;
+    case FieldDescriptor::CPPTYPE_INT64:
+      SetLeaf<int64_t>(parent, value);
+      break;
+    case FieldDescriptor::CPPTYPE_UINT32:
+      SetLeaf<uint32_t>(parent, static_cast<uint32_t>(value));
+      break;
+    case FieldDescriptor::CPPTYPE_UINT64:
+      SetLeaf<uint64_t>(parent, static_cast<uint64_t>(value));
+      break;
+    default:
+      break;
+  }
+}
+
+void FieldAccessor::CopyTo(const FieldAccessor& target,
+                           LabelerEvent& event) const {
+  const Message* parent = GetParent(event);
+  if (!parent || !leaf_reflection_->HasField(*parent, path_.back())) {
+    return;
+  }
+  switch (cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+      target.Set(event, GetLeaf<int32_t>(*parent));
+      break;
+    case FieldDescriptor::CPPTYPE_INT64:
+      target.Set(event, GetLeaf<int64_t>(*parent));
+      break;
+    case FieldDescriptor::CPPTYPE_UINT32:
+      target.Set(event, GetLeaf<uint32_t>(*parent));
+      break;
+    case FieldDescriptor::CPPTYPE_UINT64:
+      target.Set(event, GetLeaf<uint64_t>(*parent));
+      break;
+    case FieldDescriptor::CPPTYPE_FLOAT:
+      target.Set(event, GetLeaf<float>(*parent));
+      break;
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+      target.Set(event, GetLeaf<double>(*parent));
+      break;
+    case FieldDescriptor::CPPTYPE_BOOL:
+      target.Set(event, GetLeaf<bool>(*parent));
+      break;
+    case FieldDescriptor::CPPTYPE_ENUM:
+      target.SetEnumValue(
+          event, leaf_reflection_->GetEnumValue(*parent, path_.back()));
+      break;
+    case FieldDescriptor::CPPTYPE_STRING:
+      // Copied before setting, as the target may share the parent message.
+      target.SetString(event,
+                       leaf_reflection_->GetString(*parent, path_.back()));
+      break;
+    default:
+      break;
+  }
+}
+
+}  // namespace wfa_virtual_people
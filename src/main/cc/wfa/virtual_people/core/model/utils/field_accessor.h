@@ -0,0 +1,182 @@
+// Copyright 2026 The Cross-Media Measurement Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_MODEL_UTILS_FIELD_ACCESSOR_H_
+#define SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_MODEL_UTILS_FIELD_ACCESSOR_H_
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/message.h"
+#include "wfa/virtual_people/common/field_filter/utils/field_util.h"
+#include "wfa/virtual_people/common/model.pb.h"
+
+namespace wfa_virtual_people {
+
+// Reads and writes a singular non-message field of LabelerEvent, referred by
+// its full name, e.g. "labeler_input.event_id.id_fingerprint".
+//
+// The name is resolved once by Build. Each access then walks the message
+// fields along the path with the Reflection of each message, which is also
+// resolved by Build, and reads or writes the field with the typed Reflection
+// method of its type.
+class FieldAccessor {
+ public:
+  // Returns error status if @full_field_name does not refer to a valid field,
+  // any field along the path is a repeated field, or the field is a message
+  // field.
+  static absl::StatusOr<FieldAccessor> Build(absl::string_view full_field_name);
+
+  // Same as above, with the field referred by the descriptors of the fields
+  // along the path in LabelerEvent, as returned by GetFieldFromProto.
+  static absl::StatusOr<FieldAccessor> Build(
+      std::vector<const google::protobuf::FieldDescriptor*> path);
+
+  // The descriptors of the fields along the path.
+  const std::vector<const google::protobuf::FieldDescriptor*>& path() const {
+    return path_;
+  }
+
+  google::protobuf::FieldDescriptor::CppType cpp_type() const {
+    return path_.back()->cpp_type();
+  }
+
+  // Returns the value of the field in @event. is_set is false if the field or
+  // any message field along the path is not set.
+  //
+  // @ValueType must be the type of the field: int32_t, int64_t, uint32_t,
+  // uint64_t, float, double or bool.
+  template <typename ValueType>
+  ProtoFieldValue<ValueType> Get(const LabelerEvent& event) const {
+    const google::protobuf::Message* parent = GetParent(event);
+    if (!parent || !leaf_reflection_->HasField(*parent, path_.back())) {
+      return {false, ValueType()};
+    }
+    return {true, GetLeaf<ValueType>(*parent)};
+  }
+
+  // Sets the field in @event to @value, creating the message fields along the
+  // path if not set.
+  //
+  // @ValueType must be the type of the field, as in Get.
+  template <typename ValueType>
+  void Set(LabelerEvent& event, ValueType value) const {
+    SetLeaf<ValueType>(MutableParent(event), value);
+  }
+
+  // Sets the field in @event to the enum value numbered @value. The field must
+  // be an enum field.
+  void SetEnumValue(LabelerEvent& event, int value) const {
+    leaf_reflection_->SetEnumValue(MutableParent(event), path_.back(), value);
+  }
+
+  // Sets the field in @event to @value. The field must be a string field.
+  void SetString(LabelerEvent& event, std::string value) const {
+    leaf_reflection_->SetString(MutableParent(event), path_.back(),
+                                std::move(value));
+  }
+
+  // Returns the value of the field in @event as double. The field must be an
+  // integer or floating point field.
+  ProtoFieldValue<double> GetAsDouble(const LabelerEvent& event) const;
+
+  // Sets the field in @event to @value. The field must be an integer field.
+  void SetInteger(LabelerEvent& event, int64_t value) const;
+
+  // Copies the value of the field in @event to the field of @target in @event,
+  // if the field is set. @target must have the same type.
+  void CopyTo(const FieldAccessor& target, LabelerEvent& event) const;
+
+ private:
+  FieldAccessor(std::vector<const google::protobuf::FieldDescriptor*>&& path,
+                std::vector<const google::protobuf::Reflection*>&& reflections);
+
+  // Returns the message containing the field in @event, or null if any message
+  // field along the path is not set.
+  const google::protobuf::Message* GetParent(const LabelerEvent& event) const {
+    const google::protobuf::Message* message = &event;
+    for (size_t i = 0; i + 1 < path_.size(); ++i) {
+      if (!reflections_[i]->HasField(*message, path_[i])) {
+        return nullptr;
+      }
+      message = &reflections_[i]->GetMessage(*message, path_[i]);
+    }
+    return message;
+  }
+
+  google::protobuf::Message* MutableParent(LabelerEvent& event) const {
+    google::protobuf::Message* message = &event;
+    for (size_t i = 0; i + 1 < path_.size(); ++i) {
+      message = reflections_[i]->MutableMessage(message, path_[i]);
+    }
+    return message;
+  }
+
+  template <typename ValueType>
+  ValueType GetLeaf(const google::protobuf::Message& parent) const {
+    const google::protobuf::FieldDescriptor* field = path_.back();
+    if constexpr (std::is_same_v<ValueType, int32_t>) {
+      return leaf_reflection_->GetInt32(parent, field);
+    } else if constexpr (std::is_same_v<ValueType, int64_t>) {
+      return leaf_reflection_->GetInt64(parent, field);
+    } else if constexpr (std::is_same_v<ValueType, uint32_t>) {
+      return leaf_reflection_->GetUInt32(parent, field);
+    } else if constexpr (std::is_same_v<ValueType, uint64_t>) {
+      return leaf_reflection_->GetUInt64(parent, field);
+    } else if constexpr (std::is_same_v<ValueType, float>) {
+      return leaf_reflection_->GetFloat(parent, field);
+    } else if constexpr (std::is_same_v<ValueType, double>) {
+      return leaf_reflection_->GetDouble(parent, field);
+    } else {
+      static_assert(std::is_same_v<ValueType, bool>, "Unsupported type.");
+      return leaf_reflection_->GetBool(parent, field);
+    }
+  }
+
+  template <typename ValueType>
+  void SetLeaf(google::protobuf::Message* parent, ValueType value) const {
+    const google::protobuf::FieldDescriptor* field = path_.back();
+    if constexpr (std::is_same_v<ValueType, int32_t>) {
+      leaf_reflection_->SetInt32(parent, field, value);
+    } else if constexpr (std::is_same_v<ValueType, int64_t>) {
+      leaf_reflection_->SetInt64(parent, field, value);
+    } else if constexpr (std::is_same_v<ValueType, uint32_t>) {
+      leaf_reflection_->SetUInt32(parent, field, value);
+    } else if constexpr (std::is_same_v<ValueType, uint64_t>) {
+      leaf_reflection_->SetUInt64(parent, field, value);
+    } else if constexpr (std::is_same_v<ValueType, float>) {
+      leaf_reflection_->SetFloat(parent, field, value);
+    } else if constexpr (std::is_same_v<ValueType, double>) {
+      leaf_reflection_->SetDouble(parent, field, value);
+    } else {
+      static_assert(std::is_same_v<ValueType, bool>, "Unsupported type.");
+      leaf_reflection_->SetBool(parent, field, value);
+    }
+  }
+
+  std::vector<const google::protobuf::FieldDescriptor*> path_;
+  // The Reflection of the message containing each field in @path_.
+  std::vector<const google::protobuf::Reflection*> reflections_;
+  const google::protobuf::Reflection* leaf_reflection_;
+};
+
+}  // namespace wfa_virtual_people
+
+#endif  // SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_MODEL_UTILS_FIELD_ACCESSOR_H_
@@ -14,22 +14,262 @@
 
 #include "wfa/virtual_people/core/model/utils/field_filters_matcher.h"
 
+#include <cstdint>
 #include <memory>
+#include <optional>
+#include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/numbers.h"
 #include "common_cpp/macros/macros.h"
+#include "google/protobuf/descriptor.h"
 #include "google/protobuf/message.h"
 #include "wfa/virtual_people/common/field_filter.pb.h"
 #include "wfa/virtual_people/common/field_filter/field_filter.h"
+#include "wfa/virtual_people/common/field_filter/utils/field_util.h"
 #include "wfa/virtual_people/common/model.pb.h"
 #include "wfa/virtual_people/core/model/utils/constants.h"
+#include "wfa/virtual_people/core/model/utils/predicate_cache.h"
 
 namespace wfa_virtual_people {
 
+namespace {
+
+using ::google::protobuf::FieldDescriptor;
+using ::google::protobuf::Message;
+using ::google::protobuf::Reflection;
+
+// The value of an EQUAL filter, parsed to the type of its field.
+struct EqualityValue {
+  int64_t integer_value = 0;
+  std::string string_value;
+};
+
+bool IsIntegerKeyType(const FieldDescriptor& field) {
+  switch (field.cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+    case FieldDescriptor::CPPTYPE_INT64:
+    case FieldDescriptor::CPPTYPE_UINT32:
+    case FieldDescriptor::CPPTYPE_UINT64:
+    case FieldDescriptor::CPPTYPE_ENUM:
+    case FieldDescriptor::CPPTYPE_BOOL:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Parses @value to the type of @field. Returns nullopt if @value cannot be
+// parsed, or the type of @field is not supported.
+std::optional<EqualityValue> ParseEqualityValue(const FieldDescriptor& field,
+                                                const std::string& value) {
+  EqualityValue parsed;
+  switch (field.cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32: {
+      int32_t v;
+      if (!absl::SimpleAtoi(value, &v)) return std::nullopt;
+      parsed.integer_value = v;
+      return parsed;
+    }
+    case FieldDescriptor::CPPTYPE_INT64: {
+      int64_t v;
+      if (!absl::SimpleAtoi(value, &v)) return std::nullopt;
+      parsed.integer_value = v;
+      return parsed;
+    }
+    case FieldDescriptor::CPPTYPE_UINT32: {
+      uint32_t v;
+      if (!absl::SimpleAtoi(value, &v)) return std::nullopt;
+      parsed.integer_value = v;
+      return parsed;
+    }
+    case FieldDescriptor::CPPTYPE_UINT64: {
+      uint64_t v;
+      if (!absl::SimpleAtoi(value, &v)) return std::nullopt;
+      parsed.integer_value = static_cast<int64_t>(v);
+      return parsed;
+    }
+    case FieldDescriptor::CPPTYPE_ENUM: {
+      const google::protobuf::EnumValueDescriptor* enum_value =
+          field.enum_type()->FindValueByName(value);
+      int v;
+      if (enum_value) {
+        parsed.integer_value = enum_value->number();
+      } else if (absl::SimpleAtoi(value, &v) &&
+                 field.enum_type()->FindValueByNumber(v)) {
+        parsed.integer_value = v;
+      } else {
+        return std::nullopt;
+      }
+      return parsed;
+    }
+    case FieldDescriptor::CPPTYPE_BOOL: {
+      bool v;
+      if (!absl::SimpleAtob(value, &v)) return std::nullopt;
+      parsed.integer_value = v;
+      return parsed;
+    }
+    case FieldDescriptor::CPPTYPE_STRING:
+      parsed.string_value = value;
+      return parsed;
+    default:
+      return std::nullopt;
+  }
+}
+
+// Sets the @field in @event to @value. All the fields in the path of @field
+// must be singular.
+void SetEqualityValue(const std::vector<const FieldDescriptor*>& field,
+                      const EqualityValue& value, Message& event) {
+  Message* parent = &event;
+  for (size_t i = 0; i + 1 < field.size(); ++i) {
+    parent = parent->GetReflection()->MutableMessage(parent, field[i]);
+  }
+  const FieldDescriptor* leaf = field.back();
+  const Reflection* reflection = parent->GetReflection();
+  switch (leaf->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+      reflection->SetInt32(parent, leaf,
+                           static_cast<int32_t>(value.integer_value));
+      break;
+    case FieldDescriptor::CPPTYPE_INT64:
+      reflection->SetInt64(parent, leaf, value.integer_value);
+      break;
+    case FieldDescriptor::CPPTYPE_UINT32:
+      reflection->SetUInt32(parent, leaf,
+                            static_cast<uint32_t>(value.integer_value));
+      break;
+    case FieldDescriptor::CPPTYPE_UINT64:
+      reflection->SetUInt64(parent, leaf,
+                            static_cast<uint64_t>(value.integer_value));
+      break;
+    case FieldDescriptor::CPPTYPE_ENUM:
+      reflection->SetEnumValue(parent, leaf,
+                               static_cast<int>(value.integer_value));
+      break;
+    case FieldDescriptor::CPPTYPE_BOOL:
+      reflection->SetBool(parent, leaf, value.integer_value != 0);
+      break;
+    case FieldDescriptor::CPPTYPE_STRING:
+      reflection->SetString(parent, leaf, value.string_value);
+      break;
+    default:
+      break;
+  }
+}
+
+// Returns the path of the field of @config if it can be indexed, i.e. @config
+// is an EQUAL filter on a singular integer, enum, bool or string field.
+std::optional<std::vector<const FieldDescriptor*>> GetIndexableField(
+    const FieldFilterProto& config) {
+  if (config.op() != FieldFilterProto::EQUAL || !config.has_name() ||
+      !config.has_value()) {
+    return std::nullopt;
+  }
+  absl::StatusOr<std::vector<const FieldDescriptor*>> field =
+      GetFieldFromProto(LabelerEvent().GetDescriptor(), config.name());
+  if (!field.ok()) {
+    return std::nullopt;
+  }
+  const FieldDescriptor& leaf = *field->back();
+  if (leaf.is_repeated() ||
+      (!IsIntegerKeyType(leaf) &&
+       leaf.cpp_type() != FieldDescriptor::CPPTYPE_STRING)) {
+    return std::nullopt;
+  }
+  return *std::move(field);
+}
+
+// Returns the value of the field of @config, which is an indexable EQUAL
+// filter on @field, and is built to @filter.
+//
+// The value is checked against @filter: @filter must match an event with only
+// @field set to the value, and not match an event without @field. Otherwise
+// returns nullopt, and the filter is tested one by one.
+std::optional<EqualityValue> GetCheckedEqualityValue(
+    const FieldFilterProto& config,
+    const std::vector<const FieldDescriptor*>& field,
+    const FieldFilter& filter) {
+  std::optional<EqualityValue> value =
+      ParseEqualityValue(*field.back(), config.value());
+  if (!value.has_value()) {
+    return std::nullopt;
+  }
+  LabelerEvent event;
+  if (filter.IsMatch(event)) {
+    return std::nullopt;
+  }
+  SetEqualityValue(field, *value, event);
+  if (!filter.IsMatch(event)) {
+    return std::nullopt;
+  }
+  return value;
+}
+
+// Builds the index of the EQUAL filters on the field with the most EQUAL
+// filters in @filter_configs, which are built to @filters. Appends the indexes
+// of the other filters to @unindexed_filters. Returns null if there are not
+// enough EQUAL filters to index.
+std::unique_ptr<FieldFiltersMatcher::EqualityIndex> BuildEqualityIndex(
+    const std::vector<const FieldFilterProto*>& filter_configs,
+    const std::vector<std::unique_ptr<FieldFilter>>& filters,
+    std::vector<int>& unindexed_filters) {
+  // Finds the field with the most EQUAL filters.
+  absl::flat_hash_map<std::string, int> equal_filter_counts;
+  const std::string* indexed_name = nullptr;
+  int indexed_count = 0;
+  for (const FieldFilterProto* filter_config : filter_configs) {
+    if (filter_config->op() != FieldFilterProto::EQUAL) {
+      continue;
+    }
+    int count = ++equal_filter_counts[filter_config->name()];
+    if (count > indexed_count) {
+      indexed_name = &filter_config->name();
+      indexed_count = count;
+    }
+  }
+  if (indexed_count < FieldFiltersMatcher::kMinIndexedFilters) {
+    return nullptr;
+  }
+
+  std::vector<const FieldDescriptor*> indexed_field;
+  auto index = absl::make_unique<FieldFiltersMatcher::EqualityIndex>();
+  for (int i = 0; i < filter_configs.size(); ++i) {
+    const FieldFilterProto& filter_config = *filter_configs[i];
+    std::optional<std::vector<const FieldDescriptor*>> field;
+    std::optional<EqualityValue> value;
+    if (filter_config.name() == *indexed_name) {
+      field = GetIndexableField(filter_config);
+    }
+    if (field.has_value()) {
+      value = GetCheckedEqualityValue(filter_config, *field, *filters[i]);
+    }
+    if (!value.has_value()) {
+      unindexed_filters.push_back(i);
+      continue;
+    }
+    // Only the first filter of each value can be the first match.
+    if (IsIntegerKeyType(*field->back())) {
+      index->integer_values.try_emplace(value->integer_value, i);
+    } else {
+      index->string_values.try_emplace(value->string_value, i);
+    }
+    indexed_field = *std::move(field);
+  }
+  if (indexed_field.empty()) {
+    return nullptr;
+  }
+  index->field = std::move(indexed_field);
+  return index;
+}
+
+}  // namespace
+
 absl::StatusOr<std::unique_ptr<FieldFiltersMatcher>> FieldFiltersMatcher::Build(
     const std::vector<const FieldFilterProto*>& filter_configs) {
   if (filter_configs.empty()) {
@@ -47,7 +287,18 @@ absl::StatusOr<std::unique_ptr<FieldFiltersMatcher>> FieldFiltersMatcher::Build(
         FieldFilter::New(LabelerEvent().GetDescriptor(), *filter_config));
   }
 
-  return absl::make_unique<FieldFiltersMatcher>(std::move(filters));
+  std::vector<int> unindexed_filters;
+  std::unique_ptr<EqualityIndex> index =
+      BuildEqualityIndex(filter_configs, filters, unindexed_filters);
+  std::unique_ptr<FieldFiltersMatcher> matcher =
+      index ? absl::make_unique<FieldFiltersMatcher>(
+                  std::move(filters), std::move(index),
+                  std::move(unindexed_filters))
+            : absl::make_unique<FieldFiltersMatcher>(std::move(filters));
+  for (const FieldFilterProto* filter_config : filter_configs) {
+    matcher->predicate_configs_.push_back(MakePredicateConfig(*filter_config));
+  }
+  return matcher;
 }
 
 absl::StatusOr<std::unique_ptr<FieldFiltersMatcher>> FieldFiltersMatcher::Build(
@@ -56,14 +307,92 @@ absl::StatusOr<std::unique_ptr<FieldFiltersMatcher>> FieldFiltersMatcher::Build(
 }
 
 int FieldFiltersMatcher::GetFirstMatch(const LabelerEvent& event) const {
-  int index = 0;
-  for (auto& filter : filters_) {
-    if (filter->IsMatch(event)) {
+  if (index_) {
+    // The first match is either the indexed match, or an unindexed filter
+    // before it.
+    int indexed_match = GetIndexedMatch(event);
+    for (int index : unindexed_filters_) {
+      if (indexed_match != kNoMatchingIndex && index > indexed_match) {
+        break;
+      }
+      if (IsMatch(index, event)) {
+        return index;
+      }
+    }
+    return indexed_match;
+  }
+
+  for (int index = 0; index < filters_.size(); ++index) {
+    if (IsMatch(index, event)) {
       return index;
     }
-    ++index;
   }
   return kNoMatchingIndex;
 }
 
+void FieldFiltersMatcher::RegisterPredicates(PredicateRegistry& registry) {
+  if (predicate_configs_.empty()) {
+    return;
+  }
+  predicate_ids_.clear();
+  for (const PredicateConfig& predicate_config : predicate_configs_) {
+    predicate_ids_.push_back(registry.Register(predicate_config));
+  }
+  // The configs are only needed for registering.
+  predicate_configs_.clear();
+  predicate_configs_.shrink_to_fit();
+}
+
+int FieldFiltersMatcher::GetIndexedMatch(const LabelerEvent& event) const {
+  const std::vector<const FieldDescriptor*>& field = index_->field;
+  const Message* parent = &event;
+  for (size_t i = 0; i + 1 < field.size(); ++i) {
+    const Reflection* reflection = parent->GetReflection();
+    if (!reflection->HasField(*parent, field[i])) {
+      return kNoMatchingIndex;
+    }
+    parent = &reflection->GetMessage(*parent, field[i]);
+  }
+  const FieldDescriptor* leaf = field.back();
+  const Reflection* reflection = parent->GetReflection();
+  if (!reflection->HasField(*parent, leaf)) {
+    return kNoMatchingIndex;
+  }
+
+  int64_t integer_value = 0;
+  switch (leaf->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+      integer_value = reflection->GetInt32(*parent, leaf);
+      break;
+    case FieldDescriptor::CPPTYPE_INT64:
+      integer_value = reflection->GetInt64(*parent, leaf);
+      break;
+    case FieldDescriptor::CPPTYPE_UINT32:
+      integer_value = reflection->GetUInt32(*parent, leaf);
+      break;
+    case FieldDescriptor::CPPTYPE_UINT64:
+      integer_value =
+          static_cast<int64_t>(reflection->GetUInt64(*parent, leaf));
+      break;
+    case FieldDescriptor::CPPTYPE_ENUM:
+      integer_value = reflection->GetEnumValue(*parent, leaf);
+      break;
+    case FieldDescriptor::CPPTYPE_BOOL:
+      integer_value = reflection->GetBool(*parent, leaf);
+      break;
+    case FieldDescriptor::CPPTYPE_STRING: {
+      std::string scratch;
+      const std::string& string_value =
+          reflection->GetStringReference(*parent, leaf, &scratch);
+      auto it = index_->string_values.find(string_value);
+      return it == index_->string_values.end() ? kNoMatchingIndex
+                                               : it->second;
+    }
+    default:
+      return kNoMatchingIndex;
+  }
+  auto it = index_->integer_values.find(integer_value);
+  return it == index_->integer_values.end() ? kNoMatchingIndex : it->second;
+}
+
 }  // namespace wfa_virtual_people
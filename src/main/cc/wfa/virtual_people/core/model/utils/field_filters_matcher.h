@@ -15,18 +15,28 @@
 #ifndef SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_MODEL_UTILS_FIELD_FILTERS_MATCHER_H_
 #define SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_MODEL_UTILS_FIELD_FILTERS_MATCHER_H_
 
+#include <cstdint>
 #include <memory>
+#include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/status/statusor.h"
+#include "google/protobuf/descriptor.h"
 #include "wfa/virtual_people/common/field_filter.pb.h"
 #include "wfa/virtual_people/common/field_filter/field_filter.h"
 #include "wfa/virtual_people/common/model.pb.h"
+#include "wfa/virtual_people/core/model/utils/predicate_cache.h"
 
 namespace wfa_virtual_people {
 
 // Selects the field filter that a LabelerEvent matches.
+//
+// When built from FieldFilterProtos, and at least kMinIndexedFilters of them
+// are EQUAL filters on the same integer, enum, bool or string field, those
+// filters are indexed by their values. GetFirstMatch then looks up the value
+// of the field in the event, and only tests the other filters one by one.
 class FieldFiltersMatcher {
  public:
   // Always use Build to get a FieldFiltersMatcher object. Users should not call
@@ -38,14 +48,36 @@ class FieldFiltersMatcher {
   static absl::StatusOr<std::unique_ptr<FieldFiltersMatcher>> Build(
       const std::vector<const FieldFilterProto*>& filter_configs);
 
+  // The filters are not indexed.
   static absl::StatusOr<std::unique_ptr<FieldFiltersMatcher>> Build(
       std::vector<std::unique_ptr<FieldFilter>>&& filters);
 
+  // The EQUAL filters on one field, indexed by their values. Each value maps
+  // to the index of the first filter with this value.
+  struct EqualityIndex {
+    std::vector<const google::protobuf::FieldDescriptor*> field;
+    // For integer, enum and bool fields.
+    absl::flat_hash_map<int64_t, int> integer_values;
+    // For string fields.
+    absl::flat_hash_map<std::string, int> string_values;
+  };
+
   // Never call the constructor directly.
   explicit FieldFiltersMatcher(
       std::vector<std::unique_ptr<FieldFilter>>&& filters)
       : filters_(std::move(filters)) {}
 
+  // Never call the constructor directly.
+  //
+  // @unindexed_filters are the indexes of the filters not in @index, in
+  // increasing order.
+  FieldFiltersMatcher(std::vector<std::unique_ptr<FieldFilter>>&& filters,
+                      std::unique_ptr<EqualityIndex> index,
+                      std::vector<int>&& unindexed_filters)
+      : filters_(std::move(filters)),
+        index_(std::move(index)),
+        unindexed_filters_(std::move(unindexed_filters)) {}
+
   FieldFiltersMatcher(const FieldFiltersMatcher&) = delete;
   FieldFiltersMatcher& operator=(const FieldFiltersMatcher&) = delete;
 
@@ -55,8 +87,39 @@ class FieldFiltersMatcher {
   // The matching is performed on @event.
   int GetFirstMatch(const LabelerEvent& event) const;
 
+  // Assigns ids to the filters from @registry, so that their results are
+  // cached by the PredicateCache of the current thread. Does nothing if the
+  // matcher is not built from FieldFilterProtos.
+  void RegisterPredicates(PredicateRegistry& registry);
+
+  // Returns whether the filters are indexed.
+  bool is_indexed() const { return index_ != nullptr; }
+
+  // The min number of EQUAL filters on the same field to build an index.
+  static constexpr int kMinIndexedFilters = 4;
+
  private:
+  // Returns the index of the first filter in @index_ that matches @event, or
+  // @kNoMatchingIndex if none matches.
+  int GetIndexedMatch(const LabelerEvent& event) const;
+
+  // Returns whether the filter at @index matches @event.
+  bool IsMatch(int index, const LabelerEvent& event) const {
+    return MatchPredicate(
+        predicate_ids_.empty() ? kNoPredicateId : predicate_ids_[index],
+        *filters_[index], event);
+  }
+
   std::vector<std::unique_ptr<FieldFilter>> filters_;
+  // Null if the filters are not indexed.
+  std::unique_ptr<EqualityIndex> index_;
+  std::vector<int> unindexed_filters_;
+
+  // The configs of @filters_ until they are registered, if the matcher is
+  // built from FieldFilterProtos.
+  std::vector<PredicateConfig> predicate_configs_;
+  // The ids of @filters_ in the PredicateRegistry, empty if not registered.
+  std::vector<int> predicate_ids_;
 };
 
 }  // namespace wfa_virtual_people
@@ -15,19 +15,160 @@
 #include "wfa/virtual_people/core/model/utils/hash.h"
 
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
 #include <limits>
 
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "src/farmhash.h"
 
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define WFA_VIRTUAL_PEOPLE_HAVE_X86_HASH_KERNELS 1
+#endif
+
 namespace wfa_virtual_people {
 
-double FloatHash(absl::string_view seed) {
-  return static_cast<double>(util::Fingerprint64(seed)) /
+namespace {
+
+// The max uint64_t rounds to 2^64 as a double, so dividing by it is the same
+// as multiplying by 2^-64, which is exact. The SIMD kernels below rely on this.
+constexpr double kFingerprintScale =
+    1.0 / static_cast<double>(std::numeric_limits<uint64_t>::max());
+static_assert(kFingerprintScale == 0x1p-64);
+
+double FingerprintToFloat(uint64_t fingerprint) {
+  return static_cast<double>(fingerprint) /
          static_cast<double>(std::numeric_limits<uint64_t>::max());
 }
 
+void FloatHashBatchScalar(const uint64_t* fingerprints, double* out,
+                          size_t size) {
+  for (size_t i = 0; i < size; ++i) {
+    out[i] = FingerprintToFloat(fingerprints[i]);
+  }
+}
+
+#ifdef WFA_VIRTUAL_PEOPLE_HAVE_X86_HASH_KERNELS
+
+// AVX2 has no conversion from uint64_t to double. Each fingerprint is split
+// into the high and the low 32 bits, which are converted exactly by placing
+// them in the mantissas of 2^84 and 2^52. The only rounding is in the final
+// addition, so the result is the same as static_cast<double>.
+__attribute__((target("avx2"))) void FloatHashBatchAvx2(
+    const uint64_t* fingerprints, double* out, size_t size) {
+  const __m256i exponent_52 = _mm256_castpd_si256(_mm256_set1_pd(0x1p52));
+  const __m256i exponent_84 = _mm256_castpd_si256(_mm256_set1_pd(0x1p84));
+  const __m256d exponent_84_52 = _mm256_set1_pd(0x1p84 + 0x1p52);
+  const __m256d scale = _mm256_set1_pd(kFingerprintScale);
+  size_t i = 0;
+  for (; i + 4 <= size; i += 4) {
+    __m256i x = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(fingerprints + i));
+    __m256i high = _mm256_or_si256(_mm256_srli_epi64(x, 32), exponent_84);
+    __m256i low = _mm256_blend_epi32(x, exponent_52, 0xaa);
+    __m256d value = _mm256_add_pd(
+        _mm256_sub_pd(_mm256_castsi256_pd(high), exponent_84_52),
+        _mm256_castsi256_pd(low));
+    _mm256_storeu_pd(out + i, _mm256_mul_pd(value, scale));
+  }
+  FloatHashBatchScalar(fingerprints + i, out + i, size - i);
+}
+
+__attribute__((target("avx512f,avx512dq"))) void FloatHashBatchAvx512(
+    const uint64_t* fingerprints, double* out, size_t size) {
+  const __m512d scale = _mm512_set1_pd(kFingerprintScale);
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    __m512i x0 = _mm512_loadu_si512(fingerprints + i);
+    __m512i x1 = _mm512_loadu_si512(fingerprints + i + 8);
+    _mm512_storeu_pd(out + i, _mm512_mul_pd(_mm512_cvtepu64_pd(x0), scale));
+    _mm512_storeu_pd(out + i + 8,
+                     _mm512_mul_pd(_mm512_cvtepu64_pd(x1), scale));
+  }
+  FloatHashBatchScalar(fingerprints + i, out + i, size - i);
+}
+
+#endif  // WFA_VIRTUAL_PEOPLE_HAVE_X86_HASH_KERNELS
+
+using FloatHashBatchFunction = void (*)(const uint64_t*, double*, size_t);
+
+FloatHashBatchFunction GetFloatHashBatchFunction(
+    internal::FloatHashKernel kernel) {
+  switch (kernel) {
+#ifdef WFA_VIRTUAL_PEOPLE_HAVE_X86_HASH_KERNELS
+    case internal::FloatHashKernel::kAvx2:
+      return FloatHashBatchAvx2;
+    case internal::FloatHashKernel::kAvx512:
+      return FloatHashBatchAvx512;
+#endif
+    default:
+      return FloatHashBatchScalar;
+  }
+}
+
+// Selects the best kernel supported by the CPU.
+FloatHashBatchFunction SelectFloatHashBatchFunction() {
+  for (internal::FloatHashKernel kernel :
+       {internal::FloatHashKernel::kAvx512, internal::FloatHashKernel::kAvx2}) {
+    if (internal::IsFloatHashKernelSupported(kernel)) {
+      return GetFloatHashBatchFunction(kernel);
+    }
+  }
+  return FloatHashBatchScalar;
+}
+
+}  // namespace
+
+double FloatHash(absl::string_view seed) {
+  return FingerprintToFloat(util::Fingerprint64(seed));
+}
+
 double ExpHash(absl::string_view seed) { return -std::log(FloatHash(seed)); }
 
+void FloatHashBatch(absl::Span<const uint64_t> fingerprints,
+                    absl::Span<double> out) {
+  static const FloatHashBatchFunction kFloatHashBatch =
+      SelectFloatHashBatchFunction();
+  kFloatHashBatch(fingerprints.data(), out.data(), fingerprints.size());
+}
+
+void ExpHashBatch(absl::Span<const uint64_t> fingerprints,
+                  absl::Span<double> out) {
+  FloatHashBatch(fingerprints, out);
+  // The logarithm stays scalar, as a vectorized logarithm would not be
+  // bit-identical to std::log.
+  for (size_t i = 0; i < fingerprints.size(); ++i) {
+    out[i] = -std::log(out[i]);
+  }
+}
+
+namespace internal {
+
+bool IsFloatHashKernelSupported(FloatHashKernel kernel) {
+  switch (kernel) {
+    case FloatHashKernel::kScalar:
+      return true;
+#ifdef WFA_VIRTUAL_PEOPLE_HAVE_X86_HASH_KERNELS
+    case FloatHashKernel::kAvx2:
+      return __builtin_cpu_supports("avx2");
+    case FloatHashKernel::kAvx512:
+      return __builtin_cpu_supports("avx512f") &&
+             __builtin_cpu_supports("avx512dq");
+#endif
+    default:
+      return false;
+  }
+}
+
+void FloatHashBatchWithKernel(FloatHashKernel kernel,
+                              absl::Span<const uint64_t> fingerprints,
+                              absl::Span<double> out) {
+  GetFloatHashBatchFunction(kernel)(fingerprints.data(), out.data(),
+                                    fingerprints.size());
+}
+
+}  // namespace internal
+
 }  // namespace wfa_virtual_people
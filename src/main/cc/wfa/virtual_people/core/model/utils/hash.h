@@ -18,6 +18,7 @@
 #include <cstdint>
 
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 
 namespace wfa_virtual_people {
 
@@ -27,6 +28,37 @@ double FloatHash(absl::string_view seed);
 // Exponentially distributed hash. The output is a positive double float number.
 double ExpHash(absl::string_view seed);
 
+// Batch versions of FloatHash and ExpHash, from the fingerprints of the seeds.
+// Sets @out[i] to the FloatHash or ExpHash of the seed whose Fingerprint64 is
+// @fingerprints[i]. @out must have the same size as @fingerprints.
+//
+// The conversion of the fingerprints to float numbers uses AVX-512 or AVX2
+// when the CPU supports it, and the output is bit-identical to the scalar
+// functions above.
+void FloatHashBatch(absl::Span<const uint64_t> fingerprints,
+                    absl::Span<double> out);
+void ExpHashBatch(absl::Span<const uint64_t> fingerprints,
+                  absl::Span<double> out);
+
+namespace internal {
+
+// The implementations of FloatHashBatch. Exposed for testing.
+enum class FloatHashKernel {
+  kScalar,
+  kAvx2,
+  kAvx512,
+};
+
+// Returns whether @kernel is supported by the CPU.
+bool IsFloatHashKernelSupported(FloatHashKernel kernel);
+
+// Same as FloatHashBatch, using @kernel, which must be supported by the CPU.
+void FloatHashBatchWithKernel(FloatHashKernel kernel,
+                              absl::Span<const uint64_t> fingerprints,
+                              absl::Span<double> out);
+
+}  // namespace internal
+
 }  // namespace wfa_virtual_people
 
 #endif  // SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_MODEL_UTILS_HASH_H_
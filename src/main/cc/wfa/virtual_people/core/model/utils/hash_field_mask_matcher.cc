@@ -14,16 +14,26 @@
 
 #include "wfa/virtual_people/core/model/utils/hash_field_mask_matcher.h"
 
+#include <cstdint>
+#include <cstring>
 #include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/base/casts.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/inlined_vector.h"
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "common_cpp/macros/macros.h"
+#include "google/protobuf/descriptor.h"
 #include "google/protobuf/field_mask.pb.h"
+#include "google/protobuf/message.h"
 #include "google/protobuf/util/field_mask_util.h"
 #include "src/farmhash.h"
 #include "wfa/virtual_people/common/model.pb.h"
@@ -31,16 +41,192 @@
 
 namespace wfa_virtual_people {
 
-// Get the hash of @event, only including the fields in @hash_field_mask.
+namespace {
+
+using ::google::protobuf::FieldDescriptor;
+using ::google::protobuf::Message;
+using ::google::protobuf::Reflection;
+using FieldPath = HashFieldMaskMatcher::FieldPath;
+
+// The field values are written to an inline buffer, which is then
+// fingerprinted. Larger values spill to the heap.
+constexpr int kInlineBufferSize = 256;
+using HashBuffer = absl::InlinedVector<char, kInlineBufferSize>;
+
+void AppendUint64(uint64_t value, HashBuffer& buffer) {
+  char bytes[sizeof(value)];
+  std::memcpy(bytes, &value, sizeof(value));
+  buffer.insert(buffer.end(), bytes, bytes + sizeof(value));
+}
+
+void AppendString(absl::string_view value, HashBuffer& buffer) {
+  AppendUint64(value.size(), buffer);
+  buffer.insert(buffer.end(), value.begin(), value.end());
+}
+
+// Appends the value of the singular @field in @message to @buffer.
+void AppendSingularValue(const Message& message, const FieldDescriptor* field,
+                         HashBuffer& buffer) {
+  const Reflection* reflection = message.GetReflection();
+  switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+      AppendUint64(reflection->GetInt32(message, field), buffer);
+      break;
+    case FieldDescriptor::CPPTYPE_INT64:
+      AppendUint64(reflection->GetInt64(message, field), buffer);
+      break;
+    case FieldDescriptor::CPPTYPE_UINT32:
+      AppendUint64(reflection->GetUInt32(message, field), buffer);
+      break;
+    case FieldDescriptor::CPPTYPE_UINT64:
+      AppendUint64(reflection->GetUInt64(message, field), buffer);
+      break;
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+      AppendUint64(
+          absl::bit_cast<uint64_t>(reflection->GetDouble(message, field)),
+          buffer);
+      break;
+    case FieldDescriptor::CPPTYPE_FLOAT:
+      AppendUint64(
+          absl::bit_cast<uint32_t>(reflection->GetFloat(message, field)),
+          buffer);
+      break;
+    case FieldDescriptor::CPPTYPE_BOOL:
+      AppendUint64(reflection->GetBool(message, field), buffer);
+      break;
+    case FieldDescriptor::CPPTYPE_ENUM:
+      AppendUint64(reflection->GetEnumValue(message, field), buffer);
+      break;
+    case FieldDescriptor::CPPTYPE_STRING: {
+      std::string scratch;
+      AppendString(reflection->GetStringReference(message, field, &scratch),
+                   buffer);
+      break;
+    }
+    case FieldDescriptor::CPPTYPE_MESSAGE:
+      AppendString(
+          reflection->GetMessage(message, field).SerializePartialAsString(),
+          buffer);
+      break;
+  }
+}
+
+// Appends the values of the repeated @field in @message to @buffer.
+void AppendRepeatedValues(const Message& message, const FieldDescriptor* field,
+                          HashBuffer& buffer) {
+  const Reflection* reflection = message.GetReflection();
+  int size = reflection->FieldSize(message, field);
+  AppendUint64(size, buffer);
+  for (int i = 0; i < size; ++i) {
+    switch (field->cpp_type()) {
+      case FieldDescriptor::CPPTYPE_INT32:
+        AppendUint64(reflection->GetRepeatedInt32(message, field, i), buffer);
+        break;
+      case FieldDescriptor::CPPTYPE_INT64:
+        AppendUint64(reflection->GetRepeatedInt64(message, field, i), buffer);
+        break;
+      case FieldDescriptor::CPPTYPE_UINT32:
+        AppendUint64(reflection->GetRepeatedUInt32(message, field, i), buffer);
+        break;
+      case FieldDescriptor::CPPTYPE_UINT64:
+        AppendUint64(reflection->GetRepeatedUInt64(message, field, i), buffer);
+        break;
+      case FieldDescriptor::CPPTYPE_DOUBLE:
+        AppendUint64(absl::bit_cast<uint64_t>(
+                         reflection->GetRepeatedDouble(message, field, i)),
+                     buffer);
+        break;
+      case FieldDescriptor::CPPTYPE_FLOAT:
+        AppendUint64(absl::bit_cast<uint32_t>(
+                         reflection->GetRepeatedFloat(message, field, i)),
+                     buffer);
+        break;
+      case FieldDescriptor::CPPTYPE_BOOL:
+        AppendUint64(reflection->GetRepeatedBool(message, field, i), buffer);
+        break;
+      case FieldDescriptor::CPPTYPE_ENUM:
+        AppendUint64(reflection->GetRepeatedEnumValue(message, field, i),
+                     buffer);
+        break;
+      case FieldDescriptor::CPPTYPE_STRING: {
+        std::string scratch;
+        AppendString(reflection->GetRepeatedStringReference(message, field, i,
+                                                            &scratch),
+                     buffer);
+        break;
+      }
+      case FieldDescriptor::CPPTYPE_MESSAGE:
+        AppendString(reflection->GetRepeatedMessage(message, field, i)
+                         .SerializePartialAsString(),
+                     buffer);
+        break;
+    }
+  }
+}
+
+// Resolves @path to the fields in LabelerEvent. All the fields except the last
+// one must be singular message fields.
+absl::StatusOr<FieldPath> ResolveFieldPath(absl::string_view path) {
+  FieldPath field_path;
+  const google::protobuf::Descriptor* descriptor =
+      LabelerEvent::GetDescriptor();
+  for (absl::string_view field_name : absl::StrSplit(path, '.')) {
+    if (!descriptor) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "The hash field mask path goes through a non-message field: ",
+          path));
+    }
+    const FieldDescriptor* field =
+        descriptor->FindFieldByName(std::string(field_name));
+    if (!field) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("The hash field mask path is invalid: ", path));
+    }
+    if (!field_path.empty() && field_path.back()->is_repeated()) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "The hash field mask path goes through a repeated field: ", path));
+    }
+    field_path.push_back(field);
+    descriptor = field->message_type();
+  }
+  return field_path;
+}
+
+// Get the hash of @event, only including the fields in @field_paths.
+//
+// For each path, includes whether the leaf field is set, and its value if it
+// is set. An unset parent message is the same as an unset leaf field, so the
+// hash is the same as the hash of the LabelerEvent built by merging the fields
+// in @field_paths from @event.
 uint64_t HashLabelerEvent(const LabelerEvent& event,
-                          const google::protobuf::FieldMask& hash_field_mask) {
-  LabelerEvent hash_field_event;
-  google::protobuf::util::FieldMaskUtil::MergeMessageTo(
-      event, hash_field_mask,
-      google::protobuf::util::FieldMaskUtil::MergeOptions(), &hash_field_event);
-  return util::Fingerprint64(hash_field_event.SerializePartialAsString());
+                          const std::vector<FieldPath>& field_paths) {
+  HashBuffer buffer;
+  for (const FieldPath& field_path : field_paths) {
+    const Message* message = &event;
+    for (size_t i = 0; message && i + 1 < field_path.size(); ++i) {
+      const Reflection* reflection = message->GetReflection();
+      message = reflection->HasField(*message, field_path[i])
+                    ? &reflection->GetMessage(*message, field_path[i])
+                    : nullptr;
+    }
+    const FieldDescriptor* leaf = field_path.back();
+    if (!message) {
+      // The size of an unset repeated field is also 0.
+      AppendUint64(0, buffer);
+    } else if (leaf->is_repeated()) {
+      AppendRepeatedValues(*message, leaf, buffer);
+    } else if (message->GetReflection()->HasField(*message, leaf)) {
+      AppendUint64(1, buffer);
+      AppendSingularValue(*message, leaf, buffer);
+    } else {
+      AppendUint64(0, buffer);
+    }
+  }
+  return util::Fingerprint64(buffer.data(), buffer.size());
 }
 
+}  // namespace
+
 absl::StatusOr<std::unique_ptr<HashFieldMaskMatcher>>
 HashFieldMaskMatcher::Build(
     const std::vector<const LabelerEvent*>& events,
@@ -54,6 +240,15 @@ HashFieldMaskMatcher::Build(
         "The hash_field_mask is empty when building HashFieldMaskMatcher.");
   }
 
+  // Redundant paths are removed, and the paths are sorted.
+  google::protobuf::FieldMask canonical_field_mask;
+  google::protobuf::util::FieldMaskUtil::ToCanonicalForm(hash_field_mask,
+                                                         &canonical_field_mask);
+  std::vector<FieldPath> field_paths;
+  for (const std::string& path : canonical_field_mask.paths()) {
+    ASSIGN_OR_RETURN(field_paths.emplace_back(), ResolveFieldPath(path));
+  }
+
   absl::flat_hash_map<uint64_t, int> hashes;
   int index = 0;
   for (const LabelerEvent* event : events) {
@@ -61,7 +256,7 @@ HashFieldMaskMatcher::Build(
       return absl::InvalidArgumentError(
           "An event is null when building HashFieldMaskMatcher.");
     }
-    uint64_t hash = HashLabelerEvent(*event, hash_field_mask);
+    uint64_t hash = HashLabelerEvent(*event, field_paths);
     auto [iterator, inserted] = hashes.insert_or_assign(hash, index);
     if (!inserted) {
       return absl::InvalidArgumentError(
@@ -71,11 +266,11 @@ HashFieldMaskMatcher::Build(
   }
 
   return absl::make_unique<HashFieldMaskMatcher>(std::move(hashes),
-                                                 hash_field_mask);
+                                                 std::move(field_paths));
 }
 
 int HashFieldMaskMatcher::GetMatch(const LabelerEvent& event) const {
-  uint64_t event_hash = HashLabelerEvent(event, hash_field_mask_);
+  uint64_t event_hash = HashLabelerEvent(event, field_paths_);
   auto it = hashes_.find(event_hash);
   if (it == hashes_.end()) {
     return kNoMatchingIndex;
@@ -15,12 +15,14 @@
 #ifndef SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_MODEL_UTILS_HASH_FIELD_MASK_MATCHER_H_
 #define SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_MODEL_UTILS_HASH_FIELD_MASK_MATCHER_H_
 
+#include <cstdint>
 #include <memory>
 #include <utility>
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/statusor.h"
+#include "google/protobuf/descriptor.h"
 #include "google/protobuf/field_mask.pb.h"
 #include "wfa/virtual_people/common/model.pb.h"
 
@@ -28,8 +30,17 @@ namespace wfa_virtual_people {
 
 // Selects the index of the hash that matches the hash of the input
 // LabelerEvent.
+//
+// The hash of a LabelerEvent only includes the fields in the hash field mask.
+// The paths of the mask are resolved to field descriptors at build time, and
+// the values of the fields are read from the event directly, without copying
+// them to a new LabelerEvent.
 class HashFieldMaskMatcher {
  public:
+  // The resolved path of a field in LabelerEvent, from the top level field to
+  // the leaf field.
+  using FieldPath = std::vector<const google::protobuf::FieldDescriptor*>;
+
   // Always use Build to get a HashFieldMaskMatcher object. Users should not
   // call the constructor below directly.
   //
@@ -37,16 +48,17 @@ class HashFieldMaskMatcher {
   // * @events is empty.
   // * Any entry in @events is null.
   // * @hash_field_mask.paths is empty.
+  // * Any path in @hash_field_mask is not a valid field of LabelerEvent, or
+  //   goes through a repeated field.
   // * Multiple entries in @events have the same hash value.
   static absl::StatusOr<std::unique_ptr<HashFieldMaskMatcher>> Build(
       const std::vector<const LabelerEvent*>& events,
       const google::protobuf::FieldMask& hash_field_mask);
 
   // Never call the constructor directly.
-  explicit HashFieldMaskMatcher(
-      absl::flat_hash_map<uint64_t, int>&& hashes,
-      const google::protobuf::FieldMask& hash_field_mask)
-      : hashes_(std::move(hashes)), hash_field_mask_(hash_field_mask) {}
+  explicit HashFieldMaskMatcher(absl::flat_hash_map<uint64_t, int>&& hashes,
+                                std::vector<FieldPath>&& field_paths)
+      : hashes_(std::move(hashes)), field_paths_(std::move(field_paths)) {}
 
   HashFieldMaskMatcher(const HashFieldMaskMatcher&) = delete;
   HashFieldMaskMatcher& operator=(const HashFieldMaskMatcher&) = delete;
@@ -60,7 +72,8 @@ class HashFieldMaskMatcher {
  private:
   // Map from hash values to indexes.
   absl::flat_hash_map<uint64_t, int> hashes_;
-  google::protobuf::FieldMask hash_field_mask_;
+  // The paths in the hash field mask, in canonical form.
+  std::vector<FieldPath> field_paths_;
 };
 
 }  // namespace wfa_virtual_people
@@ -0,0 +1,238 @@
+// Copyright 2026 The Cross-Media Measurement Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "wfa/virtual_people/core/model/utils/path_trace.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+
+namespace wfa_virtual_people {
+
+namespace {
+
+// The first byte of a serialized trace.
+constexpr char kFormatVersion = 1;
+
+thread_local PathTrace* current_trace = nullptr;
+
+void AppendVarint(uint64_t value, std::string& output) {
+  while (value >= 0x80) {
+    output.push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  output.push_back(static_cast<char>(value));
+}
+
+void AppendSignedVarint(int32_t value, std::string& output) {
+  // Zigzag encoding, so that -1 takes a single byte.
+  AppendVarint((static_cast<uint32_t>(value) << 1) ^
+                   static_cast<uint32_t>(value >> 31),
+               output);
+}
+
+// Reads the serialized trace.
+class TraceReader {
+ public:
+  explicit TraceReader(absl::string_view input) : input_(input) {}
+
+  bool ReadByte(uint8_t& value) {
+    if (input_.empty()) {
+      return false;
+    }
+    value = static_cast<uint8_t>(input_.front());
+    input_.remove_prefix(1);
+    return true;
+  }
+
+  bool ReadVarint(uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      uint8_t byte;
+      if (!ReadByte(byte)) {
+        return false;
+      }
+      value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool ReadSignedVarint(int32_t& value) {
+    uint64_t encoded;
+    if (!ReadVarint(encoded) || encoded > UINT32_MAX) {
+      return false;
+    }
+    uint32_t zigzag = static_cast<uint32_t>(encoded);
+    value = static_cast<int32_t>((zigzag >> 1) ^ (~(zigzag & 1) + 1));
+    return true;
+  }
+
+  bool ReadString(std::string& value) {
+    uint64_t size;
+    if (!ReadVarint(size) || size > input_.size()) {
+      return false;
+    }
+    value = std::string(input_.substr(0, size));
+    input_.remove_prefix(size);
+    return true;
+  }
+
+  bool empty() const { return input_.empty(); }
+
+ private:
+  absl::string_view input_;
+};
+
+absl::Status MalformedTraceError() {
+  return absl::InvalidArgumentError("The serialized trace is malformed.");
+}
+
+}  // namespace
+
+PathTrace* PathTrace::Current() { return current_trace; }
+
+std::string PathTrace::Serialize() const {
+  // The names are stored once in a table, and referenced by the entries.
+  absl::flat_hash_map<const std::string*, uint64_t> name_indexes;
+  std::vector<const std::string*> names;
+  for (const Entry& entry : entries_) {
+    if (entry.type == EntryType::kNode &&
+        name_indexes.emplace(entry.node_name, names.size()).second) {
+      names.push_back(entry.node_name);
+    }
+  }
+
+  std::string output;
+  output.push_back(kFormatVersion);
+  AppendVarint(names.size(), output);
+  for (const std::string* name : names) {
+    AppendVarint(name->size(), output);
+    output.append(*name);
+  }
+  AppendVarint(entries_.size(), output);
+  for (const Entry& entry : entries_) {
+    output.push_back(static_cast<char>(entry.type));
+    switch (entry.type) {
+      case EntryType::kNode:
+        AppendVarint(name_indexes[entry.node_name], output);
+        break;
+      case EntryType::kUpdate:
+        AppendSignedVarint(entry.first, output);
+        AppendSignedVarint(entry.second, output);
+        break;
+      case EntryType::kBranch:
+      case EntryType::kMultiplicity:
+        AppendSignedVarint(entry.first, output);
+        break;
+    }
+  }
+  return output;
+}
+
+absl::StatusOr<std::string> PathTrace::Render(absl::string_view serialized) {
+  TraceReader reader(serialized);
+  uint8_t version;
+  if (!reader.ReadByte(version)) {
+    return MalformedTraceError();
+  }
+  if (version != kFormatVersion) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Unsupported trace format version: ", version));
+  }
+
+  uint64_t name_count;
+  if (!reader.ReadVarint(name_count)) {
+    return MalformedTraceError();
+  }
+  std::vector<std::string> names;
+  for (uint64_t i = 0; i < name_count; ++i) {
+    if (!reader.ReadString(names.emplace_back())) {
+      return MalformedTraceError();
+    }
+  }
+
+  uint64_t entry_count;
+  if (!reader.ReadVarint(entry_count)) {
+    return MalformedTraceError();
+  }
+  std::string output;
+  for (uint64_t i = 0; i < entry_count; ++i) {
+    uint8_t type;
+    if (!reader.ReadByte(type)) {
+      return MalformedTraceError();
+    }
+    switch (static_cast<EntryType>(type)) {
+      case EntryType::kNode: {
+        uint64_t name_index;
+        if (!reader.ReadVarint(name_index) || name_index >= names.size()) {
+          return MalformedTraceError();
+        }
+        const std::string& name = names[name_index];
+        absl::StrAppend(&output, "node: ", name.empty() ? "<unnamed>" : name,
+                        "\n");
+        break;
+      }
+      case EntryType::kBranch: {
+        int32_t branch_index;
+        if (!reader.ReadSignedVarint(branch_index)) {
+          return MalformedTraceError();
+        }
+        absl::StrAppend(&output, "branch: ", branch_index, "\n");
+        break;
+      }
+      case EntryType::kUpdate: {
+        int32_t row_index;
+        int32_t column_index;
+        if (!reader.ReadSignedVarint(row_index) ||
+            !reader.ReadSignedVarint(column_index)) {
+          return MalformedTraceError();
+        }
+        absl::StrAppend(&output, "update: row=", row_index,
+                        " column=", column_index, "\n");
+        break;
+      }
+      case EntryType::kMultiplicity: {
+        int32_t clone_count;
+        if (!reader.ReadSignedVarint(clone_count)) {
+          return MalformedTraceError();
+        }
+        absl::StrAppend(&output, "multiplicity: clones=", clone_count, "\n");
+        break;
+      }
+      default:
+        return MalformedTraceError();
+    }
+  }
+  if (!reader.empty()) {
+    return MalformedTraceError();
+  }
+  return output;
+}
+
+ScopedPathTrace::ScopedPathTrace(PathTrace* trace) : previous_(current_trace) {
+  current_trace = trace;
+}
+
+ScopedPathTrace::~ScopedPathTrace() { current_trace = previous_; }
+
+}  // namespace wfa_virtual_people
@@ -0,0 +1,139 @@
+// Copyright 2026 The Cross-Media Measurement Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_MODEL_UTILS_PATH_TRACE_H_
+#define SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_MODEL_UTILS_PATH_TRACE_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+
+namespace wfa_virtual_people {
+
+// Records the path of an event through the model: the nodes visited, the
+// branch selected by each branch node, the row and column selected by each
+// attributes updater, and the number of clones created by multiplicity.
+//
+// Recording only appends a fixed size entry to a buffer, which is reused
+// across events after Clear. The names of the nodes are referenced, not
+// copied, so the model must outlive the trace until it is serialized.
+//
+// The model nodes record to the trace of the current thread, which is set by
+// ScopedPathTrace. Nothing is recorded when no trace is set.
+class PathTrace {
+ public:
+  enum class EntryType : uint8_t {
+    // A node is applied. Uses node_name.
+    kNode = 1,
+    // A branch is selected by a branch node. Uses first as the branch index.
+    kBranch = 2,
+    // An attributes updater updates the event. Uses first as the row index and
+    // second as the column index, or -1 if not applicable.
+    kUpdate = 3,
+    // An event is cloned by multiplicity. Uses first as the clone count.
+    kMultiplicity = 4,
+  };
+
+  struct Entry {
+    EntryType type;
+    const std::string* node_name;
+    int32_t first;
+    int32_t second;
+  };
+
+  // The number of entries preallocated for each trace.
+  static constexpr int kInitialCapacity = 64;
+
+  PathTrace() { entries_.reserve(kInitialCapacity); }
+
+  PathTrace(const PathTrace&) = delete;
+  PathTrace& operator=(const PathTrace&) = delete;
+
+  // Returns the trace of the current thread, or null if no trace is set.
+  static PathTrace* Current();
+
+  void RecordNode(const std::string& node_name) {
+    entries_.push_back({EntryType::kNode, &node_name, 0, 0});
+  }
+  void RecordBranch(int branch_index) {
+    entries_.push_back({EntryType::kBranch, nullptr, branch_index, 0});
+  }
+  void RecordUpdate(int row_index, int column_index) {
+    entries_.push_back({EntryType::kUpdate, nullptr, row_index, column_index});
+  }
+  void RecordMultiplicity(int clone_count) {
+    entries_.push_back({EntryType::kMultiplicity, nullptr, clone_count, 0});
+  }
+
+  // Removes all the entries, keeping the allocated buffer.
+  void Clear() { entries_.clear(); }
+
+  absl::Span<const Entry> entries() const { return entries_; }
+
+  // Encodes the trace in a compact binary format, which can be rendered by
+  // Render without the model.
+  std::string Serialize() const;
+
+  // Renders the @serialized trace as human readable text, one entry per line.
+  // Returns error status if @serialized is not a valid serialized trace.
+  static absl::StatusOr<std::string> Render(absl::string_view serialized);
+
+ private:
+  std::vector<Entry> entries_;
+};
+
+// Sets @trace as the trace of the current thread while in scope, and restores
+// the previous trace when going out of scope.
+class ScopedPathTrace {
+ public:
+  explicit ScopedPathTrace(PathTrace* trace);
+  ~ScopedPathTrace();
+
+  ScopedPathTrace(const ScopedPathTrace&) = delete;
+  ScopedPathTrace& operator=(const ScopedPathTrace&) = delete;
+
+ private:
+  PathTrace* previous_;
+};
+
+// Helpers for model nodes to record to the trace of the current thread, if
+// any.
+inline void TraceNode(const std::string& node_name) {
+  if (PathTrace* trace = PathTrace::Current()) {
+    trace->RecordNode(node_name);
+  }
+}
+inline void TraceBranch(int branch_index) {
+  if (PathTrace* trace = PathTrace::Current()) {
+    trace->RecordBranch(branch_index);
+  }
+}
+inline void TraceUpdate(int row_index, int column_index) {
+  if (PathTrace* trace = PathTrace::Current()) {
+    trace->RecordUpdate(row_index, column_index);
+  }
+}
+inline void TraceMultiplicity(int clone_count) {
+  if (PathTrace* trace = PathTrace::Current()) {
+    trace->RecordMultiplicity(clone_count);
+  }
+}
+
+}  // namespace wfa_virtual_people
+
+#endif  // SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_MODEL_UTILS_PATH_TRACE_H_
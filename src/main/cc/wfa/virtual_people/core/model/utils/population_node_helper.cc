@@ -14,15 +14,20 @@
 
 #include "wfa/virtual_people/core/model/utils/population_node_helper.h"
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <utility>
 #include <vector>
 
+#include "absl/hash/hash.h"
+#include "absl/memory/memory.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "common_cpp/macros/macros.h"
 #include "wfa/virtual_people/common/label.pb.h"
 #include "wfa/virtual_people/common/model.pb.h"
@@ -56,4 +61,155 @@ absl::Status CollapseQuantumLabel(const QuantumLabel& quantum_label,
   return absl::OkStatus();
 }
 
+namespace {
+
+absl::string_view AsBytes(absl::Span<const double> values) {
+  return absl::string_view(reinterpret_cast<const char*>(values.data()),
+                           values.size() * sizeof(double));
+}
+
+}  // namespace
+
+size_t QuantumLabelCollapser::KeyHash::operator()(const Key& key) const {
+  return absl::HashOf(key.seed, AsBytes(key.probabilities));
+}
+
+size_t QuantumLabelCollapser::KeyHash::operator()(
+    const std::unique_ptr<CompiledQuantumLabel>& value) const {
+  return (*this)(GetKey(*value));
+}
+
+bool QuantumLabelCollapser::KeyEq::operator()(const Key& a,
+                                              const Key& b) const {
+  return a.seed == b.seed &&
+         AsBytes(a.probabilities) == AsBytes(b.probabilities);
+}
+
+bool QuantumLabelCollapser::KeyEq::operator()(
+    const std::unique_ptr<CompiledQuantumLabel>& a, const Key& b) const {
+  return (*this)(GetKey(*a), b);
+}
+
+bool QuantumLabelCollapser::KeyEq::operator()(
+    const Key& a, const std::unique_ptr<CompiledQuantumLabel>& b) const {
+  return (*this)(a, GetKey(*b));
+}
+
+bool QuantumLabelCollapser::KeyEq::operator()(
+    const std::unique_ptr<CompiledQuantumLabel>& a,
+    const std::unique_ptr<CompiledQuantumLabel>& b) const {
+  return (*this)(GetKey(*a), GetKey(*b));
+}
+
+QuantumLabelCollapser::Key QuantumLabelCollapser::GetKey(
+    const CompiledQuantumLabel& compiled) {
+  return Key({compiled.seed, compiled.probabilities});
+}
+
+QuantumLabelCollapser::Key QuantumLabelCollapser::GetKey(
+    const QuantumLabel& quantum_label) {
+  return Key({quantum_label.seed(),
+              absl::MakeConstSpan(quantum_label.probabilities().data(),
+                                  quantum_label.probabilities_size())});
+}
+
+std::shared_ptr<const QuantumLabelCollapser::Precompiled>
+QuantumLabelCollapser::Precompile(
+    absl::Span<const QuantumLabel* const> quantum_labels) {
+  auto precompiled = std::make_shared<Precompiled>();
+  for (const QuantumLabel* quantum_label : quantum_labels) {
+    if (quantum_label->labels_size() == 0 ||
+        quantum_label->labels_size() != quantum_label->probabilities_size() ||
+        precompiled->compiled_.contains(GetKey(*quantum_label))) {
+      continue;
+    }
+    absl::StatusOr<std::unique_ptr<CompiledQuantumLabel>> compiled =
+        Compile(*quantum_label);
+    if (compiled.ok()) {
+      precompiled->compiled_.insert(*std::move(compiled));
+    }
+  }
+  return precompiled;
+}
+
+void QuantumLabelCollapser::UsePrecompiled(
+    std::shared_ptr<const Precompiled> precompiled) {
+  precompiled_ = std::move(precompiled);
+}
+
+absl::StatusOr<std::unique_ptr<QuantumLabelCollapser::CompiledQuantumLabel>>
+QuantumLabelCollapser::Compile(const QuantumLabel& quantum_label) {
+  std::vector<DistributionChoice> distribution;
+  distribution.reserve(quantum_label.probabilities_size());
+  for (int i = 0; i < quantum_label.probabilities_size(); ++i) {
+    distribution.emplace_back(
+        DistributionChoice({i, quantum_label.probabilities(i)}));
+  }
+  auto compiled = absl::make_unique<CompiledQuantumLabel>();
+  ASSIGN_OR_RETURN(compiled->hashing, DistributedConsistentHashing::Build(
+                                          std::move(distribution)));
+  compiled->seed = quantum_label.seed();
+  compiled->probabilities.assign(quantum_label.probabilities().begin(),
+                                 quantum_label.probabilities().end());
+  compiled->seed_prefix =
+      absl::StrCat("quantum-label-collapse-", quantum_label.seed());
+  return compiled;
+}
+
+absl::Status QuantumLabelCollapser::Collapse(
+    const QuantumLabel& quantum_label, uint64_t seed_suffix,
+    PersonLabelAttributes& output_label) const {
+  if (quantum_label.labels_size() == 0) {
+    return absl::InvalidArgumentError("Empty quantum label.");
+  }
+  if (quantum_label.labels_size() != quantum_label.probabilities_size()) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "The sizes of labels and probabilities are different in quantum label ",
+        quantum_label.DebugString()));
+  }
+
+  Key key = GetKey(quantum_label);
+  const CompiledQuantumLabel* compiled = nullptr;
+  if (precompiled_) {
+    auto it = precompiled_->compiled_.find(key);
+    if (it != precompiled_->compiled_.end()) {
+      compiled = it->get();
+    }
+  }
+  if (!compiled) {
+    std::lock_guard<std::mutex> lock(cache_mtx_);
+    auto it = cache_.find(key);
+    if (it != cache_.end()) {
+      compiled = it->get();
+    }
+  }
+
+  // Only used if the cache is full.
+  std::unique_ptr<CompiledQuantumLabel> uncached = nullptr;
+  if (!compiled) {
+    ASSIGN_OR_RETURN(std::unique_ptr<CompiledQuantumLabel> built,
+                     Compile(quantum_label));
+    std::lock_guard<std::mutex> lock(cache_mtx_);
+    // Another thread may have added the same quantum label in the meantime.
+    auto it = cache_.find(key);
+    if (it != cache_.end()) {
+      compiled = it->get();
+    } else if (cache_.size() < kMaxCacheSize) {
+      compiled = cache_.insert(std::move(built)).first->get();
+    } else {
+      uncached = std::move(built);
+      compiled = uncached.get();
+    }
+  }
+
+  int32_t index = compiled->hashing->Hash(compiled->seed_prefix, seed_suffix);
+  output_label.MergeFrom(quantum_label.labels(index));
+  return absl::OkStatus();
+}
+
+size_t QuantumLabelCollapser::cache_size() const {
+  std::lock_guard<std::mutex> lock(cache_mtx_);
+  return cache_.size();
+}
+
 }  // namespace wfa_virtual_people
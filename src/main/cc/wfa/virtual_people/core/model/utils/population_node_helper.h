@@ -15,10 +15,21 @@
 #ifndef SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_MODEL_UTILS_POPULATION_NODE_HELPER_H_
 #define SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_MODEL_UTILS_POPULATION_NODE_HELPER_H_
 
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "wfa/virtual_people/common/label.pb.h"
 #include "wfa/virtual_people/common/model.pb.h"
+#include "wfa/virtual_people/core/model/utils/distributed_consistent_hashing.h"
 
 namespace wfa_virtual_people {
 
@@ -29,6 +40,120 @@ absl::Status CollapseQuantumLabel(const QuantumLabel& quantum_label,
                                   absl::string_view seed_suffix,
                                   PersonLabelAttributes& output_label);
 
+// Collapses quantum labels the same way as CollapseQuantumLabel, but builds the
+// hashing of each distinct quantum label only once.
+//
+// The quantum labels of the events usually come from a few update matrix rows,
+// which are known when the model is built. They can be compiled ahead of
+// labeling by Precompile, into a table shared by the collapsers of all the
+// population nodes of the model. The table is never modified after being
+// built, so collapsing a precompiled quantum label takes no lock, and is a
+// hash and a label merge.
+//
+// Other quantum labels are compiled when they are first collapsed, and cached
+// by the seed and the probabilities, up to kMaxCacheSize of them. Only this
+// cache is guarded by a mutex.
+//
+// Thread safe, except UsePrecompiled.
+class QuantumLabelCollapser {
+ public:
+  QuantumLabelCollapser() = default;
+
+  QuantumLabelCollapser(const QuantumLabelCollapser&) = delete;
+  QuantumLabelCollapser& operator=(const QuantumLabelCollapser&) = delete;
+
+  // The quantum labels compiled ahead of labeling.
+  class Precompiled;
+
+  // Compiles the distinct quantum labels in @quantum_labels. Invalid quantum
+  // labels are skipped, so that they fail when they are collapsed, as the
+  // quantum labels not precompiled.
+  static std::shared_ptr<const Precompiled> Precompile(
+      absl::Span<const QuantumLabel* const> quantum_labels);
+
+  // Looks up the quantum labels in @precompiled before the cache.
+  //
+  // Not thread safe. Must be called before Collapse is called from any thread.
+  void UsePrecompiled(std::shared_ptr<const Precompiled> precompiled);
+
+  // Same as CollapseQuantumLabel(@quantum_label, absl::StrCat(@seed_suffix),
+  // @output_label).
+  absl::Status Collapse(const QuantumLabel& quantum_label, uint64_t seed_suffix,
+                        PersonLabelAttributes& output_label) const;
+
+  // Returns the number of cached quantum labels, not including the
+  // precompiled ones.
+  size_t cache_size() const;
+
+  // The max number of cached quantum labels. Quantum labels beyond this are
+  // compiled for each call.
+  static constexpr size_t kMaxCacheSize = 1024;
+
+ private:
+  struct CompiledQuantumLabel {
+    std::string seed;
+    std::vector<double> probabilities;
+    // "quantum-label-collapse-<seed>".
+    std::string seed_prefix;
+    std::unique_ptr<DistributedConsistentHashing> hashing;
+  };
+
+  // Identifies a quantum label in the cache, without copying it.
+  struct Key {
+    absl::string_view seed;
+    absl::Span<const double> probabilities;
+  };
+
+  // Transparent hash and equality, so that the cache is looked up by Key.
+  // The probabilities are compared by their bits.
+  struct KeyHash {
+    using is_transparent = void;
+    size_t operator()(const Key& key) const;
+    size_t operator()(const std::unique_ptr<CompiledQuantumLabel>& value) const;
+  };
+  struct KeyEq {
+    using is_transparent = void;
+    bool operator()(const Key& a, const Key& b) const;
+    bool operator()(const std::unique_ptr<CompiledQuantumLabel>& a,
+                    const Key& b) const;
+    bool operator()(const Key& a,
+                    const std::unique_ptr<CompiledQuantumLabel>& b) const;
+    bool operator()(const std::unique_ptr<CompiledQuantumLabel>& a,
+                    const std::unique_ptr<CompiledQuantumLabel>& b) const;
+  };
+
+  using CompiledQuantumLabelSet =
+      absl::flat_hash_set<std::unique_ptr<CompiledQuantumLabel>, KeyHash,
+                          KeyEq>;
+
+  static Key GetKey(const CompiledQuantumLabel& compiled);
+  static Key GetKey(const QuantumLabel& quantum_label);
+
+  // Builds the hashing of @quantum_label. Returns error status if the quantum
+  // label is invalid.
+  static absl::StatusOr<std::unique_ptr<CompiledQuantumLabel>> Compile(
+      const QuantumLabel& quantum_label);
+
+  // Null if UsePrecompiled is not called.
+  std::shared_ptr<const Precompiled> precompiled_;
+
+  // Guards cache_.
+  mutable std::mutex cache_mtx_;
+  // The entries are never removed, so the pointers to them stay valid.
+  mutable CompiledQuantumLabelSet cache_;
+};
+
+class QuantumLabelCollapser::Precompiled {
+ public:
+  // Returns the number of precompiled quantum labels.
+  size_t size() const { return compiled_.size(); }
+
+ private:
+  friend class QuantumLabelCollapser;
+
+  CompiledQuantumLabelSet compiled_;
+};
+
 }  // namespace wfa_virtual_people
 
 #endif  // SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_MODEL_UTILS_POPULATION_NODE_HELPER_H_
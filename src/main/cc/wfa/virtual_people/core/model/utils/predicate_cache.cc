@@ -0,0 +1,146 @@
+// Copyright 2026 The Cross-Media Measurement Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "wfa/virtual_people/core/model/utils/predicate_cache.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/numeric/bits.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "wfa/virtual_people/common/field_filter.pb.h"
+#include "wfa/virtual_people/common/model.pb.h"
+
+namespace wfa_virtual_people {
+
+namespace {
+
+thread_local PredicateCache* current_cache = nullptr;
+
+EventFieldMask GetEventFieldMask(
+    const google::protobuf::FieldDescriptor& field) {
+  return EventFieldMask{1} << std::min(field.index(), kEventFieldMaskBits - 1);
+}
+
+// Returns the top level fields of LabelerEvent read by @config.
+EventFieldMask GetReadFields(const FieldFilterProto& config) {
+  EventFieldMask read_fields = 0;
+  if (config.has_name()) {
+    absl::string_view name = config.name();
+    const google::protobuf::FieldDescriptor* field =
+        LabelerEvent::GetDescriptor()->FindFieldByName(
+            std::string(name.substr(0, name.find('.'))));
+    if (!field) {
+      return kAllEventFields;
+    }
+    read_fields |= GetEventFieldMask(*field);
+  }
+  // The sub filters of PARTIAL refer to the fields of the message field of
+  // @config.name.
+  if (config.op() != FieldFilterProto::PARTIAL) {
+    for (const FieldFilterProto& sub_filter : config.sub_filters()) {
+      read_fields |= GetReadFields(sub_filter);
+    }
+  }
+  return read_fields;
+}
+
+}  // namespace
+
+EventFieldMask GetEventFieldMask(
+    const std::vector<const google::protobuf::FieldDescriptor*>& path) {
+  if (path.empty()) {
+    return kAllEventFields;
+  }
+  return GetEventFieldMask(*path.front());
+}
+
+EventFieldMask GetSetEventFields(const LabelerEvent& event) {
+  std::vector<const google::protobuf::FieldDescriptor*> fields;
+  event.GetReflection()->ListFields(event, &fields);
+  EventFieldMask set_fields = 0;
+  for (const google::protobuf::FieldDescriptor* field : fields) {
+    set_fields |= GetEventFieldMask(*field);
+  }
+  return set_fields;
+}
+
+PredicateConfig MakePredicateConfig(const FieldFilterProto& config) {
+  PredicateConfig predicate_config;
+  {
+    google::protobuf::io::StringOutputStream stream(&predicate_config.key);
+    google::protobuf::io::CodedOutputStream output(&stream);
+    output.SetSerializationDeterministic(true);
+    config.SerializeToCodedStream(&output);
+  }
+  predicate_config.read_fields = GetReadFields(config);
+  return predicate_config;
+}
+
+int PredicateRegistry::Register(const PredicateConfig& config) {
+  auto [it, inserted] = ids_.try_emplace(config.key, size());
+  int id = it->second;
+  if (!inserted) {
+    return id;
+  }
+  size_t word_count = (ids_.size() + 63) / 64;
+  for (int bit = 0; bit < kEventFieldMaskBits; ++bit) {
+    std::vector<uint64_t>& readers = readers_[bit];
+    readers.resize(word_count, 0);
+    if (config.read_fields & (EventFieldMask{1} << bit)) {
+      readers[id / 64] |= uint64_t{1} << (id % 64);
+    }
+  }
+  return id;
+}
+
+PredicateCache* PredicateCache::Current() { return current_cache; }
+
+void PredicateCache::Reset(const PredicateRegistry& registry,
+                           const LabelerEvent& event) {
+  registry_ = &registry;
+  event_ = &event;
+  size_t word_count = (registry.size() + 63) / 64;
+  known_.assign(word_count, 0);
+  values_.resize(word_count);
+}
+
+void PredicateCache::Invalidate(EventFieldMask fields) {
+  if (fields == kAllEventFields) {
+    std::fill(known_.begin(), known_.end(), 0);
+    return;
+  }
+  while (fields) {
+    int bit = absl::countr_zero(fields);
+    fields &= fields - 1;
+    const std::vector<uint64_t>& readers = registry_->readers(bit);
+    for (size_t i = 0; i < readers.size(); ++i) {
+      known_[i] &= ~readers[i];
+    }
+  }
+}
+
+ScopedPredicateCache::ScopedPredicateCache(PredicateCache* cache)
+    : previous_(current_cache) {
+  current_cache = cache;
+}
+
+ScopedPredicateCache::~ScopedPredicateCache() { current_cache = previous_; }
+
+}  // namespace wfa_virtual_people
@@ -0,0 +1,178 @@
+// Copyright 2026 The Cross-Media Measurement Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_MODEL_UTILS_PREDICATE_CACHE_H_
+#define SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_MODEL_UTILS_PREDICATE_CACHE_H_
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "google/protobuf/descriptor.h"
+#include "wfa/virtual_people/common/field_filter.pb.h"
+#include "wfa/virtual_people/common/field_filter/field_filter.h"
+#include "wfa/virtual_people/common/model.pb.h"
+
+namespace wfa_virtual_people {
+
+// A set of top level fields of LabelerEvent, as a mask of the field indexes.
+// Fields with index 63 or above share the last bit.
+using EventFieldMask = uint64_t;
+
+constexpr EventFieldMask kAllEventFields = ~EventFieldMask{0};
+constexpr int kEventFieldMaskBits = 64;
+
+// Returns the mask of the top level field of the field @path in LabelerEvent.
+EventFieldMask GetEventFieldMask(
+    const std::vector<const google::protobuf::FieldDescriptor*>& path);
+
+// Returns the mask of the top level fields set in @event.
+EventFieldMask GetSetEventFields(const LabelerEvent& event);
+
+// The id of a predicate that is not registered.
+constexpr int kNoPredicateId = -1;
+
+// A FieldFilterProto to be registered to a PredicateRegistry.
+struct PredicateConfig {
+  // The deterministic serialization of the FieldFilterProto. Predicates with
+  // the same key are structurally identical.
+  std::string key;
+  // The top level fields of LabelerEvent read by the predicate.
+  EventFieldMask read_fields = kAllEventFields;
+};
+
+PredicateConfig MakePredicateConfig(const FieldFilterProto& config);
+
+// Assigns ids to the structurally identical predicates across a model, so that
+// the result of each predicate can be cached per event by PredicateCache.
+class PredicateRegistry {
+ public:
+  PredicateRegistry() = default;
+
+  PredicateRegistry(const PredicateRegistry&) = delete;
+  PredicateRegistry& operator=(const PredicateRegistry&) = delete;
+
+  // Returns the id of the predicate of @config, which is shared by all the
+  // predicates with the same key.
+  int Register(const PredicateConfig& config);
+
+  // The number of distinct predicates.
+  int size() const { return static_cast<int>(ids_.size()); }
+
+  // Returns the bitset of the predicates reading the field at @bit of
+  // EventFieldMask, as 64-bit words.
+  const std::vector<uint64_t>& readers(int bit) const { return readers_[bit]; }
+
+ private:
+  absl::flat_hash_map<std::string, int> ids_;
+  std::array<std::vector<uint64_t>, kEventFieldMaskBits> readers_;
+};
+
+// Caches the results of the predicates in a PredicateRegistry for one event.
+//
+// The model nodes use the cache of the current thread, which is set by
+// ScopedPredicateCache. The cached results are dropped when the event is
+// updated, through InvalidatePredicates, for the predicates reading the updated
+// fields. Only the event passed to Reset is cached; other events, e.g. the
+// clones created by multiplicity, are evaluated directly.
+class PredicateCache {
+ public:
+  PredicateCache() = default;
+
+  PredicateCache(const PredicateCache&) = delete;
+  PredicateCache& operator=(const PredicateCache&) = delete;
+
+  // Returns the cache of the current thread, or null if no cache is set.
+  static PredicateCache* Current();
+
+  // Drops all the results, and starts caching the predicates in @registry for
+  // @event. The buffers are reused across events.
+  void Reset(const PredicateRegistry& registry, const LabelerEvent& event);
+
+  // Returns whether @filter, which is the predicate with @id, matches @event.
+  // Uses the cached result if any, otherwise evaluates @filter and caches the
+  // result.
+  bool IsMatch(int id, const FieldFilter& filter, const LabelerEvent& event) {
+    uint64_t bit = uint64_t{1} << (id % 64);
+    uint64_t& known = known_[id / 64];
+    if (known & bit) {
+      return values_[id / 64] & bit;
+    }
+    bool is_match = filter.IsMatch(event);
+    known |= bit;
+    if (is_match) {
+      values_[id / 64] |= bit;
+    } else {
+      values_[id / 64] &= ~bit;
+    }
+    return is_match;
+  }
+
+  // Drops the results of the predicates reading any of @fields.
+  void Invalidate(EventFieldMask fields);
+
+  // The event being cached.
+  const LabelerEvent* event() const { return event_; }
+
+ private:
+  const PredicateRegistry* registry_ = nullptr;
+  const LabelerEvent* event_ = nullptr;
+  // Bitsets of the predicates with cached results, and the cached results.
+  std::vector<uint64_t> known_;
+  std::vector<uint64_t> values_;
+};
+
+// Sets @cache as the cache of the current thread while in scope, and restores
+// the previous cache when going out of scope.
+class ScopedPredicateCache {
+ public:
+  explicit ScopedPredicateCache(PredicateCache* cache);
+  ~ScopedPredicateCache();
+
+  ScopedPredicateCache(const ScopedPredicateCache&) = delete;
+  ScopedPredicateCache& operator=(const ScopedPredicateCache&) = delete;
+
+ private:
+  PredicateCache* previous_;
+};
+
+// Helpers for model nodes to use the cache of the current thread, if any.
+
+// Returns whether @filter, which is the predicate with @id, matches @event.
+// @id can be kNoPredicateId, in which case @filter is always evaluated.
+inline bool MatchPredicate(int id, const FieldFilter& filter,
+                           const LabelerEvent& event) {
+  if (id != kNoPredicateId) {
+    PredicateCache* cache = PredicateCache::Current();
+    if (cache && cache->event() == &event) {
+      return cache->IsMatch(id, filter, event);
+    }
+  }
+  return filter.IsMatch(event);
+}
+
+// Must be called after @fields in @event are updated.
+inline void InvalidatePredicates(const LabelerEvent& event,
+                                 EventFieldMask fields) {
+  PredicateCache* cache = PredicateCache::Current();
+  if (cache && cache->event() == &event) {
+    cache->Invalidate(fields);
+  }
+}
+
+}  // namespace wfa_virtual_people
+
+#endif  // SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_MODEL_UTILS_PREDICATE_CACHE_H_
@@ -0,0 +1,141 @@
+// Copyright 2026 The Cross-Media Measurement Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "wfa/virtual_people/core/model/utils/row_patch.h"
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/types/variant.h"
+#include "common_cpp/macros/macros.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/message.h"
+#include "wfa/virtual_people/common/model.pb.h"
+#include "wfa/virtual_people/core/model/utils/field_accessor.h"
+
+namespace wfa_virtual_people {
+
+using ::google::protobuf::FieldDescriptor;
+using ::google::protobuf::Message;
+using ::google::protobuf::Reflection;
+
+absl::StatusOr<RowPatch> RowPatch::Build(const LabelerEvent& row) {
+  std::vector<FieldWrite> writes;
+  std::vector<const FieldDescriptor*> path;
+  ASSIGN_OR_RETURN(bool is_compiled, CollectWrites(row, path, writes));
+  if (!is_compiled) {
+    writes.clear();
+  }
+  return RowPatch(row, std::move(writes), is_compiled);
+}
+
+RowPatch::RowPatch(const LabelerEvent& row, std::vector<FieldWrite>&& writes,
+                   bool is_compiled)
+    : row_(row), writes_(std::move(writes)), is_compiled_(is_compiled) {}
+
+absl::StatusOr<bool> RowPatch::CollectWrites(
+    const Message& message, std::vector<const FieldDescriptor*>& path,
+    std::vector<FieldWrite>& writes) {
+  const Reflection* reflection = message.GetReflection();
+  if (!reflection->GetUnknownFields(message).empty()) {
+    return false;
+  }
+  std::vector<const FieldDescriptor*> fields;
+  reflection->ListFields(message, &fields);
+  for (const FieldDescriptor* field : fields) {
+    // Repeated fields are appended by MergeFrom.
+    if (field->is_repeated() || field->is_extension()) {
+      return false;
+    }
+    path.push_back(field);
+    if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+      const Message& sub_message = reflection->GetMessage(message, field);
+      // MergeFrom sets an empty message field, which has no field to write.
+      if (sub_message.ByteSizeLong() == 0) {
+        return false;
+      }
+      ASSIGN_OR_RETURN(bool is_compiled,
+                       CollectWrites(sub_message, path, writes));
+      if (!is_compiled) {
+        return false;
+      }
+      path.pop_back();
+      continue;
+    }
+
+    ASSIGN_OR_RETURN(FieldAccessor accessor, FieldAccessor::Build(path));
+    path.pop_back();
+    FieldValue value;
+    switch (field->cpp_type()) {
+      case FieldDescriptor::CPPTYPE_INT32:
+        value = reflection->GetInt32(message, field);
+        break;
+      case FieldDescriptor::CPPTYPE_INT64:
+        value = reflection->GetInt64(message, field);
+        break;
+      case FieldDescriptor::CPPTYPE_UINT32:
+        value = reflection->GetUInt32(message, field);
+        break;
+      case FieldDescriptor::CPPTYPE_UINT64:
+        value = reflection->GetUInt64(message, field);
+        break;
+      case FieldDescriptor::CPPTYPE_FLOAT:
+        value = reflection->GetFloat(message, field);
+        break;
+      case FieldDescriptor::CPPTYPE_DOUBLE:
+        value = reflection->GetDouble(message, field);
+        break;
+      case FieldDescriptor::CPPTYPE_BOOL:
+        value = reflection->GetBool(message, field);
+        break;
+      case FieldDescriptor::CPPTYPE_ENUM:
+        value = EnumValue{reflection->GetEnumValue(message, field)};
+        break;
+      case FieldDescriptor::CPPTYPE_STRING:
+        value = reflection->GetString(message, field);
+        break;
+      default:
+        return false;
+    }
+    writes.push_back({std::move(accessor), std::move(value)});
+  }
+  return true;
+}
+
+void RowPatch::Apply(LabelerEvent& event) const {
+  if (!is_compiled_) {
+    event.MergeFrom(row_);
+    return;
+  }
+  for (const FieldWrite& write : writes_) {
+    absl::visit(
+        [&event, &field = write.field](const auto& value) {
+          using ValueType = std::decay_t<decltype(value)>;
+          if constexpr (std::is_same_v<ValueType, EnumValue>) {
+            field.SetEnumValue(event, value.number);
+          } else if constexpr (std::is_same_v<ValueType, std::string>) {
+            field.SetString(event, value);
+          } else {
+            field.Set<ValueType>(event, value);
+          }
+        },
+        write.value);
+  }
+}
+
+}  // namespace wfa_virtual_people
@@ -0,0 +1,84 @@
+// Copyright 2026 The Cross-Media Measurement Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_MODEL_UTILS_ROW_PATCH_H_
+#define SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_MODEL_UTILS_ROW_PATCH_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/types/variant.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/message.h"
+#include "wfa/virtual_people/common/model.pb.h"
+#include "wfa/virtual_people/core/model/utils/field_accessor.h"
+
+namespace wfa_virtual_people {
+
+// Merges a row of an updater, like a row of UpdateMatrix or an update of
+// ConditionalMerge, into events.
+//
+// The row is compiled into the list of the singular fields set in it, with
+// their values. Applying the patch writes each of them to the event, which has
+// the same result as LabelerEvent::MergeFrom, without walking all the fields of
+// LabelerEvent. Rows that cannot be compiled, e.g. rows with repeated fields,
+// are merged with LabelerEvent::MergeFrom.
+class RowPatch {
+ public:
+  // Returns error status if failing to compile @row, which should never happen.
+  static absl::StatusOr<RowPatch> Build(const LabelerEvent& row);
+
+  // Merges the row into @event.
+  void Apply(LabelerEvent& event) const;
+
+  // The row this patch is compiled from.
+  const LabelerEvent& row() const { return row_; }
+
+  // Whether the row is compiled into field writes. If not, Apply merges the
+  // row with LabelerEvent::MergeFrom.
+  bool is_compiled() const { return is_compiled_; }
+
+ private:
+  // The value of an enum field.
+  struct EnumValue {
+    int number;
+  };
+  using FieldValue = absl::variant<int32_t, int64_t, uint32_t, uint64_t, float,
+                                   double, bool, EnumValue, std::string>;
+  struct FieldWrite {
+    FieldAccessor field;
+    FieldValue value;
+  };
+
+  RowPatch(const LabelerEvent& row, std::vector<FieldWrite>&& writes,
+           bool is_compiled);
+
+  // Appends the writes of the fields set in @message, which is at @path in
+  // LabelerEvent, to @writes. Returns false if any field cannot be written
+  // this way.
+  static absl::StatusOr<bool> CollectWrites(
+      const google::protobuf::Message& message,
+      std::vector<const google::protobuf::FieldDescriptor*>& path,
+      std::vector<FieldWrite>& writes);
+
+  LabelerEvent row_;
+  std::vector<FieldWrite> writes_;
+  bool is_compiled_;
+};
+
+}  // namespace wfa_virtual_people
+
+#endif  // SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_MODEL_UTILS_ROW_PATCH_H_
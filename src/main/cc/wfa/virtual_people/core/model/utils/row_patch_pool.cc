@@ -0,0 +1,71 @@
+// Copyright 2026 The Cross-Media Measurement Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "wfa/virtual_people/core/model/utils/row_patch_pool.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/status/statusor.h"
+#include "common_cpp/macros/macros.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "wfa/virtual_people/common/model.pb.h"
+#include "wfa/virtual_people/core/model/utils/row_patch.h"
+
+namespace wfa_virtual_people {
+
+namespace {
+
+// Map iteration order is not part of the default serialization, so rows with
+// map fields are only guaranteed to have the same bytes when serialized
+// deterministically.
+std::string SerializeRow(const LabelerEvent& row) {
+  std::string serialized_row;
+  google::protobuf::io::StringOutputStream stream(&serialized_row);
+  google::protobuf::io::CodedOutputStream output(&stream);
+  output.SetSerializationDeterministic(true);
+  row.SerializeToCodedStream(&output);
+  output.Trim();
+  return serialized_row;
+}
+
+}  // namespace
+
+absl::StatusOr<int32_t> RowPatchPool::Add(const LabelerEvent& row) {
+  std::string serialized_row = SerializeRow(row);
+  auto it = ids_.find(serialized_row);
+  if (it != ids_.end()) {
+    return it->second;
+  }
+  ASSIGN_OR_RETURN(RowPatch patch, RowPatch::Build(row));
+  int32_t id = static_cast<int32_t>(patches_.size());
+  ids_.emplace(std::move(serialized_row), id);
+  patches_.push_back(std::make_shared<const RowPatch>(std::move(patch)));
+  return id;
+}
+
+std::shared_ptr<const RowPatch> RowPatchPool::Intern(
+    std::shared_ptr<const RowPatch> patch) {
+  auto [it, inserted] = ids_.try_emplace(
+      SerializeRow(patch->row()), static_cast<int32_t>(patches_.size()));
+  if (inserted) {
+    patches_.push_back(std::move(patch));
+  }
+  return patches_[it->second];
+}
+
+}  // namespace wfa_virtual_people
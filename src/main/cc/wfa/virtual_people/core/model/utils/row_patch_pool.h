@@ -0,0 +1,68 @@
+// Copyright 2026 The Cross-Media Measurement Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_MODEL_UTILS_ROW_PATCH_POOL_H_
+#define SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_MODEL_UTILS_ROW_PATCH_POOL_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "wfa/virtual_people/common/model.pb.h"
+#include "wfa/virtual_people/core/model/utils/row_patch.h"
+
+namespace wfa_virtual_people {
+
+// Interns the rows merged by the updaters, like the rows of UpdateMatrix and
+// the updates of ConditionalMerge, so that each distinct row is compiled and
+// stored once, and shared by all the updaters using it.
+//
+// Rows are equal if their deterministic serializations are equal. The pool is
+// only needed when building the model: the interned patches are owned by the
+// updaters holding them, and stay valid after the pool is destroyed.
+class RowPatchPool {
+ public:
+  RowPatchPool() = default;
+
+  RowPatchPool(const RowPatchPool&) = delete;
+  RowPatchPool& operator=(const RowPatchPool&) = delete;
+
+  // Returns the id of the patch of @row in the pool. If @row is not in the
+  // pool, it is compiled and added to the pool.
+  //
+  // Returns error status if failing to compile @row.
+  absl::StatusOr<int32_t> Add(const LabelerEvent& row);
+
+  // Returns the patch in the pool with the same row as @patch. If there is
+  // none, @patch is added to the pool and returned.
+  std::shared_ptr<const RowPatch> Intern(
+      std::shared_ptr<const RowPatch> patch);
+
+  // All the patches in the pool, indexed by id.
+  const std::vector<std::shared_ptr<const RowPatch>>& patches() const {
+    return patches_;
+  }
+
+ private:
+  // The ids of the patches, keyed by the serializations of their rows.
+  absl::flat_hash_map<std::string, int32_t> ids_;
+  std::vector<std::shared_ptr<const RowPatch>> patches_;
+};
+
+}  // namespace wfa_virtual_people
+
+#endif  // SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_MODEL_UTILS_ROW_PATCH_POOL_H_
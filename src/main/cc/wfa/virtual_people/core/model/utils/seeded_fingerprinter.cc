@@ -0,0 +1,43 @@
+// Copyright 2026 The Cross-Media Measurement Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "wfa/virtual_people/core/model/utils/seeded_fingerprinter.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "absl/container/fixed_array.h"
+#include "absl/strings/str_cat.h"
+#include "src/farmhash.h"
+
+namespace wfa_virtual_people {
+
+namespace {
+
+// The number of decimal digits of the max uint64_t.
+constexpr size_t kMaxUint64Digits = 20;
+
+}  // namespace
+
+uint64_t SeededFingerprinter::Fingerprint(uint64_t value) const {
+  absl::FixedArray<char, kInlineSeedSize> buffer(seed_.size() +
+                                                 kMaxUint64Digits);
+  char* end = std::copy(seed_.begin(), seed_.end(), buffer.begin());
+  absl::AlphaNum digits(value);
+  end = std::copy(digits.data(), digits.data() + digits.size(), end);
+  return util::Fingerprint64(buffer.data(), end - buffer.data());
+}
+
+}  // namespace wfa_virtual_people
@@ -0,0 +1,52 @@
+// Copyright 2026 The Cross-Media Measurement Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_MODEL_UTILS_SEEDED_FINGERPRINTER_H_
+#define SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_MODEL_UTILS_SEEDED_FINGERPRINTER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "absl/strings/string_view.h"
+
+namespace wfa_virtual_people {
+
+// Computes the fingerprints of a fixed seed followed by the decimal
+// representation of a number, i.e.
+//   util::Fingerprint64(absl::StrCat(seed, value))
+// The seed and the number are written to a buffer on the stack, so no memory
+// is allocated per call, unless the seed is longer than kInlineSeedSize.
+//
+// Each model node builds one from its random seed, to fingerprint the acting
+// fingerprints of the events.
+class SeededFingerprinter {
+ public:
+  explicit SeededFingerprinter(absl::string_view seed) : seed_(seed) {}
+
+  // Returns util::Fingerprint64(absl::StrCat(seed(), @value)).
+  uint64_t Fingerprint(uint64_t value) const;
+
+  const std::string& seed() const { return seed_; }
+
+  // Seeds up to this size are written to the stack.
+  static constexpr size_t kInlineSeedSize = 256;
+
+ private:
+  std::string seed_;
+};
+
+}  // namespace wfa_virtual_people
+
+#endif  // SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_MODEL_UTILS_SEEDED_FINGERPRINTER_H_
@@ -14,15 +14,12 @@
 
 #include "wfa/virtual_people/core/model/utils/update_matrix_helper.h"
 
-#include <memory>
-#include <vector>
-
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "wfa/virtual_people/common/model.pb.h"
+#include "wfa/virtual_people/core/model/utils/column_distributions.h"
 #include "wfa/virtual_people/core/model/utils/constants.h"
-#include "wfa/virtual_people/core/model/utils/distributed_consistent_hashing.h"
 #include "wfa/virtual_people/core/model/utils/field_filters_matcher.h"
 #include "wfa/virtual_people/core/model/utils/hash_field_mask_matcher.h"
 
@@ -31,8 +28,7 @@ namespace wfa_virtual_people {
 absl::StatusOr<MatrixIndexes> SelectFromMatrix(
     const HashFieldMaskMatcher* hash_matcher,
     const FieldFiltersMatcher* filters_matcher,
-    const std::vector<std::unique_ptr<DistributedConsistentHashing>>&
-        row_hashings,
+    const ColumnDistributions& row_distributions,
     absl::string_view random_seed, const LabelerEvent& event) {
   int column_index = kNoMatchingIndex;
   if (hash_matcher) {
@@ -43,14 +39,15 @@ absl::StatusOr<MatrixIndexes> SelectFromMatrix(
     return absl::InternalError("No column matcher is set.");
   }
   if (column_index == kNoMatchingIndex) {
-    return MatrixIndexes({kNoMatchingIndex, kNoMatchingIndex});
+    return MatrixIndexes(
+        {kNoMatchingIndex, kNoMatchingIndex, kNoMatchingIndex});
   }
-  if (column_index < 0 || column_index >= row_hashings.size()) {
+  if (column_index < 0 || column_index >= row_distributions.column_count()) {
     return absl::InternalError("The returned index is out of range.");
   }
-  int row_index = row_hashings[column_index]->Hash(
-      absl::StrCat(random_seed, event.acting_fingerprint()));
-  return MatrixIndexes({column_index, row_index});
+  const ColumnChoice& row = row_distributions.Hash(
+      column_index, random_seed, event.acting_fingerprint());
+  return MatrixIndexes({column_index, row.choice_id, row.row_id});
 }
 
 }  // namespace wfa_virtual_people
@@ -15,13 +15,10 @@
 #ifndef SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_MODEL_UTILS_UPDATE_MATRIX_HELPER_H_
 #define SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_CORE_MODEL_UTILS_UPDATE_MATRIX_HELPER_H_
 
-#include <memory>
-#include <vector>
-
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "wfa/virtual_people/common/model.pb.h"
-#include "wfa/virtual_people/core/model/utils/distributed_consistent_hashing.h"
+#include "wfa/virtual_people/core/model/utils/column_distributions.h"
 #include "wfa/virtual_people/core/model/utils/field_filters_matcher.h"
 #include "wfa/virtual_people/core/model/utils/hash_field_mask_matcher.h"
 
@@ -29,27 +26,30 @@ namespace wfa_virtual_people {
 
 struct MatrixIndexes {
   int column_index;
+  // The index of the row in the selected column.
   int row_index;
+  // The id of the row in the rows of the matrix, which is the same as
+  // @row_index unless the rows of the columns are stored in one table.
+  int row_id;
 };
 
 // Gets the indexes of the selected column and row.
 // Column is selected by applying @hash_matcher or @filters_matcher on the
 // @event.
-// Row is selected by applying the hashing of the selected column from
-// @row_hashings.
+// Row is selected by hashing with the distribution of the selected column in
+// @row_distributions.
 //
-// When no column is selected, returns {kNoMatchingIndex, kNoMatchingIndex}.
+// When no column is selected, returns kNoMatchingIndex for all the indexes.
 //
 // @random_seed is used as part of the seed when selecting row by hashing.
 //
 // At least one of @hash_matcher and @filters_matcher cannot be null.
 // The output of applying @hash_matcher or @filters_matcher must be in the range
-// of [0, @row_hashings.size() - 1].
+// of [0, @row_distributions.column_count() - 1].
 absl::StatusOr<MatrixIndexes> SelectFromMatrix(
     const HashFieldMaskMatcher* hash_matcher,
     const FieldFiltersMatcher* filters_matcher,
-    const std::vector<std::unique_ptr<DistributedConsistentHashing>>&
-        row_hashings,
+    const ColumnDistributions& row_distributions,
     absl::string_view random_seed, const LabelerEvent& event);
 
 }  // namespace wfa_virtual_people
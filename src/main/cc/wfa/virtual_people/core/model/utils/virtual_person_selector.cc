@@ -15,6 +15,7 @@
 #include "wfa/virtual_people/core/model/utils/virtual_person_selector.h"
 
 #include <cstdint>
+#include <limits>
 #include <memory>
 #include <utility>
 #include <vector>
@@ -80,6 +81,12 @@ VirtualPersonSelector::Build(
     return absl::InvalidArgumentError(
         "The total population of the pools is 0. The model is invalid.");
   }
+  if (total_population >
+      static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+    return absl::InvalidArgumentError(
+        "The total population of the pools exceeds the maximum supported "
+        "size.");
+  }
   return absl::make_unique<VirtualPersonSelector>(total_population,
                                                   std::move(compiled_pools));
 }
@@ -91,8 +98,8 @@ VirtualPersonSelector::VirtualPersonSelector(
 
 uint64_t VirtualPersonSelector::GetVirtualPersonId(
     const uint64_t random_seed) const {
-  uint64_t population_index =
-      JumpConsistentHash(random_seed, static_cast<int32_t>(total_population_));
+  uint64_t population_index = JumpConsistentHash64(
+      random_seed, static_cast<int64_t>(total_population_));
 
   // Gets the first pool with population_index_offset larger than
   // population_index.
@@ -0,0 +1,91 @@
+// Copyright 2026 The Cross-Media Measurement Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_LABELER_RUNNER_BOUNDED_QUEUE_H_
+#define SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_LABELER_RUNNER_BOUNDED_QUEUE_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+namespace wfa_virtual_people {
+
+// A FIFO queue with bounded capacity, connecting the stages of a pipeline.
+// Push blocks while the queue is full, so that a fast producer waits for a slow
+// consumer.
+//
+// Either side may Close the queue: the producer when it has nothing more to
+// push, or the consumer when it stops early, which unblocks a waiting
+// producer.
+template <typename T>
+class BoundedQueue {
+ public:
+  // @capacity must be positive.
+  explicit BoundedQueue(size_t capacity) : capacity_(capacity) {}
+
+  BoundedQueue(const BoundedQueue&) = delete;
+  BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+  // Blocks until there is room for @item, then pushes it.
+  // Returns false and drops @item if the queue is closed.
+  bool Push(T item) {
+    std::unique_lock<std::mutex> lock(mtx_);
+    not_full_.wait(lock,
+                   [this] { return items_.size() < capacity_ || closed_; });
+    if (closed_) {
+      return false;
+    }
+    items_.push_back(std::move(item));
+    not_empty_.notify_one();
+    return true;
+  }
+
+  // Blocks until an item is available, then pops it.
+  // Returns nullopt if the queue is closed and all the items are popped.
+  std::optional<T> Pop() {
+    std::unique_lock<std::mutex> lock(mtx_);
+    not_empty_.wait(lock, [this] { return !items_.empty() || closed_; });
+    if (items_.empty()) {
+      return std::nullopt;
+    }
+    T item = std::move(items_.front());
+    items_.pop_front();
+    not_full_.notify_one();
+    return item;
+  }
+
+  // Rejects all the following Push calls. The items already pushed can still
+  // be popped.
+  void Close() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    closed_ = true;
+    not_full_.notify_all();
+    not_empty_.notify_all();
+  }
+
+ private:
+  const size_t capacity_;
+  std::mutex mtx_;
+  std::condition_variable not_full_;
+  std::condition_variable not_empty_;
+  std::deque<T> items_;
+  bool closed_ = false;
+};
+
+}  // namespace wfa_virtual_people
+
+#endif  // SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_LABELER_RUNNER_BOUNDED_QUEUE_H_
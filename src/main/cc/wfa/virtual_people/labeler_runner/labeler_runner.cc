@@ -0,0 +1,233 @@
+// Copyright 2026 The Cross-Media Measurement Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "wfa/virtual_people/labeler_runner/labeler_runner.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "glog/logging.h"
+#include "riegeli/bytes/fd_reader.h"
+#include "riegeli/bytes/fd_writer.h"
+#include "riegeli/records/record_reader.h"
+#include "riegeli/records/record_writer.h"
+#include "wfa/virtual_people/common/event.pb.h"
+#include "wfa/virtual_people/common/label.pb.h"
+#include "wfa/virtual_people/core/labeler/labeler.h"
+#include "wfa/virtual_people/core/labeler/parallel_labeler.h"
+#include "wfa/virtual_people/labeler_runner/bounded_queue.h"
+
+namespace wfa_virtual_people {
+
+namespace {
+
+// Consecutive records of an input file. Every file ends with a batch with
+// @last_in_file set, which is empty if the file is empty.
+struct InputBatch {
+  size_t file_index = 0;
+  std::vector<LabelerInput> inputs;
+  bool last_in_file = false;
+};
+
+struct OutputBatch {
+  size_t file_index = 0;
+  std::vector<LabelerOutput> outputs;
+  bool last_in_file = false;
+  absl::Duration labeling_time = absl::ZeroDuration();
+};
+
+// Reads the input files in order, and pushes their records to @input_queue in
+// batches of @batch_size.
+// Returns OK without reading the rest if @input_queue is closed by the
+// labeling loop.
+absl::Status ReadInputFiles(const std::vector<std::string>& input_paths,
+                            size_t batch_size,
+                            BoundedQueue<InputBatch>& input_queue) {
+  for (size_t i = 0; i < input_paths.size(); ++i) {
+    riegeli::RecordReader reader(riegeli::FdReader(input_paths[i]));
+    InputBatch batch;
+    batch.file_index = i;
+    batch.inputs.reserve(batch_size);
+    LabelerInput input;
+    while (reader.ReadRecord(input)) {
+      batch.inputs.push_back(std::move(input));
+      if (batch.inputs.size() < batch_size) {
+        continue;
+      }
+      if (!input_queue.Push(std::move(batch))) {
+        return absl::OkStatus();
+      }
+      batch = InputBatch();
+      batch.file_index = i;
+      batch.inputs.reserve(batch_size);
+    }
+    if (!reader.Close()) {
+      return absl::Status(
+          reader.status().code(),
+          absl::StrCat("Unable to read input file ", input_paths[i], ": ",
+                       reader.status().message()));
+    }
+    batch.last_in_file = true;
+    if (!input_queue.Push(std::move(batch))) {
+      return absl::OkStatus();
+    }
+  }
+  return absl::OkStatus();
+}
+
+// Writes the labeled batches popped from @output_queue to the output files in
+// order, and reports the progress after each file.
+// Returns OK without writing the rest if @output_queue is closed before all
+// the files are written, which only happens if reading or labeling fails.
+absl::Status WriteOutputFiles(const std::vector<std::string>& output_paths,
+                              BoundedQueue<OutputBatch>& output_queue) {
+  absl::Time start_time = absl::Now();
+  int64_t total_records = 0;
+  for (size_t i = 0; i < output_paths.size(); ++i) {
+    riegeli::RecordWriter writer(riegeli::FdWriter(output_paths[i]));
+    int64_t file_records = 0;
+    absl::Duration file_labeling_time = absl::ZeroDuration();
+    bool last_in_file = false;
+    while (!last_in_file) {
+      std::optional<OutputBatch> batch = output_queue.Pop();
+      if (!batch.has_value()) {
+        break;
+      }
+      for (const LabelerOutput& output : batch->outputs) {
+        if (!writer.WriteRecord(output)) {
+          break;
+        }
+      }
+      if (!writer.ok()) {
+        break;
+      }
+      file_records += batch->outputs.size();
+      file_labeling_time += batch->labeling_time;
+      last_in_file = batch->last_in_file;
+    }
+    if (!writer.Close()) {
+      return absl::Status(
+          writer.status().code(),
+          absl::StrCat("Failed to write to file ", output_paths[i], ": ",
+                       writer.status().message()));
+    }
+    if (!last_in_file) {
+      return absl::OkStatus();
+    }
+
+    total_records += file_records;
+    double labeling_seconds = absl::ToDoubleSeconds(file_labeling_time);
+    double elapsed_seconds = absl::ToDoubleSeconds(absl::Now() - start_time);
+    LOG(INFO) << "Wrote " << output_paths[i] << " (" << i + 1 << "/"
+              << output_paths.size() << " files): " << file_records
+              << " records, "
+              << (labeling_seconds > 0 ? file_records / labeling_seconds : 0)
+              << " records/s when labeling; " << total_records
+              << " records in total, "
+              << (elapsed_seconds > 0 ? total_records / elapsed_seconds : 0)
+              << " records/s overall.";
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+absl::StatusOr<int64_t> RunLabeler(ParallelLabeler& labeler,
+                                   const std::vector<std::string>& input_paths,
+                                   const std::vector<std::string>& output_paths,
+                                   const LabelerRunnerOptions& options) {
+  if (input_paths.size() != output_paths.size()) {
+    return absl::InvalidArgumentError(
+        "input_paths and output_paths must have the same size.");
+  }
+  if (options.batch_size <= 0) {
+    return absl::InvalidArgumentError("batch_size must be positive.");
+  }
+  if (options.max_pending_batches <= 0) {
+    return absl::InvalidArgumentError("max_pending_batches must be positive.");
+  }
+
+  // Each stage closes the queue it pushes to when it ends, and the queue it
+  // pops from when it fails, so that the other stages do not wait forever.
+  BoundedQueue<InputBatch> input_queue(options.max_pending_batches);
+  BoundedQueue<OutputBatch> output_queue(options.max_pending_batches);
+  absl::Status read_status;
+  absl::Status write_status;
+  std::thread reader([&] {
+    read_status = ReadInputFiles(input_paths, options.batch_size, input_queue);
+    input_queue.Close();
+  });
+  std::thread writer([&] {
+    write_status = WriteOutputFiles(output_paths, output_queue);
+    output_queue.Close();
+  });
+
+  absl::Status label_status;
+  int64_t labeled_records = 0;
+  while (std::optional<InputBatch> input_batch = input_queue.Pop()) {
+    OutputBatch output_batch;
+    output_batch.file_index = input_batch->file_index;
+    output_batch.last_in_file = input_batch->last_in_file;
+    output_batch.outputs.resize(input_batch->inputs.size());
+
+    absl::Time labeling_start_time = absl::Now();
+    label_status = labeler.LabelBatch(
+        input_batch->inputs, absl::MakeSpan(output_batch.outputs),
+        options.mode);
+    if (!label_status.ok()) {
+      label_status = absl::Status(
+          label_status.code(),
+          absl::StrCat("Failed to label ",
+                       input_paths[input_batch->file_index], ": ",
+                       label_status.message()));
+      break;
+    }
+    output_batch.labeling_time = absl::Now() - labeling_start_time;
+    labeled_records += input_batch->inputs.size();
+
+    // Release the inputs before waiting for the writer.
+    input_batch.reset();
+    if (!output_queue.Push(std::move(output_batch))) {
+      break;
+    }
+  }
+  input_queue.Close();
+  output_queue.Close();
+  reader.join();
+  writer.join();
+
+  if (!read_status.ok()) {
+    return read_status;
+  }
+  if (!label_status.ok()) {
+    return label_status;
+  }
+  if (!write_status.ok()) {
+    return write_status;
+  }
+  return labeled_records;
+}
+
+}  // namespace wfa_virtual_people
@@ -0,0 +1,58 @@
+// Copyright 2026 The Cross-Media Measurement Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_LABELER_RUNNER_LABELER_RUNNER_H_
+#define SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_LABELER_RUNNER_LABELER_RUNNER_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "wfa/virtual_people/core/labeler/labeler.h"
+#include "wfa/virtual_people/core/labeler/parallel_labeler.h"
+
+namespace wfa_virtual_people {
+
+struct LabelerRunnerOptions {
+  // The number of records read, labeled and written together.
+  int batch_size = 4096;
+  // The maximum number of batches read ahead of labeling, and the maximum
+  // number of labeled batches waiting to be written.
+  int max_pending_batches = 4;
+  LabelingMode mode = LabelingMode::kFull;
+};
+
+// Labels the LabelerInput records of each Riegeli file in @input_paths with
+// @labeler, and writes the LabelerOutput records to the Riegeli file at the
+// same position of @output_paths. Each output record is at the same position
+// as its input record.
+//
+// The records are streamed in batches of @options.batch_size. Reading,
+// labeling and writing run concurrently on bounded queues of batches, so at
+// most 2 * @options.max_pending_batches + 4 batches are in memory,
+// whatever the file sizes.
+//
+// Returns the number of labeled records.
+// Returns error status if the options are invalid, @input_paths and
+// @output_paths have different sizes, or any file fails to be read, labeled
+// or written.
+absl::StatusOr<int64_t> RunLabeler(ParallelLabeler& labeler,
+                                   const std::vector<std::string>& input_paths,
+                                   const std::vector<std::string>& output_paths,
+                                   const LabelerRunnerOptions& options);
+
+}  // namespace wfa_virtual_people
+
+#endif  // SRC_MAIN_CC_WFA_VIRTUAL_PEOPLE_LABELER_RUNNER_LABELER_RUNNER_H_
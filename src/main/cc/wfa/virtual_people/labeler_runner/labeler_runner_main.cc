@@ -0,0 +1,144 @@
+// Copyright 2026 The Cross-Media Measurement Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This tool labels LabelerInput records with a model in node list
+// representation, and writes the LabelerOutput records, all in Riegeli format.
+//
+// Each input file is labeled into the output file at the same position of
+// --output_paths, and each output record is at the same position as its input
+// record. The records are streamed in batches of --batch_size. Reading,
+// labeling and writing run concurrently, with at most --max_pending_batches
+// batches read ahead and at most --max_pending_batches labeled batches waiting
+// to be written, which bounds the memory usage whatever the file sizes.
+//
+// Example usage:
+// bazel run //src/main/cc/wfa/virtual_people/labeler_runner:labeler_runner_main \
+// -- \
+// --model_path=/tmp/labeler_runner/node_list_model_riegeli \
+// --input_paths=/tmp/labeler_runner/input_1,/tmp/labeler_runner/input_2 \
+// --output_paths=/tmp/labeler_runner/output_1,/tmp/labeler_runner/output_2 \
+// --num_threads=16
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "common_cpp/protobuf_util/riegeli_io.h"
+#include "glog/logging.h"
+#include "wfa/virtual_people/common/model.pb.h"
+#include "wfa/virtual_people/core/labeler/labeler.h"
+#include "wfa/virtual_people/core/labeler/parallel_labeler.h"
+#include "wfa/virtual_people/labeler_runner/labeler_runner.h"
+
+ABSL_FLAG(std::string, model_path, "",
+          "Path to the model file. The model is in node list representation, "
+          "written in Riegeli format.");
+ABSL_FLAG(std::vector<std::string>, input_paths, {},
+          "Comma separated paths to the input files. Each file contains "
+          "LabelerInput records in Riegeli format.");
+ABSL_FLAG(std::vector<std::string>, output_paths, {},
+          "Comma separated paths to the output files, one for each input "
+          "file. Each file contains the LabelerOutput records of the input "
+          "file at the same position, in Riegeli format.");
+ABSL_FLAG(int, num_threads, 0,
+          "The number of labeling threads. Uses the number of hardware "
+          "threads when not positive.");
+ABSL_FLAG(int, batch_size, 4096,
+          "The number of records read, labeled and written together.");
+ABSL_FLAG(int, max_pending_batches, 4,
+          "The maximum number of batches read ahead of labeling, and the "
+          "maximum number of labeled batches waiting to be written.");
+ABSL_FLAG(bool, pool_identity_mode, false,
+          "Label in pool identity mode, which emits pool assignments instead "
+          "of virtual person ids.");
+
+namespace {
+
+using ::wfa_virtual_people::CompiledNode;
+using ::wfa_virtual_people::Labeler;
+using ::wfa_virtual_people::LabelerRunnerOptions;
+using ::wfa_virtual_people::LabelingMode;
+using ::wfa_virtual_people::ParallelLabeler;
+using ::wfa_virtual_people::RunLabeler;
+
+std::unique_ptr<Labeler> BuildLabeler(const std::string& model_path) {
+  std::vector<CompiledNode> nodes;
+  absl::Status read_status =
+      wfa::ReadRiegeliFile<CompiledNode>(model_path, nodes);
+  CHECK(read_status.ok()) << "Unable to read model file " << model_path << ": "
+                          << read_status;
+  absl::StatusOr<std::unique_ptr<Labeler>> labeler = Labeler::Build(nodes);
+  CHECK(labeler.ok()) << "Failed to build the model: " << labeler.status();
+  return *std::move(labeler);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  absl::ParseCommandLine(argc, argv);
+  google::InitGoogleLogging(argv[0]);
+
+  const std::string model_path = absl::GetFlag(FLAGS_model_path);
+  const std::vector<std::string> input_paths = absl::GetFlag(FLAGS_input_paths);
+  const std::vector<std::string> output_paths =
+      absl::GetFlag(FLAGS_output_paths);
+  CHECK(!model_path.empty()) << "Must set model_path";
+  CHECK(!input_paths.empty()) << "Must set input_paths";
+
+  int num_threads = absl::GetFlag(FLAGS_num_threads);
+  if (num_threads <= 0) {
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  LabelerRunnerOptions options;
+  options.batch_size = absl::GetFlag(FLAGS_batch_size);
+  options.max_pending_batches = absl::GetFlag(FLAGS_max_pending_batches);
+  options.mode = absl::GetFlag(FLAGS_pool_identity_mode)
+                     ? LabelingMode::kPoolIdentity
+                     : LabelingMode::kFull;
+
+  absl::StatusOr<std::unique_ptr<ParallelLabeler>> labeler =
+      ParallelLabeler::Build(BuildLabeler(model_path), num_threads);
+  CHECK(labeler.ok()) << "Failed to build the labeler: " << labeler.status();
+
+  absl::Time start_time = absl::Now();
+  absl::StatusOr<int64_t> total_records =
+      RunLabeler(**labeler, input_paths, output_paths, options);
+  CHECK(total_records.ok()) << "Labeling failed: " << total_records.status();
+  absl::Duration elapsed_time = absl::Now() - start_time;
+
+  std::cout << "Labeled " << *total_records << " records from "
+            << input_paths.size() << " files in " << elapsed_time << " with "
+            << num_threads << " threads." << std::endl;
+  std::vector<ParallelLabeler::WorkerStats> worker_stats =
+      (*labeler)->GetWorkerStats();
+  for (size_t i = 0; i < worker_stats.size(); ++i) {
+    std::cout << "Worker " << i << ": " << worker_stats[i].labeled_events
+              << " records, " << worker_stats[i].stolen_chunks
+              << " stolen chunks, " << worker_stats[i].EventsPerSecond()
+              << " records/s." << std::endl;
+  }
+
+  return 0;
+}
@@ -16,7 +16,6 @@ package org.wfanet.virtualpeople.core.model.utils
 
 import com.google.common.hash.Hashing
 import java.nio.charset.StandardCharsets
-import kotlin.math.ceil
 import kotlin.math.sqrt
 
 object Feistel {
@@ -30,7 +29,7 @@ object Feistel {
   fun permute(value: ULong, domainSize: ULong, seed: String): ULong {
     if (domainSize <= 1uL) return 0uL
 
-    val half = ceil(sqrt(domainSize.toDouble())).toULong()
+    val half = ceilSqrt(domainSize)
     var current = value
 
     do {
@@ -53,4 +52,19 @@ object Feistel {
 
     return current
   }
+
+  /**
+   * Returns the smallest integer whose square is not less than [n].
+   *
+   * The double estimate may be off by a few above 2^52, which would make `half * half` smaller
+   * than the domain, so it is corrected with integer arithmetic.
+   */
+  private fun ceilSqrt(n: ULong): ULong {
+    if (n <= 1uL) return n
+    var root = sqrt(n.toDouble()).toULong()
+    // Make root the floor of the square root, i.e. root^2 <= n < (root + 1)^2.
+    while (root > n / root) root--
+    while (root + 1uL <= n / (root + 1uL)) root++
+    return if (root * root == n) root else root + 1uL
+  }
 }
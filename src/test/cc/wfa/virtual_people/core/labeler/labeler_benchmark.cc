@@ -0,0 +1,370 @@
+// Copyright 2026 The Cross-Media Measurement Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmarks of building the Labeler and labeling events, with the test models
+// and with generated models.
+//
+// Besides the time, each labeling benchmark reports:
+// * events_per_second: the labeling throughput, summed over the threads.
+// * time_per_event: the wall time per event.
+// * allocations_per_event: the number of heap allocations per event.
+//
+// Example usage:
+// bazel run -c opt \
+// //src/test/cc/wfa/virtual_people/core/labeler:labeler_benchmark \
+// -- --benchmark_filter=BM_Label
+//
+// Always build with -c opt, and compare the results of the same benchmark
+// between builds on the same machine.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/types/span.h"
+#include "benchmark/benchmark.h"
+#include "common_cpp/protobuf_util/riegeli_io.h"
+#include "common_cpp/protobuf_util/textproto_io.h"
+#include "wfa/virtual_people/common/event.pb.h"
+#include "wfa/virtual_people/common/label.pb.h"
+#include "wfa/virtual_people/common/model.pb.h"
+#include "wfa/virtual_people/core/labeler/labeler.h"
+#include "wfa/virtual_people/core/labeler/parallel_labeler.h"
+
+// Counts the heap allocations of each thread.
+namespace {
+thread_local int64_t allocation_count = 0;
+}  // namespace
+
+void* operator new(size_t size) {
+  ++allocation_count;
+  if (void* ptr = std::malloc(size)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+
+namespace wfa_virtual_people {
+namespace {
+
+const char kTestDataDir[] = "src/main/resources/testing/labeler/";
+const char kToyModel[] = "toy_model_riegeli_list";
+const char kSingleIdModel[] = "single_id_model_riegeli_list";
+
+// The number of test inputs in kTestDataDir.
+constexpr int kTestInputCount = 18;
+
+// The number of distinct events labeled by each benchmark.
+constexpr int kEventCount = 4096;
+
+// The model used by a benchmark. The test models are read from kTestDataDir,
+// and the generated models are balanced trees of branch nodes selecting by
+// chance, with ranked population nodes as leaves.
+enum ModelType : int64_t {
+  kToyModelType = 0,
+  kSingleIdModelType = 1,
+  // A tree of depth 4 and fanout 8, with 4681 nodes.
+  kGeneratedWideModelType = 2,
+  // A tree of depth 14 and fanout 2, with 32767 nodes.
+  kGeneratedDeepModelType = 3,
+};
+
+const char* ModelName(int64_t model_type) {
+  switch (model_type) {
+    case kToyModelType:
+      return "toy";
+    case kSingleIdModelType:
+      return "single_id";
+    case kGeneratedWideModelType:
+      return "generated_wide";
+    case kGeneratedDeepModelType:
+      return "generated_deep";
+    default:
+      return "unknown";
+  }
+}
+
+// Appends the nodes of a generated sub-tree of @depth to @nodes, children
+// before parents, and returns the index of its root.
+uint32_t AppendGeneratedNodes(int depth, int fanout,
+                              std::vector<CompiledNode>& nodes) {
+  uint32_t index = static_cast<uint32_t>(nodes.size()) + 1;
+  if (depth == 0) {
+    CompiledNode& leaf = nodes.emplace_back();
+    leaf.set_name(absl::StrCat("leaf_", index));
+    leaf.set_index(index);
+    RankedPopulationNode* population = leaf.mutable_ranked_population_node();
+    PopulationNode::VirtualPersonPool* pool = population->add_pools();
+    pool->set_population_offset(index * 1000);
+    pool->set_total_population(1000);
+    population->set_random_seed(absl::StrCat("leaf_seed_", index));
+    population->set_ranked_size(500);
+    population->set_unranked_mode(RankedPopulationNode::DISJOINT);
+    return index;
+  }
+
+  std::vector<uint32_t> child_indexes;
+  for (int i = 0; i < fanout; ++i) {
+    child_indexes.push_back(AppendGeneratedNodes(depth - 1, fanout, nodes));
+  }
+  CompiledNode& node = nodes.emplace_back();
+  index = static_cast<uint32_t>(nodes.size());
+  node.set_name(absl::StrCat("branch_", index));
+  node.set_index(index);
+  BranchNode* branch_node = node.mutable_branch_node();
+  for (uint32_t child_index : child_indexes) {
+    BranchNode::Branch* branch = branch_node->add_branches();
+    branch->set_node_index(child_index);
+    branch->set_chance(1.0 / fanout);
+  }
+  branch_node->set_random_seed(absl::StrCat("branch_seed_", index));
+  return index;
+}
+
+// Returns the nodes of the model, in the order accepted by Labeler::Build.
+std::vector<CompiledNode> GetModelNodes(int64_t model_type) {
+  std::vector<CompiledNode> nodes;
+  switch (model_type) {
+    case kToyModelType:
+    case kSingleIdModelType: {
+      const char* file =
+          model_type == kToyModelType ? kToyModel : kSingleIdModel;
+      absl::Status status =
+          wfa::ReadRiegeliFile(absl::StrCat(kTestDataDir, file), nodes);
+      if (!status.ok()) {
+        std::cerr << "Unable to read the model: " << status << std::endl;
+        std::abort();
+      }
+      break;
+    }
+    case kGeneratedWideModelType:
+      AppendGeneratedNodes(/*depth=*/4, /*fanout=*/8, nodes);
+      break;
+    case kGeneratedDeepModelType:
+      AppendGeneratedNodes(/*depth=*/14, /*fanout=*/2, nodes);
+      break;
+  }
+  // The root node must not have index set.
+  nodes.back().clear_index();
+  return nodes;
+}
+
+std::unique_ptr<Labeler> BuildLabeler(int64_t model_type) {
+  absl::StatusOr<std::unique_ptr<Labeler>> labeler =
+      Labeler::Build(GetModelNodes(model_type));
+  if (!labeler.ok()) {
+    std::cerr << "Unable to build the labeler: " << labeler.status()
+              << std::endl;
+    std::abort();
+  }
+  return *std::move(labeler);
+}
+
+// Returns kEventCount inputs, made from the test inputs with distinct event
+// ids, so that the events take different paths through the models.
+const std::vector<LabelerInput>& GetInputs() {
+  static const std::vector<LabelerInput>* const inputs = [] {
+    std::vector<LabelerInput> test_inputs(kTestInputCount);
+    for (int i = 0; i < kTestInputCount; ++i) {
+      std::string path = absl::StrFormat("%slabeler_input_%02d.textproto",
+                                         kTestDataDir, i + 1);
+      absl::Status status = wfa::ReadTextProtoFile(path, test_inputs[i]);
+      if (!status.ok()) {
+        std::cerr << "Unable to read the input: " << status << std::endl;
+        std::abort();
+      }
+    }
+    auto* inputs = new std::vector<LabelerInput>(kEventCount);
+    for (int i = 0; i < kEventCount; ++i) {
+      LabelerInput& input = (*inputs)[i];
+      input = test_inputs[i % kTestInputCount];
+      input.mutable_event_id()->set_id(
+          absl::StrCat(input.event_id().id(), "_", i));
+    }
+    return inputs;
+  }();
+  return *inputs;
+}
+
+// Sets the counters of a labeling benchmark which labels @events events with
+// @allocations heap allocations in the current thread.
+void SetLabelingCounters(benchmark::State& state, int64_t events,
+                         int64_t allocations) {
+  state.SetItemsProcessed(events);
+  state.counters["events_per_second"] =
+      benchmark::Counter(events, benchmark::Counter::kIsRate);
+  state.counters["time_per_event"] = benchmark::Counter(
+      events, benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+  state.counters["allocations_per_event"] = benchmark::Counter(
+      events > 0 ? static_cast<double>(allocations) / events : 0,
+      benchmark::Counter::kAvgThreads);
+}
+
+// Args: model type.
+void BM_Build(benchmark::State& state) {
+  std::vector<CompiledNode> nodes = GetModelNodes(state.range(0));
+  for (auto _ : state) {
+    absl::StatusOr<std::unique_ptr<Labeler>> labeler = Labeler::Build(nodes);
+    if (!labeler.ok()) {
+      state.SkipWithError("Unable to build the labeler.");
+      return;
+    }
+    benchmark::DoNotOptimize(labeler);
+  }
+  state.SetLabel(ModelName(state.range(0)));
+  state.counters["nodes"] = nodes.size();
+}
+BENCHMARK(BM_Build)
+    ->Arg(kToyModelType)
+    ->Arg(kSingleIdModelType)
+    ->Arg(kGeneratedWideModelType)
+    ->Arg(kGeneratedDeepModelType)
+    ->Unit(benchmark::kMillisecond);
+
+// The Labeler shared by the threads of BM_Label.
+std::unique_ptr<Labeler> shared_labeler;
+
+void SetUpSharedLabeler(const benchmark::State& state) {
+  shared_labeler = BuildLabeler(state.range(0));
+}
+
+void TearDownSharedLabeler(const benchmark::State& state) {
+  shared_labeler.reset();
+}
+
+// Labels one event per iteration with Labeler::Label, from all the benchmark
+// threads sharing one Labeler.
+//
+// Args: model type, labeling mode.
+void BM_Label(benchmark::State& state) {
+  const Labeler* labeler = shared_labeler.get();
+  LabelingMode mode = static_cast<LabelingMode>(state.range(1));
+  const std::vector<LabelerInput>& inputs = GetInputs();
+
+  // Label each input once before measuring, so that the lazily initialized
+  // state is not measured.
+  LabelerOutput output;
+  for (const LabelerInput& input : inputs) {
+    if (!labeler->Label(input, output, mode).ok()) {
+      state.SkipWithError("Unable to label the input.");
+      return;
+    }
+  }
+
+  size_t next_input = state.thread_index();
+  int64_t start_allocations = allocation_count;
+  for (auto _ : state) {
+    absl::Status status = labeler->Label(inputs[next_input], output, mode);
+    benchmark::DoNotOptimize(status);
+    next_input = (next_input + 1) % inputs.size();
+  }
+  SetLabelingCounters(state, state.iterations(),
+                      allocation_count - start_allocations);
+  state.SetLabel(absl::StrCat(
+      ModelName(state.range(0)),
+      mode == LabelingMode::kFull ? "/full" : "/pool_identity"));
+}
+BENCHMARK(BM_Label)
+    ->ArgsProduct({{kToyModelType, kSingleIdModelType, kGeneratedWideModelType,
+                    kGeneratedDeepModelType},
+                   {static_cast<int64_t>(LabelingMode::kFull),
+                    static_cast<int64_t>(LabelingMode::kPoolIdentity)}})
+    ->Setup(SetUpSharedLabeler)
+    ->Teardown(TearDownSharedLabeler)
+    ->ThreadRange(1, 8)
+    ->UseRealTime();
+
+// Labels kEventCount events per iteration with Labeler::LabelBatch.
+//
+// Args: model type, labeling mode.
+void BM_LabelBatch(benchmark::State& state) {
+  std::unique_ptr<Labeler> labeler = BuildLabeler(state.range(0));
+  LabelingMode mode = static_cast<LabelingMode>(state.range(1));
+  const std::vector<LabelerInput>& inputs = GetInputs();
+  std::vector<LabelerOutput> outputs(inputs.size());
+
+  int64_t start_allocations = allocation_count;
+  for (auto _ : state) {
+    absl::Status status =
+        labeler->LabelBatch(inputs, absl::MakeSpan(outputs), mode);
+    if (!status.ok()) {
+      state.SkipWithError("Unable to label the batch.");
+      return;
+    }
+  }
+  SetLabelingCounters(state, state.iterations() * inputs.size(),
+                      allocation_count - start_allocations);
+  state.SetLabel(absl::StrCat(
+      ModelName(state.range(0)),
+      mode == LabelingMode::kFull ? "/full" : "/pool_identity"));
+}
+BENCHMARK(BM_LabelBatch)
+    ->ArgsProduct({{kToyModelType, kSingleIdModelType, kGeneratedWideModelType,
+                    kGeneratedDeepModelType},
+                   {static_cast<int64_t>(LabelingMode::kFull),
+                    static_cast<int64_t>(LabelingMode::kPoolIdentity)}})
+    ->Unit(benchmark::kMicrosecond);
+
+// Labels kEventCount events per iteration with ParallelLabeler::LabelBatch.
+// The allocations of the worker threads are not counted.
+//
+// Args: model type, number of worker threads.
+void BM_ParallelLabelBatch(benchmark::State& state) {
+  absl::StatusOr<std::unique_ptr<ParallelLabeler>> labeler =
+      ParallelLabeler::Build(BuildLabeler(state.range(0)),
+                             static_cast<int>(state.range(1)));
+  if (!labeler.ok()) {
+    state.SkipWithError("Unable to build the parallel labeler.");
+    return;
+  }
+  const std::vector<LabelerInput>& inputs = GetInputs();
+  std::vector<LabelerOutput> outputs(inputs.size());
+
+  for (auto _ : state) {
+    absl::Status status =
+        (*labeler)->LabelBatch(inputs, absl::MakeSpan(outputs));
+    if (!status.ok()) {
+      state.SkipWithError("Unable to label the batch.");
+      return;
+    }
+  }
+  int64_t events = state.iterations() * inputs.size();
+  state.SetItemsProcessed(events);
+  state.counters["events_per_second"] =
+      benchmark::Counter(events, benchmark::Counter::kIsRate);
+  state.counters["time_per_event"] = benchmark::Counter(
+      events, benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+  state.SetLabel(ModelName(state.range(0)));
+}
+BENCHMARK(BM_ParallelLabelBatch)
+    ->ArgsProduct({{kToyModelType, kGeneratedDeepModelType}, {1, 2, 4, 8}})
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace wfa_virtual_people
+
+BENCHMARK_MAIN();
@@ -15,24 +15,33 @@
 #include "wfa/virtual_people/core/labeler/labeler.h"
 
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "common_cpp/testing/common_matchers.h"
 #include "common_cpp/testing/status_macros.h"
 #include "common_cpp/testing/status_matchers.h"
 #include "gmock/gmock.h"
+#include "google/protobuf/arena.h"
 #include "google/protobuf/text_format.h"
 #include "gtest/gtest.h"
 #include "wfa/virtual_people/common/event.pb.h"
 #include "wfa/virtual_people/common/label.pb.h"
 #include "wfa/virtual_people/common/model.pb.h"
+#include "wfa/virtual_people/core/model/model_stats.h"
 
 namespace wfa_virtual_people {
 namespace {
 
 using ::testing::DoubleNear;
+using ::testing::ElementsAre;
+using ::testing::Not;
 using ::testing::Pair;
 using ::testing::UnorderedElementsAre;
+using ::wfa::EqualsProto;
 using ::wfa::IsOk;
 using ::wfa::StatusIs;
 
@@ -489,15 +498,467 @@ TEST(LabelerTest, SerializedDebugTracePopulatedWhenEnableDebugTraceTrue) {
   LabelerOutput output;
   EXPECT_THAT(labeler->Label(input, output), IsOk());
   EXPECT_FALSE(output.serialized_debug_trace().empty());
-  // The trace is the DebugString() of the LabelerEvent, so the input event
-  // id we set should be visible verbatim in the trace.
-  EXPECT_NE(output.serialized_debug_trace().find("evt_42"), std::string::npos);
-  // And the trace should be re-parseable as a LabelerEvent text format,
-  // round-tripping back to the original input event id.
-  LabelerEvent rebuilt;
+  // The trace is the compact path of the event through the model, which is
+  // rendered on demand.
+  ASSERT_OK_AND_ASSIGN(
+      std::string rendered_trace,
+      Labeler::RenderDebugTrace(output.serialized_debug_trace()));
+  EXPECT_EQ(rendered_trace,
+            "node: TestNode1\n"
+            "branch: 0\n"
+            "node: <unnamed>\n");
+}
+
+TEST(LabelerTest, SerializedDebugTraceWithMultiplicityAndUpdates) {
+  CompiledNode root;
+  ASSERT_TRUE(google::protobuf::TextFormat::ParseFromString(
+      R"pb(
+        name: "TestRoot"
+        branch_node {
+          branches {
+            node {
+              name: "TestMultiplicity"
+              branch_node {
+                branches {
+                  node {
+                    name: "TestPopulation"
+                    population_node {
+                      pools { population_offset: 10 total_population: 1 }
+                      random_seed: "TestPopulationNodeSeed"
+                    }
+                  }
+                  chance: 1.0
+                }
+                random_seed: "TestMultiplicitySeed"
+                multiplicity {
+                  expected_multiplicity: 2
+                  max_value: 2
+                  cap_at_max: false
+                  person_index_field: "multiplicity_person_index"
+                  random_seed: "TestMultiplicitySeed"
+                }
+              }
+            }
+            chance: 1.0
+          }
+          random_seed: "TestRootSeed"
+          updates {
+            updates {
+              update_matrix {
+                columns { labeler_input { event_id { id: "evt_42" } } }
+                rows { person_country_code: "COUNTRY_1" }
+                probabilities: 1.0
+                random_seed: "TestUpdateMatrixSeed"
+              }
+            }
+          }
+        }
+      )pb",
+      &root));
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<Labeler> labeler, Labeler::Build(root));
+
+  LabelerInput input;
+  input.mutable_event_id()->set_id("evt_42");
+  input.set_enable_debug_trace(true);
+  LabelerOutput output;
+  EXPECT_THAT(labeler->Label(input, output), IsOk());
+  EXPECT_EQ(output.people_size(), 2);
+  ASSERT_OK_AND_ASSIGN(
+      std::string rendered_trace,
+      Labeler::RenderDebugTrace(output.serialized_debug_trace()));
+  EXPECT_EQ(rendered_trace,
+            "node: TestRoot\n"
+            "update: row=0 column=0\n"
+            "branch: 0\n"
+            "node: TestMultiplicity\n"
+            "multiplicity: clones=2\n"
+            "branch: 0\n"
+            "node: TestPopulation\n"
+            "branch: 0\n"
+            "node: TestPopulation\n");
+}
+
+TEST(LabelerTest, RenderDebugTraceMalformed) {
+  EXPECT_THAT(Labeler::RenderDebugTrace("").status(),
+              StatusIs(absl::StatusCode::kInvalidArgument, ""));
+}
+
+TEST(LabelerTest, LabelBatchMatchesLabel) {
+  // A model with
+  // * 40% probability to assign virtual person id 10
+  // * 60% probability to assign virtual person id 20
+  CompiledNode root;
+  ASSERT_TRUE(google::protobuf::TextFormat::ParseFromString(
+      R"pb(
+        name: "TestNode1"
+        branch_node {
+          branches {
+            node {
+              population_node {
+                pools { population_offset: 10 total_population: 1 }
+                random_seed: "TestPopulationNodeSeed1"
+              }
+            }
+            chance: 0.4
+          }
+          branches {
+            node {
+              population_node {
+                pools { population_offset: 20 total_population: 1 }
+                random_seed: "TestPopulationNodeSeed2"
+              }
+            }
+            chance: 0.6
+          }
+          random_seed: "TestBranchNodeSeed"
+        }
+      )pb",
+      &root));
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<Labeler> labeler, Labeler::Build(root));
+
+  std::vector<LabelerInput> inputs(100);
+  for (int event_id = 0; event_id < inputs.size(); ++event_id) {
+    inputs[event_id].mutable_event_id()->set_id(std::to_string(event_id));
+  }
+  // Enable debug trace on some of the inputs, to make sure the trace of one
+  // event is not leaked to the next one.
+  inputs[3].set_enable_debug_trace(true);
+
+  std::vector<LabelerOutput> outputs(inputs.size());
+  EXPECT_THAT(labeler->LabelBatch(inputs, absl::MakeSpan(outputs)), IsOk());
+
+  for (int i = 0; i < inputs.size(); ++i) {
+    LabelerOutput expected_output;
+    EXPECT_THAT(labeler->Label(inputs[i], expected_output), IsOk());
+    EXPECT_THAT(outputs[i], EqualsProto(expected_output));
+  }
+  EXPECT_FALSE(outputs[3].serialized_debug_trace().empty());
+  EXPECT_EQ(outputs[4].serialized_debug_trace(), "");
+}
+
+TEST(LabelerTest, LabelBatchPoolIdentityMode) {
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<Labeler> labeler,
+                       BuildSinglePoolLabeler());
+  std::vector<LabelerInput> inputs(3);
+  for (int event_id = 0; event_id < inputs.size(); ++event_id) {
+    inputs[event_id].mutable_event_id()->set_id(std::to_string(event_id));
+  }
+
+  std::vector<LabelerOutput> outputs(inputs.size());
+  EXPECT_THAT(labeler->LabelBatch(inputs, absl::MakeSpan(outputs),
+                                  LabelingMode::kPoolIdentity),
+              IsOk());
+
+  for (int i = 0; i < inputs.size(); ++i) {
+    LabelerOutput expected_output;
+    EXPECT_THAT(
+        labeler->Label(inputs[i], expected_output, LabelingMode::kPoolIdentity),
+        IsOk());
+    EXPECT_THAT(outputs[i], EqualsProto(expected_output));
+  }
+}
+
+TEST(LabelerTest, LabelOnArenaMatchesLabel) {
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<Labeler> labeler,
+                       BuildSinglePoolLabeler());
+  google::protobuf::Arena arena;
+  for (int event_id = 0; event_id < 10; ++event_id) {
+    LabelerInput input;
+    input.mutable_event_id()->set_id(std::to_string(event_id));
+    input.set_enable_debug_trace(true);
+
+    LabelerOutput expected_output;
+    EXPECT_THAT(labeler->Label(input, expected_output), IsOk());
+
+    // The output can be allocated on the same arena.
+    LabelerOutput* output =
+        google::protobuf::Arena::Create<LabelerOutput>(&arena);
+    EXPECT_THAT(labeler->Label(input, *output, LabelingMode::kFull, &arena),
+                IsOk());
+    EXPECT_THAT(*output, EqualsProto(expected_output));
+  }
+}
+
+TEST(LabelerTest, LabelWithNullArena) {
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<Labeler> labeler,
+                       BuildSinglePoolLabeler());
+  LabelerInput input;
+  input.mutable_event_id()->set_id("evt_42");
+  LabelerOutput output;
+  EXPECT_THAT(labeler->Label(input, output, LabelingMode::kFull, nullptr),
+              IsOk());
+  EXPECT_EQ(output.people(0).virtual_person_id(), 10);
+}
+
+TEST(LabelerTest, LabelBatchOnArenaMatchesLabelBatch) {
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<Labeler> labeler,
+                       BuildSinglePoolLabeler());
+  std::vector<LabelerInput> inputs(10);
+  for (int event_id = 0; event_id < inputs.size(); ++event_id) {
+    inputs[event_id].mutable_event_id()->set_id(std::to_string(event_id));
+  }
+
+  std::vector<LabelerOutput> expected_outputs(inputs.size());
+  EXPECT_THAT(labeler->LabelBatch(inputs, absl::MakeSpan(expected_outputs)),
+              IsOk());
+
+  google::protobuf::Arena arena;
+  std::vector<LabelerOutput> outputs(inputs.size());
+  EXPECT_THAT(labeler->LabelBatch(inputs, absl::MakeSpan(outputs),
+                                  LabelingMode::kFull, &arena),
+              IsOk());
+  for (int i = 0; i < inputs.size(); ++i) {
+    EXPECT_THAT(outputs[i], EqualsProto(expected_outputs[i]));
+  }
+}
+
+TEST(LabelerTest, LabelMovedInputMatchesLabel) {
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<Labeler> labeler,
+                       BuildSinglePoolLabeler());
+  for (int event_id = 0; event_id < 10; ++event_id) {
+    LabelerInput input;
+    input.mutable_event_id()->set_id(std::to_string(event_id));
+    input.mutable_profile_info()->mutable_email_user_info()->set_user_id(
+        "user_" + std::to_string(event_id));
+    input.set_enable_debug_trace(true);
+
+    LabelerOutput expected_output;
+    EXPECT_THAT(labeler->Label(input, expected_output), IsOk());
+
+    LabelerOutput output;
+    EXPECT_THAT(labeler->Label(std::move(input), output), IsOk());
+    EXPECT_THAT(output, EqualsProto(expected_output));
+  }
+}
+
+TEST(LabelerTest, LabelMovedInputPoolIdentityMode) {
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<Labeler> labeler,
+                       BuildSinglePoolLabeler());
+  LabelerInput input;
+  input.mutable_event_id()->set_id("evt_42");
+
+  LabelerOutput expected_output;
+  EXPECT_THAT(
+      labeler->Label(input, expected_output, LabelingMode::kPoolIdentity),
+      IsOk());
+
+  LabelerOutput output;
+  EXPECT_THAT(
+      labeler->Label(std::move(input), output, LabelingMode::kPoolIdentity),
+      IsOk());
+  EXPECT_THAT(output, EqualsProto(expected_output));
+}
+
+TEST(LabelerTest, LabelReplacesPreviousOutput) {
+  // Labels are moved to the output, which must not keep the labels of the
+  // previous event.
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<Labeler> labeler,
+                       BuildSinglePoolLabeler());
+  LabelerOutput output;
+  for (int event_id = 0; event_id < 3; ++event_id) {
+    LabelerInput input;
+    input.mutable_event_id()->set_id(std::to_string(event_id));
+    EXPECT_THAT(labeler->Label(std::move(input), output), IsOk());
+    EXPECT_EQ(output.people_size(), 1);
+  }
+}
+
+TEST(LabelerTest, FingerprintLabelerInputs) {
+  std::vector<LabelerInput> inputs(2);
+  inputs[0].mutable_event_id()->set_id("evt_1");
+  inputs[0].mutable_profile_info()->mutable_email_user_info()->set_user_id(
+      "user_1");
+  inputs[0].mutable_profile_info()->mutable_phone_user_info();
+  inputs[1].mutable_event_id()->set_id("evt_2");
+
+  FingerprintLabelerInputs(absl::MakeSpan(inputs));
+
+  EXPECT_TRUE(inputs[0].event_id().has_id_fingerprint());
+  EXPECT_TRUE(
+      inputs[0].profile_info().email_user_info().has_user_id_fingerprint());
+  // No user_id is set.
+  EXPECT_FALSE(
+      inputs[0].profile_info().phone_user_info().has_user_id_fingerprint());
+  EXPECT_TRUE(inputs[1].event_id().has_id_fingerprint());
+  EXPECT_NE(inputs[0].event_id().id_fingerprint(),
+            inputs[1].event_id().id_fingerprint());
+}
+
+TEST(LabelerTest, UsePrecomputedFingerprints) {
+  // A model with
+  // * 40% probability to assign virtual person id 10
+  // * 60% probability to assign virtual person id 20
+  CompiledNode root;
   ASSERT_TRUE(google::protobuf::TextFormat::ParseFromString(
-      output.serialized_debug_trace(), &rebuilt));
-  EXPECT_EQ(rebuilt.labeler_input().event_id().id(), "evt_42");
+      R"pb(
+        name: "TestNode1"
+        branch_node {
+          branches {
+            node {
+              population_node {
+                pools { population_offset: 10 total_population: 1 }
+                random_seed: "TestPopulationNodeSeed1"
+              }
+            }
+            chance: 0.4
+          }
+          branches {
+            node {
+              population_node {
+                pools { population_offset: 20 total_population: 1 }
+                random_seed: "TestPopulationNodeSeed2"
+              }
+            }
+            chance: 0.6
+          }
+          random_seed: "TestBranchNodeSeed"
+        }
+      )pb",
+      &root));
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<Labeler> labeler, Labeler::Build(root));
+  LabelerOptions options;
+  options.use_precomputed_fingerprints = true;
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<Labeler> precomputed_labeler,
+                       Labeler::Build(root, options));
+
+  std::vector<LabelerInput> inputs(100);
+  for (int event_id = 0; event_id < inputs.size(); ++event_id) {
+    inputs[event_id].mutable_event_id()->set_id(std::to_string(event_id));
+  }
+  std::vector<LabelerInput> fingerprinted_inputs = inputs;
+  FingerprintLabelerInputs(absl::MakeSpan(fingerprinted_inputs));
+
+  // The labels are the same when the fingerprints are precomputed.
+  for (int i = 0; i < inputs.size(); ++i) {
+    LabelerOutput expected_output;
+    EXPECT_THAT(labeler->Label(inputs[i], expected_output), IsOk());
+    LabelerOutput output;
+    EXPECT_THAT(precomputed_labeler->Label(fingerprinted_inputs[i], output),
+                IsOk());
+    EXPECT_THAT(output, EqualsProto(expected_output));
+  }
+
+  // Only the precomputed labeler uses the fingerprint as is. The fingerprint
+  // of event 1 is used for event 0.
+  LabelerInput input = inputs[0];
+  input.mutable_event_id()->set_id_fingerprint(
+      fingerprinted_inputs[1].event_id().id_fingerprint());
+  LabelerOutput event_0_output;
+  EXPECT_THAT(labeler->Label(inputs[0], event_0_output), IsOk());
+  LabelerOutput event_1_output;
+  EXPECT_THAT(labeler->Label(inputs[1], event_1_output), IsOk());
+  ASSERT_THAT(event_1_output, Not(EqualsProto(event_0_output)));
+  LabelerOutput output;
+  EXPECT_THAT(labeler->Label(input, output), IsOk());
+  EXPECT_THAT(output, EqualsProto(event_0_output));
+  EXPECT_THAT(precomputed_labeler->Label(input, output), IsOk());
+  EXPECT_THAT(output, EqualsProto(event_1_output));
+}
+
+TEST(LabelerTest, LabelBatchSizeMismatch) {
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<Labeler> labeler,
+                       BuildSinglePoolLabeler());
+  std::vector<LabelerInput> inputs(2);
+  std::vector<LabelerOutput> outputs(1);
+  EXPECT_THAT(labeler->LabelBatch(inputs, absl::MakeSpan(outputs)),
+              StatusIs(absl::StatusCode::kInvalidArgument, ""));
+}
+
+TEST(LabelerTest, GetStatsNotEnabled) {
+  CompiledNode root;
+  ASSERT_TRUE(google::protobuf::TextFormat::ParseFromString(
+      R"pb(stop_node {})pb", &root));
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<Labeler> labeler, Labeler::Build(root));
+  EXPECT_THAT(labeler->GetStats().status(),
+              StatusIs(absl::StatusCode::kFailedPrecondition, ""));
+}
+
+TEST(LabelerTest, GetStats) {
+  // A model which fails for the events without event_id, and otherwise
+  // assigns virtual person id 10 or 20 by chance.
+  CompiledNode root;
+  ASSERT_TRUE(google::protobuf::TextFormat::ParseFromString(
+      R"pb(
+        name: "TestRoot"
+        branch_node {
+          branches {
+            node {
+              name: "TestChance"
+              branch_node {
+                branches {
+                  node {
+                    name: "TestPopulation1"
+                    population_node {
+                      pools { population_offset: 10 total_population: 1 }
+                      random_seed: "TestPopulationNodeSeed1"
+                    }
+                  }
+                  chance: 0.4
+                }
+                branches {
+                  node {
+                    name: "TestPopulation2"
+                    population_node {
+                      pools { population_offset: 20 total_population: 1 }
+                      random_seed: "TestPopulationNodeSeed2"
+                    }
+                  }
+                  chance: 0.6
+                }
+                random_seed: "TestBranchNodeSeed"
+              }
+            }
+            condition { name: "labeler_input.event_id.id" op: HAS }
+          }
+        }
+      )pb",
+      &root));
+  LabelerOptions options;
+  options.stats.enabled = true;
+  options.stats.latency_sample_period = 4;
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<Labeler> labeler,
+                       Labeler::Build(root, options));
+
+  constexpr int kEventCount = 1000;
+  int id_10_count = 0;
+  for (int event_id = 0; event_id < kEventCount; ++event_id) {
+    LabelerInput input;
+    input.mutable_event_id()->set_id(std::to_string(event_id));
+    LabelerOutput output;
+    ASSERT_THAT(labeler->Label(input, output), IsOk());
+    if (output.people(0).virtual_person_id() == 10) {
+      ++id_10_count;
+    }
+  }
+  LabelerOutput output;
+  EXPECT_THAT(labeler->Label(LabelerInput(), output), Not(IsOk()));
+
+  ASSERT_OK_AND_ASSIGN(ModelStats stats, labeler->GetStats());
+  EXPECT_EQ(stats.labeled_events, kEventCount + 1);
+  EXPECT_EQ(stats.sampled_events, (kEventCount + 1) / 4);
+  ASSERT_EQ(stats.nodes.size(), 4);
+
+  const NodeStats& root_stats = stats.nodes[0];
+  EXPECT_EQ(root_stats.name, "TestRoot");
+  EXPECT_EQ(root_stats.visits, kEventCount + 1);
+  EXPECT_EQ(root_stats.errors, 1);
+  EXPECT_THAT(root_stats.branch_selections, ElementsAre(kEventCount));
+  EXPECT_EQ(root_stats.latency.count, stats.sampled_events);
+  EXPECT_GT(root_stats.latency.total, absl::ZeroDuration());
+
+  const NodeStats& chance_stats = stats.nodes[1];
+  EXPECT_EQ(chance_stats.name, "TestChance");
+  EXPECT_EQ(chance_stats.visits, kEventCount);
+  EXPECT_EQ(chance_stats.errors, 0);
+  EXPECT_THAT(chance_stats.branch_selections,
+              ElementsAre(id_10_count, kEventCount - id_10_count));
+
+  EXPECT_EQ(stats.nodes[2].name, "TestPopulation1");
+  EXPECT_EQ(stats.nodes[2].visits, id_10_count);
+  EXPECT_EQ(stats.nodes[3].name, "TestPopulation2");
+  EXPECT_EQ(stats.nodes[3].visits, kEventCount - id_10_count);
+  EXPECT_EQ(stats.nodes[2].latency.count + stats.nodes[3].latency.count,
+            root_stats.latency.count);
 }
 
 }  // namespace
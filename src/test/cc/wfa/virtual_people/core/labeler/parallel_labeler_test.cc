@@ -0,0 +1,204 @@
+// Copyright 2026 The Cross-Media Measurement Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "wfa/virtual_people/core/labeler/parallel_labeler.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "common_cpp/testing/common_matchers.h"
+#include "common_cpp/testing/status_macros.h"
+#include "common_cpp/testing/status_matchers.h"
+#include "gmock/gmock.h"
+#include "google/protobuf/text_format.h"
+#include "gtest/gtest.h"
+#include "wfa/virtual_people/common/event.pb.h"
+#include "wfa/virtual_people/common/label.pb.h"
+#include "wfa/virtual_people/common/model.pb.h"
+#include "wfa/virtual_people/core/labeler/labeler.h"
+
+namespace wfa_virtual_people {
+namespace {
+
+using ::wfa::EqualsProto;
+using ::wfa::IsOk;
+using ::wfa::StatusIs;
+
+constexpr int kEventIdNumber = 10000;
+
+// Returns a model which assigns virtual person id 10 to 40% of the events, and
+// virtual person id 20 to 60% of the events. Labeling fails for the events
+// without event_id.
+absl::StatusOr<std::unique_ptr<Labeler>> BuildTestLabeler() {
+  CompiledNode root;
+  if (!google::protobuf::TextFormat::ParseFromString(
+          R"pb(
+            name: "TestNode1"
+            branch_node {
+              branches {
+                node {
+                  name: "TestNode2"
+                  branch_node {
+                    branches {
+                      node {
+                        population_node {
+                          pools { population_offset: 10 total_population: 1 }
+                          random_seed: "TestPopulationNodeSeed1"
+                        }
+                      }
+                      chance: 0.4
+                    }
+                    branches {
+                      node {
+                        population_node {
+                          pools { population_offset: 20 total_population: 1 }
+                          random_seed: "TestPopulationNodeSeed2"
+                        }
+                      }
+                      chance: 0.6
+                    }
+                    random_seed: "TestBranchNodeSeed"
+                  }
+                }
+                condition { name: "labeler_input.event_id.id" op: HAS }
+              }
+            }
+          )pb",
+          &root)) {
+    return absl::InternalError("failed to parse test model");
+  }
+  return Labeler::Build(root);
+}
+
+std::vector<LabelerInput> BuildInputs(int count) {
+  std::vector<LabelerInput> inputs(count);
+  for (int event_id = 0; event_id < count; ++event_id) {
+    inputs[event_id].mutable_event_id()->set_id(std::to_string(event_id));
+  }
+  return inputs;
+}
+
+TEST(ParallelLabelerTest, TestBuildNullLabeler) {
+  EXPECT_THAT(ParallelLabeler::Build(nullptr, 2).status(),
+              StatusIs(absl::StatusCode::kInvalidArgument, "null"));
+}
+
+TEST(ParallelLabelerTest, TestBuildInvalidThreadNumber) {
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<Labeler> labeler, BuildTestLabeler());
+  EXPECT_THAT(ParallelLabeler::Build(std::move(labeler), 0).status(),
+              StatusIs(absl::StatusCode::kInvalidArgument, "positive"));
+}
+
+TEST(ParallelLabelerTest, TestMatchesSerialLabeling) {
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<Labeler> labeler, BuildTestLabeler());
+  std::vector<LabelerInput> inputs = BuildInputs(kEventIdNumber);
+  std::vector<LabelerOutput> expected_outputs(inputs.size());
+  EXPECT_THAT(labeler->LabelBatch(inputs, absl::MakeSpan(expected_outputs)),
+              IsOk());
+
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<ParallelLabeler> parallel_labeler,
+                       ParallelLabeler::Build(std::move(labeler), 4));
+  EXPECT_EQ(parallel_labeler->num_threads(), 4);
+  // Label twice, to make sure the workers are reused between batches.
+  for (int round = 0; round < 2; ++round) {
+    std::vector<LabelerOutput> outputs(inputs.size());
+    EXPECT_THAT(parallel_labeler->LabelBatch(inputs, absl::MakeSpan(outputs)),
+                IsOk());
+    for (int i = 0; i < inputs.size(); ++i) {
+      EXPECT_THAT(outputs[i], EqualsProto(expected_outputs[i]));
+    }
+  }
+
+  std::vector<ParallelLabeler::WorkerStats> stats =
+      parallel_labeler->GetWorkerStats();
+  ASSERT_EQ(stats.size(), 4);
+  int64_t labeled_events = 0;
+  for (const ParallelLabeler::WorkerStats& worker_stats : stats) {
+    labeled_events += worker_stats.labeled_events;
+    EXPECT_GE(worker_stats.EventsPerSecond(), 0);
+  }
+  EXPECT_EQ(labeled_events, 2 * kEventIdNumber);
+}
+
+TEST(ParallelLabelerTest, TestPoolIdentityMode) {
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<Labeler> labeler, BuildTestLabeler());
+  std::vector<LabelerInput> inputs = BuildInputs(100);
+  std::vector<LabelerOutput> expected_outputs(inputs.size());
+  EXPECT_THAT(labeler->LabelBatch(inputs, absl::MakeSpan(expected_outputs),
+                                  LabelingMode::kPoolIdentity),
+              IsOk());
+
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<ParallelLabeler> parallel_labeler,
+                       ParallelLabeler::Build(std::move(labeler), 3));
+  std::vector<LabelerOutput> outputs(inputs.size());
+  EXPECT_THAT(parallel_labeler->LabelBatch(inputs, absl::MakeSpan(outputs),
+                                           LabelingMode::kPoolIdentity),
+              IsOk());
+  for (int i = 0; i < inputs.size(); ++i) {
+    EXPECT_THAT(outputs[i], EqualsProto(expected_outputs[i]));
+  }
+}
+
+TEST(ParallelLabelerTest, TestFewerInputsThanThreads) {
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<Labeler> labeler, BuildTestLabeler());
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<ParallelLabeler> parallel_labeler,
+                       ParallelLabeler::Build(std::move(labeler), 8));
+  std::vector<LabelerInput> inputs = BuildInputs(3);
+  std::vector<LabelerOutput> outputs(inputs.size());
+  EXPECT_THAT(parallel_labeler->LabelBatch(inputs, absl::MakeSpan(outputs)),
+              IsOk());
+  for (const LabelerOutput& output : outputs) {
+    EXPECT_EQ(output.people_size(), 1);
+  }
+
+  // Empty batch.
+  EXPECT_THAT(parallel_labeler->LabelBatch({}, {}), IsOk());
+}
+
+TEST(ParallelLabelerTest, TestReturnsFirstError) {
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<Labeler> labeler, BuildTestLabeler());
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<ParallelLabeler> parallel_labeler,
+                       ParallelLabeler::Build(std::move(labeler), 4));
+  std::vector<LabelerInput> inputs = BuildInputs(kEventIdNumber);
+  // No condition matches the events without event_id.
+  inputs[5000].clear_event_id();
+  inputs[7000].clear_event_id();
+
+  // The returned error is always the error of the first failed input.
+  for (int round = 0; round < 5; ++round) {
+    std::vector<LabelerOutput> outputs(inputs.size());
+    EXPECT_THAT(parallel_labeler->LabelBatch(inputs, absl::MakeSpan(outputs)),
+                StatusIs(absl::StatusCode::kInvalidArgument, "index 5000"));
+    // All the inputs before the failed input are labeled.
+    for (int i = 0; i < 5000; ++i) {
+      EXPECT_EQ(outputs[i].people_size(), 1);
+    }
+  }
+}
+
+TEST(ParallelLabelerTest, TestSizeMismatch) {
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<Labeler> labeler, BuildTestLabeler());
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<ParallelLabeler> parallel_labeler,
+                       ParallelLabeler::Build(std::move(labeler), 2));
+  std::vector<LabelerInput> inputs = BuildInputs(2);
+  std::vector<LabelerOutput> outputs(1);
+  EXPECT_THAT(parallel_labeler->LabelBatch(inputs, absl::MakeSpan(outputs)),
+              StatusIs(absl::StatusCode::kInvalidArgument, ""));
+}
+
+}  // namespace
+}  // namespace wfa_virtual_people
@@ -20,9 +20,11 @@
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/strings/string_view.h"
+#include "common_cpp/testing/common_matchers.h"
 #include "common_cpp/testing/status_macros.h"
 #include "common_cpp/testing/status_matchers.h"
 #include "gmock/gmock.h"
+#include "google/protobuf/arena.h"
 #include "google/protobuf/text_format.h"
 #include "gtest/gtest.h"
 #include "wfa/virtual_people/common/label.pb.h"
@@ -37,6 +39,7 @@ namespace {
 using ::testing::AnyOf;
 using ::testing::Pair;
 using ::testing::UnorderedElementsAre;
+using ::wfa::EqualsProto;
 using ::wfa::IsOk;
 using ::wfa::StatusIs;
 
@@ -1438,5 +1441,62 @@ TEST(BranchNodeImplTest, TestMultiplicityPass1FoldsBackPoolAssignments) {
   EXPECT_GT(pass1_total, kFingerprintNumber);
 }
 
+TEST(BranchNodeImplTest, TestMultiplicityOnArena) {
+  // The clones of an event allocated on an arena are allocated on the same
+  // arena. The labels must be the same as labeling an event on the heap.
+  CompiledNode config;
+  ASSERT_TRUE(google::protobuf::TextFormat::ParseFromString(
+      R"pb(
+        name: "TestBranchNode"
+        index: 1
+        branch_node {
+          branches {
+            node {
+              population_node {
+                pools { population_offset: 10 total_population: 1 }
+                random_seed: "TestPopulationNodeSeed1"
+              }
+            }
+            chance: 0.5
+          }
+          branches {
+            node {
+              population_node {
+                pools { population_offset: 20 total_population: 1 }
+                random_seed: "TestPopulationNodeSeed2"
+              }
+            }
+            chance: 0.5
+          }
+          random_seed: "TestBranchNodeSeed"
+          multiplicity {
+            expected_multiplicity: 3
+            max_value: 3
+            cap_at_max: false
+            person_index_field: "multiplicity_person_index"
+            random_seed: "test multiplicity"
+          }
+        }
+      )pb",
+      &config));
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<ModelNode> node,
+                       ModelNode::Build(config));
+
+  google::protobuf::Arena arena;
+  for (int fingerprint = 0; fingerprint < 100; ++fingerprint) {
+    LabelerEvent heap_event;
+    heap_event.set_acting_fingerprint(fingerprint);
+    EXPECT_THAT(node->Apply(heap_event), IsOk());
+
+    LabelerEvent* arena_event =
+        google::protobuf::Arena::Create<LabelerEvent>(&arena);
+    arena_event->set_acting_fingerprint(fingerprint);
+    EXPECT_THAT(node->Apply(*arena_event), IsOk());
+
+    EXPECT_EQ(arena_event->virtual_person_activities().size(), 3);
+    EXPECT_THAT(*arena_event, EqualsProto(heap_event));
+  }
+}
+
 }  // namespace
 }  // namespace wfa_virtual_people
@@ -0,0 +1,328 @@
+// Copyright 2026 The Cross-Media Measurement Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "wfa/virtual_people/core/model/flat_model.h"
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "common_cpp/testing/common_matchers.h"
+#include "common_cpp/testing/status_macros.h"
+#include "common_cpp/testing/status_matchers.h"
+#include "gmock/gmock.h"
+#include "google/protobuf/text_format.h"
+#include "gtest/gtest.h"
+#include "wfa/virtual_people/common/label.pb.h"
+#include "wfa/virtual_people/common/model.pb.h"
+#include "wfa/virtual_people/core/model/model_node.h"
+
+namespace wfa_virtual_people {
+namespace {
+
+using ::wfa::EqualsProto;
+using ::wfa::IsOk;
+using ::wfa::StatusIs;
+
+constexpr int kFingerprintNumber = 1000;
+
+// The root node selects by chance between:
+// * A node with multiplicity, which applies 2 or 3 clones to a population node.
+// * A node which updates person_country_code from COUNTRY_0, then selects by
+//   condition between a population node and a stop node.
+constexpr char kTestModel[] = R"pb(
+  name: "TestRoot"
+  branch_node {
+    branches {
+      node {
+        name: "TestMultiplicity"
+        branch_node {
+          branches {
+            node {
+              name: "TestPopulation1"
+              population_node {
+                pools { population_offset: 10 total_population: 10 }
+                random_seed: "TestPopulationNodeSeed1"
+              }
+            }
+            chance: 1
+          }
+          random_seed: "TestMultiplicitySeed"
+          multiplicity {
+            expected_multiplicity: 2.5
+            max_value: 3
+            cap_at_max: false
+            person_index_field: "multiplicity_person_index"
+            random_seed: "TestMultiplicity"
+          }
+        }
+      }
+      chance: 0.5
+    }
+    branches {
+      node {
+        name: "TestCondition"
+        branch_node {
+          branches {
+            node {
+              name: "TestPopulation2"
+              population_node {
+                pools { population_offset: 100 total_population: 10 }
+                random_seed: "TestPopulationNodeSeed2"
+              }
+            }
+            condition {
+              name: "person_country_code"
+              op: EQUAL
+              value: "COUNTRY_1"
+            }
+          }
+          branches {
+            node { name: "TestStop" stop_node {} }
+            condition { op: TRUE }
+          }
+          updates {
+            updates {
+              update_matrix {
+                columns { person_country_code: "COUNTRY_0" }
+                rows { person_country_code: "COUNTRY_1" }
+                rows { person_country_code: "COUNTRY_2" }
+                probabilities: 0.5
+                probabilities: 0.5
+              }
+            }
+          }
+        }
+      }
+      chance: 0.5
+    }
+    random_seed: "TestRootSeed"
+  }
+)pb";
+
+TEST(FlatModelTest, TestNodesInPreOrder) {
+  CompiledNode config;
+  ASSERT_TRUE(
+      google::protobuf::TextFormat::ParseFromString(kTestModel, &config));
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<ModelNode> root,
+                       ModelNode::Build(config));
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<FlatModel> model,
+                       FlatModel::Build(std::move(root)));
+
+  const auto& nodes = model->nodes();
+  ASSERT_EQ(nodes.size(), 6);
+  EXPECT_EQ(nodes[0].impl->name(), "TestRoot");
+  EXPECT_EQ(nodes[1].impl->name(), "TestMultiplicity");
+  EXPECT_EQ(nodes[2].impl->name(), "TestPopulation1");
+  EXPECT_EQ(nodes[3].impl->name(), "TestCondition");
+  EXPECT_EQ(nodes[4].impl->name(), "TestPopulation2");
+  EXPECT_EQ(nodes[5].impl->name(), "TestStop");
+  EXPECT_EQ(nodes[0].kind, FlatModel::NodeKind::kBranch);
+  EXPECT_EQ(nodes[2].kind, FlatModel::NodeKind::kPopulation);
+  EXPECT_EQ(nodes[5].kind, FlatModel::NodeKind::kStop);
+
+  EXPECT_EQ(model->child_index(0, 0), 1);
+  EXPECT_EQ(model->child_index(0, 1), 3);
+  EXPECT_EQ(model->child_index(1, 0), 2);
+  EXPECT_EQ(model->child_index(3, 0), 4);
+  EXPECT_EQ(model->child_index(3, 1), 5);
+}
+
+TEST(FlatModelTest, TestApplyMatchesModelNode) {
+  CompiledNode config;
+  ASSERT_TRUE(
+      google::protobuf::TextFormat::ParseFromString(kTestModel, &config));
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<ModelNode> tree,
+                       ModelNode::Build(config));
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<ModelNode> root,
+                       ModelNode::Build(config));
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<FlatModel> model,
+                       FlatModel::Build(std::move(root)));
+
+  int labeled_events = 0;
+  for (int fingerprint = 0; fingerprint < kFingerprintNumber; ++fingerprint) {
+    LabelerEvent expected_event;
+    expected_event.set_acting_fingerprint(fingerprint);
+    expected_event.set_person_country_code("COUNTRY_0");
+    EXPECT_THAT(tree->Apply(expected_event), IsOk());
+
+    LabelerEvent event;
+    event.set_acting_fingerprint(fingerprint);
+    event.set_person_country_code("COUNTRY_0");
+    EXPECT_THAT(model->Apply(event), IsOk());
+    EXPECT_THAT(event, EqualsProto(expected_event));
+    if (event.virtual_person_activities_size() > 0) {
+      ++labeled_events;
+    }
+  }
+  // Both the population nodes and the stop node are reached.
+  EXPECT_GT(labeled_events, 0);
+  EXPECT_LT(labeled_events, kFingerprintNumber);
+}
+
+TEST(FlatModelTest, TestSingleLeafNode) {
+  CompiledNode config;
+  ASSERT_TRUE(google::protobuf::TextFormat::ParseFromString(
+      R"pb(
+        population_node {
+          pools { population_offset: 10 total_population: 1 }
+          random_seed: "TestPopulationNodeSeed"
+        }
+      )pb",
+      &config));
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<ModelNode> root,
+                       ModelNode::Build(config));
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<FlatModel> model,
+                       FlatModel::Build(std::move(root)));
+  ASSERT_EQ(model->nodes().size(), 1);
+
+  LabelerEvent event;
+  EXPECT_THAT(model->Apply(event), IsOk());
+  ASSERT_EQ(event.virtual_person_activities_size(), 1);
+  EXPECT_EQ(event.virtual_person_activities(0).virtual_person_id(), 10);
+}
+
+TEST(FlatModelTest, TestApplyError) {
+  CompiledNode config;
+  ASSERT_TRUE(google::protobuf::TextFormat::ParseFromString(
+      R"pb(
+        branch_node {
+          branches {
+            node { stop_node {} }
+            condition { name: "acting_fingerprint" op: EQUAL value: "1" }
+          }
+        }
+      )pb",
+      &config));
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<ModelNode> root,
+                       ModelNode::Build(config));
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<FlatModel> model,
+                       FlatModel::Build(std::move(root)));
+
+  LabelerEvent event;
+  event.set_acting_fingerprint(2);
+  EXPECT_THAT(model->Apply(event),
+              StatusIs(absl::StatusCode::kInvalidArgument, ""));
+}
+
+// Returns the virtual person id of @event, or -1 if there is none.
+int64_t GetVirtualPersonId(const LabelerEvent& event) {
+  if (event.virtual_person_activities_size() != 1) {
+    return -1;
+  }
+  return event.virtual_person_activities(0).virtual_person_id();
+}
+
+TEST(FlatModelTest, TestCachedConditionsSeeUpdates) {
+  // The condition on person_country_code is used by all the branch nodes and
+  // the conditional assignment, which updates person_country_code.
+  CompiledNode config;
+  ASSERT_TRUE(google::protobuf::TextFormat::ParseFromString(
+      R"pb(
+        branch_node {
+          branches {
+            node {
+              branch_node {
+                branches {
+                  node {
+                    population_node {
+                      pools { population_offset: 10 total_population: 1 }
+                      random_seed: "TestPopulationNodeSeed1"
+                    }
+                  }
+                  condition {
+                    name: "person_country_code"
+                    op: EQUAL
+                    value: "COUNTRY_1"
+                  }
+                }
+                branches {
+                  node {
+                    population_node {
+                      pools { population_offset: 20 total_population: 1 }
+                      random_seed: "TestPopulationNodeSeed2"
+                    }
+                  }
+                  condition { op: TRUE }
+                }
+                updates {
+                  updates {
+                    conditional_assignment {
+                      condition {
+                        name: "person_country_code"
+                        op: EQUAL
+                        value: "COUNTRY_1"
+                      }
+                      assignments {
+                        source_field: "person_region_code"
+                        target_field: "person_country_code"
+                      }
+                    }
+                  }
+                }
+              }
+            }
+            condition {
+              name: "person_country_code"
+              op: EQUAL
+              value: "COUNTRY_1"
+            }
+          }
+          branches {
+            node {
+              population_node {
+                pools { population_offset: 30 total_population: 1 }
+                random_seed: "TestPopulationNodeSeed3"
+              }
+            }
+            condition { op: TRUE }
+          }
+        }
+      )pb",
+      &config));
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<ModelNode> root,
+                       ModelNode::Build(config));
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<FlatModel> model,
+                       FlatModel::Build(std::move(root)));
+  // The condition on person_country_code and the TRUE condition.
+  EXPECT_EQ(model->predicate_registry().size(), 2);
+
+  // person_country_code is updated to REGION_1, so the second branch is
+  // selected after the update.
+  LabelerEvent event_1;
+  event_1.set_person_country_code("COUNTRY_1");
+  event_1.set_person_region_code("REGION_1");
+  EXPECT_THAT(model->Apply(event_1), IsOk());
+  EXPECT_EQ(GetVirtualPersonId(event_1), 20);
+
+  // person_country_code is updated to COUNTRY_1.
+  LabelerEvent event_2;
+  event_2.set_person_country_code("COUNTRY_1");
+  event_2.set_person_region_code("COUNTRY_1");
+  EXPECT_THAT(model->Apply(event_2), IsOk());
+  EXPECT_EQ(GetVirtualPersonId(event_2), 10);
+
+  LabelerEvent event_3;
+  event_3.set_person_country_code("COUNTRY_2");
+  EXPECT_THAT(model->Apply(event_3), IsOk());
+  EXPECT_EQ(GetVirtualPersonId(event_3), 30);
+}
+
+TEST(FlatModelTest, TestBuildNullRoot) {
+  EXPECT_THAT(FlatModel::Build(nullptr).status(),
+              StatusIs(absl::StatusCode::kInvalidArgument, ""));
+}
+
+}  // namespace
+}  // namespace wfa_virtual_people
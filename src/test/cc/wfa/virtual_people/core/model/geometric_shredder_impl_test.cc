@@ -12,8 +12,14 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
 #include "common_cpp/testing/common_matchers.h"
 #include "common_cpp/testing/status_macros.h"
 #include "common_cpp/testing/status_matchers.h"
@@ -22,7 +28,9 @@
 #include "gtest/gtest.h"
 #include "wfa/virtual_people/common/demographic.pb.h"
 #include "wfa/virtual_people/common/model.pb.h"
+#include "src/farmhash.h"
 #include "wfa/virtual_people/core/model/attributes_updater.h"
+#include "wfa/virtual_people/core/model/geometric_shredder_impl.h"
 
 namespace wfa_virtual_people {
 namespace {
@@ -320,5 +328,105 @@ TEST(GeometricShredderImplTest, TestShredWithProbability) {
   }
 }
 
+TEST(GeometricShredderImplTest, TestShredValueOfLargeValues) {
+  GeometricShredder config;
+  ASSERT_TRUE(google::protobuf::TextFormat::ParseFromString(
+      R"pb(
+        psi: 1
+        randomness_field: "labeler_input.event_id.id_fingerprint"
+        target_field: "acting_fingerprint"
+        random_seed: "seed"
+      )pb",
+      &config));
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<GeometricShredderImpl> shredder,
+                       GeometricShredderImpl::Build(config));
+
+  // With psi 1, the shred hash is the randomness value. Values above the max
+  // int64_t are formatted as unsigned.
+  uint64_t max_value = std::numeric_limits<uint64_t>::max();
+  LabelerEvent event;
+  event.mutable_labeler_input()->mutable_event_id()->set_id_fingerprint(
+      max_value - 1);
+  event.set_acting_fingerprint(max_value);
+  EXPECT_THAT(shredder->Update(event), IsOk());
+  EXPECT_EQ(event.acting_fingerprint(),
+            util::Fingerprint64(absl::StrFormat("%d-shred-%d-%s", max_value,
+                                                max_value - 1, "seed")));
+}
+
+TEST(GeometricShredderImplTest, TestUpdateBatch) {
+  GeometricShredder config;
+  ASSERT_TRUE(google::protobuf::TextFormat::ParseFromString(
+      R"pb(
+        psi: 0.65
+        randomness_field: "labeler_input.event_id.id_fingerprint"
+        target_field: "acting_fingerprint"
+        random_seed: "seed"
+      )pb",
+      &config));
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<GeometricShredderImpl> shredder,
+                       GeometricShredderImpl::Build(config));
+
+  // Multiple blocks, with the last one partially filled.
+  constexpr int kEventCount = 1000;
+  std::vector<LabelerEvent> events(kEventCount);
+  std::vector<LabelerEvent*> event_ptrs;
+  for (int i = 0; i < kEventCount; ++i) {
+    events[i].mutable_labeler_input()->mutable_event_id()->set_id_fingerprint(
+        i + 1);
+    events[i].set_acting_fingerprint(i % kTargetKeyNumber);
+    event_ptrs.push_back(&events[i]);
+  }
+  std::vector<LabelerEvent> expected_events = events;
+  for (LabelerEvent& event : expected_events) {
+    EXPECT_THAT(shredder->Update(event), IsOk());
+  }
+
+  EXPECT_THAT(shredder->UpdateBatch(event_ptrs), IsOk());
+  for (int i = 0; i < kEventCount; ++i) {
+    EXPECT_THAT(events[i], EqualsProto(expected_events[i]));
+  }
+}
+
+TEST(GeometricShredderImplTest, TestUpdateBatchRandomnessFieldNotSet) {
+  GeometricShredder config;
+  ASSERT_TRUE(google::protobuf::TextFormat::ParseFromString(
+      R"pb(
+        psi: 0.65
+        randomness_field: "labeler_input.event_id.id_fingerprint"
+        target_field: "acting_fingerprint"
+        random_seed: "seed"
+      )pb",
+      &config));
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<GeometricShredderImpl> shredder,
+                       GeometricShredderImpl::Build(config));
+
+  constexpr int kEventCount = 100;
+  constexpr int kInvalidEventIndex = 70;
+  std::vector<LabelerEvent> events(kEventCount);
+  std::vector<LabelerEvent*> event_ptrs;
+  for (int i = 0; i < kEventCount; ++i) {
+    if (i != kInvalidEventIndex) {
+      events[i]
+          .mutable_labeler_input()
+          ->mutable_event_id()
+          ->set_id_fingerprint(i + 1);
+    }
+    events[i].set_acting_fingerprint(i);
+    event_ptrs.push_back(&events[i]);
+  }
+  std::vector<LabelerEvent> expected_events = events;
+  for (int i = 0; i < kInvalidEventIndex; ++i) {
+    EXPECT_THAT(shredder->Update(expected_events[i]), IsOk());
+  }
+
+  // The events before the invalid one are updated, and the others are not.
+  EXPECT_THAT(shredder->UpdateBatch(event_ptrs),
+              StatusIs(absl::StatusCode::kInvalidArgument, ""));
+  for (int i = 0; i < kEventCount; ++i) {
+    EXPECT_THAT(events[i], EqualsProto(expected_events[i]));
+  }
+}
+
 }  // namespace
 }  // namespace wfa_virtual_people
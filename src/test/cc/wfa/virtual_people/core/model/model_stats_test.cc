@@ -0,0 +1,115 @@
+// Copyright 2026 The Cross-Media Measurement Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "wfa/virtual_people/core/model/model_stats.h"
+
+#include <thread>
+#include <vector>
+
+#include "absl/time/time.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace wfa_virtual_people {
+namespace {
+
+using ::testing::ElementsAre;
+
+TEST(LatencyHistogramTest, TestGetBucket) {
+  EXPECT_EQ(LatencyHistogram::GetBucket(0), 0);
+  EXPECT_EQ(LatencyHistogram::GetBucket(127), 0);
+  EXPECT_EQ(LatencyHistogram::GetBucket(128), 1);
+  EXPECT_EQ(LatencyHistogram::GetBucket(255), 1);
+  EXPECT_EQ(LatencyHistogram::GetBucket(256), 2);
+  EXPECT_EQ(LatencyHistogram::GetBucket(int64_t{1} << 40),
+            LatencyHistogram::kBucketCount - 1);
+
+  EXPECT_EQ(LatencyHistogram::GetBucketUpperBound(0), absl::Nanoseconds(128));
+  EXPECT_EQ(LatencyHistogram::GetBucketUpperBound(2), absl::Nanoseconds(512));
+  EXPECT_EQ(LatencyHistogram::GetBucketUpperBound(
+                LatencyHistogram::kBucketCount - 1),
+            absl::InfiniteDuration());
+}
+
+TEST(LatencyHistogramTest, TestMeanAndQuantile) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(histogram.Mean(), absl::ZeroDuration());
+  EXPECT_EQ(histogram.Quantile(0.5), absl::ZeroDuration());
+
+  histogram.buckets[0] = 90;
+  histogram.buckets[3] = 10;
+  histogram.count = 100;
+  histogram.total = absl::Microseconds(20);
+  EXPECT_EQ(histogram.Mean(), absl::Nanoseconds(200));
+  EXPECT_EQ(histogram.Quantile(0.5), absl::Nanoseconds(128));
+  EXPECT_EQ(histogram.Quantile(0.9), absl::Nanoseconds(128));
+  EXPECT_EQ(histogram.Quantile(0.99), absl::Nanoseconds(1024));
+}
+
+TEST(ModelStatsCollectorTest, TestMergesThreads) {
+  ModelStatsOptions options;
+  options.enabled = true;
+  options.latency_sample_period = 2;
+  // Node 0 is a branch node with 2 branches, nodes 1 and 2 are leaves.
+  ModelStatsCollector collector(options, {"Root", "Leaf1", "Leaf2"},
+                                {2, 0, 0});
+
+  constexpr int kThreadCount = 4;
+  constexpr int kEventCount = 100;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreadCount; ++t) {
+    threads.emplace_back([&collector] {
+      ModelStatsCollector::Shard& shard = collector.GetShard();
+      for (int i = 0; i < kEventCount; ++i) {
+        bool sampled = collector.StartEvent(shard);
+        collector.RecordVisit(shard, 0, sampled);
+        collector.RecordBranch(shard, i % 2);
+        collector.RecordVisit(shard, 1 + i % 2, sampled);
+        if (i % 10 == 0) {
+          collector.RecordError(shard, 1 + i % 2);
+        }
+        if (sampled) {
+          collector.EndPath(shard, 0);
+        }
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  ModelStats stats = collector.GetStats();
+  EXPECT_EQ(stats.labeled_events, kThreadCount * kEventCount);
+  EXPECT_EQ(stats.sampled_events, kThreadCount * kEventCount / 2);
+  ASSERT_EQ(stats.nodes.size(), 3);
+
+  EXPECT_EQ(stats.nodes[0].name, "Root");
+  EXPECT_EQ(stats.nodes[0].visits, kThreadCount * kEventCount);
+  EXPECT_EQ(stats.nodes[0].errors, 0);
+  EXPECT_THAT(stats.nodes[0].branch_selections,
+              ElementsAre(kThreadCount * kEventCount / 2,
+                          kThreadCount * kEventCount / 2));
+  EXPECT_EQ(stats.nodes[0].latency.count, kThreadCount * kEventCount / 2);
+
+  EXPECT_EQ(stats.nodes[1].name, "Leaf1");
+  EXPECT_EQ(stats.nodes[1].visits, kThreadCount * kEventCount / 2);
+  EXPECT_EQ(stats.nodes[1].errors, kThreadCount * kEventCount / 10);
+  EXPECT_TRUE(stats.nodes[1].branch_selections.empty());
+  // Every second event is sampled, which all go to Leaf2.
+  EXPECT_EQ(stats.nodes[1].latency.count, 0);
+  EXPECT_EQ(stats.nodes[2].latency.count, kThreadCount * kEventCount / 2);
+}
+
+}  // namespace
+}  // namespace wfa_virtual_people
@@ -22,6 +22,7 @@
 #include "google/protobuf/text_format.h"
 #include "gtest/gtest.h"
 #include "wfa/virtual_people/common/model.pb.h"
+#include "wfa/virtual_people/core/model/utils/field_accessor.h"
 
 namespace wfa_virtual_people {
 namespace {
@@ -128,6 +129,22 @@ TEST(MultiplicityImplTest, TestInvalidPersonIndexFieldType) {
                        "type for person_index_field"));
 }
 
+TEST(MultiplicityImplTest, TestRepeatedPersonIndexField) {
+  // person_index_field should not be in a repeated field.
+  Multiplicity config;
+  ASSERT_TRUE(google::protobuf::TextFormat::ParseFromString(
+      R"pb(
+        expected_multiplicity_field: "expected_multiplicity"
+        max_value: 1.2
+        cap_at_max: true
+        person_index_field: "virtual_person_activities.virtual_person_id"
+        random_seed: "test multiplicity"
+      )pb",
+      &config));
+  EXPECT_THAT(MultiplicityImpl::Build(config).status(),
+              StatusIs(absl::StatusCode::kInvalidArgument, ""));
+}
+
 TEST(MultiplicityImplTest, TestMaxValueNotSet) {
   Multiplicity config;
   ASSERT_TRUE(google::protobuf::TextFormat::ParseFromString(
@@ -175,7 +192,8 @@ TEST(MultiplicityImplTest, TestRandomSeedNotSet) {
 
 TEST(MultiplicityImplTest, TestInvalidExtractor) {
   MultiplicityExtractor extractor;
-  std::vector<const google::protobuf::FieldDescriptor*> person_index_field;
+  ASSERT_OK_AND_ASSIGN(FieldAccessor person_index_field,
+                       FieldAccessor::Build("multiplicity_person_index"));
   std::string random_seed = "test seed";
   std::unique_ptr<MultiplicityImpl> multiplicity =
       absl::make_unique<MultiplicityImpl>(
@@ -191,7 +209,8 @@ TEST(MultiplicityImplTest, TestInvalidExtractor) {
 TEST(MultiplicityImplTest, TestExtractorNullFunction) {
   MultiplicityFromField from_field;
   MultiplicityExtractor extractor = std::move(from_field);
-  std::vector<const google::protobuf::FieldDescriptor*> person_index_field;
+  ASSERT_OK_AND_ASSIGN(FieldAccessor person_index_field,
+                       FieldAccessor::Build("multiplicity_person_index"));
   std::string random_seed = "test seed";
   std::unique_ptr<MultiplicityImpl> multiplicity =
       absl::make_unique<MultiplicityImpl>(
@@ -212,7 +231,8 @@ TEST(MultiplicityImplTest, TestExtractorEmptyField) {
         return 1;
       };
   MultiplicityExtractor extractor = std::move(from_field);
-  std::vector<const google::protobuf::FieldDescriptor*> person_index_field;
+  ASSERT_OK_AND_ASSIGN(FieldAccessor person_index_field,
+                       FieldAccessor::Build("multiplicity_person_index"));
   std::string random_seed = "test seed";
   std::unique_ptr<MultiplicityImpl> multiplicity =
       absl::make_unique<MultiplicityImpl>(
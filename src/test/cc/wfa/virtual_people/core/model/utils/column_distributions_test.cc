@@ -0,0 +1,135 @@
+// Copyright 2026 The Cross-Media Measurement Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "wfa/virtual_people/core/model/utils/column_distributions.h"
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "common_cpp/testing/status_macros.h"
+#include "common_cpp/testing/status_matchers.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "wfa/virtual_people/core/model/utils/distributed_consistent_hashing.h"
+
+namespace wfa_virtual_people {
+namespace {
+
+using ::wfa::StatusIs;
+
+constexpr int kSeedNumber = 10000;
+
+TEST(ColumnDistributionsTest, TestInvalidColumnOffsets) {
+  EXPECT_THAT(ColumnDistributions::Build({ColumnChoice({0, 0, 1.0})}, {})
+                  .status(),
+              StatusIs(absl::StatusCode::kInvalidArgument, ""));
+  EXPECT_THAT(ColumnDistributions::Build({ColumnChoice({0, 0, 1.0})}, {0, 2})
+                  .status(),
+              StatusIs(absl::StatusCode::kInvalidArgument, ""));
+  EXPECT_THAT(ColumnDistributions::Build(
+                  {ColumnChoice({0, 0, 1.0}), ColumnChoice({0, 0, 1.0})},
+                  {0, 2, 1, 2})
+                  .status(),
+              StatusIs(absl::StatusCode::kInvalidArgument, ""));
+}
+
+TEST(ColumnDistributionsTest, TestInvalidDistribution) {
+  // Empty column.
+  EXPECT_THAT(
+      ColumnDistributions::Build({ColumnChoice({0, 0, 1.0})}, {0, 0, 1})
+          .status(),
+      StatusIs(absl::StatusCode::kInvalidArgument, ""));
+  // Negative probability.
+  EXPECT_THAT(ColumnDistributions::Build(
+                  {ColumnChoice({0, 0, -1.0}), ColumnChoice({1, 1, 2.0})},
+                  {0, 2})
+                  .status(),
+              StatusIs(absl::StatusCode::kInvalidArgument, ""));
+  // Probabilities do not sum to 1.
+  EXPECT_THAT(ColumnDistributions::Build(
+                  {ColumnChoice({0, 0, 0.5}), ColumnChoice({1, 1, 0.0})},
+                  {0, 2})
+                  .status(),
+              StatusIs(absl::StatusCode::kInvalidArgument, ""));
+}
+
+TEST(ColumnDistributionsTest, TestSameAsDistributedConsistentHashing) {
+  // Each column has choices 0 to 4, some of which have zero probability.
+  std::vector<std::vector<double>> columns = {{0.4, 0.2, 0.2, 0.2, 0.0},
+                                              {0.0, 0.0, 1.0, 0.0, 0.0},
+                                              {0.0, 0.5, 0.0, 0.25, 0.25}};
+  std::vector<ColumnChoice> choices;
+  std::vector<uint32_t> column_offsets;
+  std::vector<std::unique_ptr<DistributedConsistentHashing>> hashings;
+  for (int column = 0; column < columns.size(); ++column) {
+    column_offsets.push_back(choices.size());
+    std::vector<DistributionChoice> distribution;
+    for (int choice = 0; choice < columns[column].size(); ++choice) {
+      // Each row id is distinct from the choice id.
+      double probability = columns[column][choice];
+      choices.push_back(
+          ColumnChoice({choice, column * 100 + choice, probability}));
+      distribution.push_back(DistributionChoice({choice, probability}));
+    }
+    ASSERT_OK_AND_ASSIGN(
+        hashings.emplace_back(),
+        DistributedConsistentHashing::Build(std::move(distribution)));
+  }
+  column_offsets.push_back(choices.size());
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<ColumnDistributions> distributions,
+                       ColumnDistributions::Build(std::move(choices),
+                                                  std::move(column_offsets)));
+  ASSERT_EQ(distributions->column_count(), columns.size());
+
+  for (int column = 0; column < columns.size(); ++column) {
+    for (uint64_t fingerprint = 0; fingerprint < kSeedNumber; ++fingerprint) {
+      const ColumnChoice& choice =
+          distributions->Hash(column, "seed-", fingerprint);
+      int32_t expected = hashings[column]->Hash("seed-", fingerprint);
+      EXPECT_EQ(choice.choice_id, expected);
+      EXPECT_EQ(choice.row_id, column * 100 + expected);
+    }
+  }
+}
+
+TEST(ColumnDistributionsTest, TestZeroProbabilitiesNotKept) {
+  std::vector<ColumnChoice> choices;
+  for (int i = 0; i < 100; ++i) {
+    choices.push_back(ColumnChoice({i, i, i == 50 ? 1.0 : 0.0}));
+  }
+  ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<ColumnDistributions> sparse,
+      ColumnDistributions::Build(std::move(choices), {0, 100}));
+
+  std::vector<ColumnChoice> dense_choices;
+  for (int i = 0; i < 100; ++i) {
+    dense_choices.push_back(ColumnChoice({i, i, 0.01}));
+  }
+  ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<ColumnDistributions> dense,
+      ColumnDistributions::Build(std::move(dense_choices), {0, 100}));
+
+  // Only the first choice and the choice with positive probability are kept.
+  EXPECT_EQ(dense->MemoryUsage() - sparse->MemoryUsage(),
+            98 * sizeof(ColumnChoice));
+  for (uint64_t fingerprint = 0; fingerprint < 100; ++fingerprint) {
+    EXPECT_EQ(sparse->Hash(0, "", fingerprint).row_id, 50);
+  }
+}
+
+}  // namespace
+}  // namespace wfa_virtual_people
@@ -19,6 +19,7 @@
 #include <vector>
 
 #include "absl/random/random.h"
+#include "absl/types/span.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
@@ -95,5 +96,53 @@ TEST(JumpConsistentHashTest, TestIntMaxBuckets) {
   EXPECT_THAT(outputs, Each(Ge(0)));
 }
 
+TEST(JumpConsistentHashTest, Test64MatchesInt32) {
+  for (int i = 0; i < kKeyNumber; i++) {
+    uint64_t key = RandomKey();
+    for (int32_t num_buckets :
+         {0, 1, 2, 1000, kMaxBuckets, std::numeric_limits<int32_t>::max()}) {
+      EXPECT_EQ(JumpConsistentHash64(key, num_buckets),
+                JumpConsistentHash(key, num_buckets))
+          << "with key " << key << " and num_buckets " << num_buckets;
+    }
+  }
+}
+
+TEST(JumpConsistentHashTest, Test64LargeBuckets) {
+  // For n > 1 buckets, the output either stays the same as with n - 1 buckets,
+  // or is n - 1.
+  for (int64_t num_buckets :
+       {int64_t{1} << 31, (int64_t{1} << 40) + 7, int64_t{1} << 62,
+        std::numeric_limits<int64_t>::max()}) {
+    for (int i = 0; i < kKeyNumber; i++) {
+      uint64_t key = RandomKey();
+      int64_t output = JumpConsistentHash64(key, num_buckets);
+      EXPECT_GE(output, 0);
+      EXPECT_LT(output, num_buckets);
+      int64_t previous_output = JumpConsistentHash64(key, num_buckets - 1);
+      EXPECT_TRUE(output == previous_output || output == num_buckets - 1)
+          << "with key " << key << " and num_buckets " << num_buckets;
+    }
+  }
+}
+
+TEST(JumpConsistentHashTest, TestBatch) {
+  // Not a multiple of the number of lanes, so the remaining keys are covered.
+  std::vector<uint64_t> keys;
+  for (int i = 0; i < kKeyNumber + 3; i++) {
+    keys.push_back(RandomKey());
+  }
+  for (int64_t num_buckets :
+       {int64_t{0}, int64_t{1}, int64_t{1000}, int64_t{kMaxBuckets},
+        int64_t{1} << 40, std::numeric_limits<int64_t>::max()}) {
+    std::vector<int64_t> outputs(keys.size());
+    JumpConsistentHashBatch(keys, num_buckets, absl::MakeSpan(outputs));
+    for (size_t i = 0; i < keys.size(); ++i) {
+      EXPECT_EQ(outputs[i], JumpConsistentHash64(keys[i], num_buckets))
+          << "with key " << keys[i] << " and num_buckets " << num_buckets;
+    }
+  }
+}
+
 }  // namespace
 }  // namespace wfa_virtual_people
@@ -14,18 +14,25 @@
 
 #include "wfa/virtual_people/core/model/utils/distributed_consistent_hashing.h"
 
+#include <cstdint>
 #include <limits>
 #include <memory>
+#include <string>
 #include <utility>
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/memory/memory.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "common_cpp/testing/status_macros.h"
 #include "common_cpp/testing/status_matchers.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "wfa/virtual_people/core/model/utils/hash.h"
 
 namespace wfa_virtual_people {
 namespace {
@@ -33,6 +40,7 @@ namespace {
 using ::testing::DoubleNear;
 using ::testing::Pair;
 using ::testing::UnorderedElementsAre;
+using ::wfa::IsOk;
 using ::wfa::StatusIs;
 
 constexpr int kSeedNumber = 10000;
@@ -173,5 +181,113 @@ TEST(DistributedConsistentHashingTest, TestOutputChangeCount) {
   EXPECT_LE(diff_output_count, kSeedNumber * 0.4);
 }
 
+// The original implementation, which builds the full seed of each choice with
+// StrFormat.
+int32_t ReferenceHash(const std::vector<DistributionChoice>& distribution,
+                      absl::string_view random_seed) {
+  int32_t choice_id = 0;
+  double choice_xi = std::numeric_limits<double>::max();
+  for (const DistributionChoice& choice : distribution) {
+    double xi = ExpHash(absl::StrFormat("consistent-hashing-%s-%d",
+                                        random_seed, choice.choice_id)) /
+                choice.probability;
+    if (choice_xi > xi) {
+      choice_id = choice.choice_id;
+      choice_xi = xi;
+    }
+  }
+  return choice_id;
+}
+
+TEST(DistributedConsistentHashingTest, TestMatchesReference) {
+  std::vector<DistributionChoice> distribution(
+      {DistributionChoice({-7, 0.1}), DistributionChoice({0, 0.2}),
+       DistributionChoice({12345, 0.3}),
+       DistributionChoice({std::numeric_limits<int32_t>::min(), 0.15}),
+       DistributionChoice({std::numeric_limits<int32_t>::max(), 0.25})});
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<DistributedConsistentHashing> hashing,
+                       DistributedConsistentHashing::Build(
+                           std::vector<DistributionChoice>(distribution)));
+
+  for (int seed = 0; seed < kSeedNumber; ++seed) {
+    std::string random_seed = std::to_string(seed);
+    EXPECT_EQ(hashing->Hash(random_seed),
+              ReferenceHash(distribution, random_seed));
+  }
+  // Seeds longer than the inline buffer.
+  for (int seed = 0; seed < 100; ++seed) {
+    std::string random_seed = absl::StrCat(
+        std::string(DistributedConsistentHashing::kInlineSeedSize, 'a'), seed);
+    EXPECT_EQ(hashing->Hash(random_seed),
+              ReferenceHash(distribution, random_seed));
+  }
+  EXPECT_EQ(hashing->Hash(""), ReferenceHash(distribution, ""));
+}
+
+TEST(DistributedConsistentHashingTest, TestHashWithActingFingerprint) {
+  std::vector<DistributionChoice> distribution(
+      {DistributionChoice({0, 0.1}), DistributionChoice({1, 0.2}),
+       DistributionChoice({2, 0.3}), DistributionChoice({-3, 0.4})});
+  ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<DistributedConsistentHashing> hashing,
+      DistributedConsistentHashing::Build(std::move(distribution)));
+
+  for (int i = 0; i < kSeedNumber; ++i) {
+    uint64_t acting_fingerprint = static_cast<uint64_t>(i) * 0x9E3779B97F4A7C15;
+    EXPECT_EQ(hashing->Hash("seed-", acting_fingerprint),
+              hashing->Hash(absl::StrCat("seed-", acting_fingerprint)));
+  }
+  std::string long_seed(DistributedConsistentHashing::kInlineSeedSize, 'a');
+  EXPECT_EQ(hashing->Hash(long_seed, std::numeric_limits<uint64_t>::max()),
+            hashing->Hash(absl::StrCat(
+                long_seed, std::numeric_limits<uint64_t>::max())));
+}
+
+TEST(DistributedConsistentHashingTest, TestHashBatch) {
+  std::vector<DistributionChoice> distribution(
+      {DistributionChoice({0, 0.1}), DistributionChoice({1, 0.2}),
+       DistributionChoice({2, 0.3}), DistributionChoice({-3, 0.4})});
+  ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<DistributedConsistentHashing> hashing,
+      DistributedConsistentHashing::Build(std::move(distribution)));
+
+  // Not a multiple of the block size, so the last block is partial.
+  std::vector<uint64_t> acting_fingerprints;
+  for (int i = 0; i < kSeedNumber + 7; ++i) {
+    acting_fingerprints.push_back(static_cast<uint64_t>(i) *
+                                  0x9E3779B97F4A7C15);
+  }
+  acting_fingerprints.push_back(std::numeric_limits<uint64_t>::max());
+  std::vector<int32_t> output(acting_fingerprints.size());
+  EXPECT_THAT(hashing->HashBatch(acting_fingerprints, "seed-",
+                                 absl::MakeSpan(output)),
+              IsOk());
+
+  for (size_t i = 0; i < acting_fingerprints.size(); ++i) {
+    EXPECT_EQ(output[i],
+              hashing->Hash(absl::StrCat("seed-", acting_fingerprints[i])));
+  }
+}
+
+TEST(DistributedConsistentHashingTest, TestHashBatchEmpty) {
+  std::vector<DistributionChoice> distribution({DistributionChoice({0, 1})});
+  ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<DistributedConsistentHashing> hashing,
+      DistributedConsistentHashing::Build(std::move(distribution)));
+  EXPECT_THAT(hashing->HashBatch({}, "seed-", {}), IsOk());
+}
+
+TEST(DistributedConsistentHashingTest, TestHashBatchSizeMismatch) {
+  std::vector<DistributionChoice> distribution({DistributionChoice({0, 1})});
+  ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<DistributedConsistentHashing> hashing,
+      DistributedConsistentHashing::Build(std::move(distribution)));
+  std::vector<uint64_t> acting_fingerprints = {1, 2, 3};
+  std::vector<int32_t> output(2);
+  EXPECT_THAT(hashing->HashBatch(acting_fingerprints, "seed-",
+                                 absl::MakeSpan(output)),
+              StatusIs(absl::StatusCode::kInvalidArgument, ""));
+}
+
 }  // namespace
 }  // namespace wfa_virtual_people
@@ -15,9 +15,12 @@
 #include "wfa/virtual_people/core/model/utils/feistel.h"
 
 #include <cstdint>
+#include <limits>
 #include <string>
 #include <unordered_set>
+#include <vector>
 
+#include "absl/types/span.h"
 #include "gtest/gtest.h"
 
 namespace wfa_virtual_people {
@@ -114,5 +117,81 @@ TEST(FeistelPermuteTest, GoldenVectorsCrossLanguageParity) {
   EXPECT_EQ(FeistelPermute(999, 1000, "medium-seed"), 344);
 }
 
+TEST(FeistelPermutationTest, MatchesFeistelPermute) {
+  for (uint64_t domain_size : {0, 1, 2, 100, 997, 1234}) {
+    FeistelPermutation permutation(domain_size, "permutation-seed");
+    EXPECT_EQ(permutation.domain_size(), domain_size);
+    for (uint64_t i = 0; i < domain_size; ++i) {
+      EXPECT_EQ(permutation.Permute(i),
+                FeistelPermute(i, domain_size, "permutation-seed"));
+    }
+  }
+}
+
+TEST(FeistelPermutationTest, GoldenVectors) {
+  FeistelPermutation permutation(100, "bijectivity-seed");
+  EXPECT_EQ(permutation.Permute(0), 39);
+  EXPECT_EQ(permutation.Permute(1), 33);
+  EXPECT_EQ(permutation.Permute(99), 27);
+}
+
+TEST(FeistelPermutationTest, PermuteBatch) {
+  const uint64_t domain_size = 1000;
+  FeistelPermutation permutation(domain_size, "batch-seed");
+  std::vector<uint64_t> values;
+  for (uint64_t i = 0; i < domain_size; ++i) {
+    values.push_back(i);
+  }
+  std::vector<uint64_t> output(domain_size);
+  permutation.PermuteBatch(values, absl::MakeSpan(output));
+  for (uint64_t i = 0; i < domain_size; ++i) {
+    EXPECT_EQ(output[i], permutation.Permute(i));
+  }
+}
+
+TEST(FeistelPermutationTest, Inverse) {
+  for (uint64_t domain_size : {0, 1, 2, 3, 100, 997, 1000, 1234}) {
+    FeistelPermutation permutation(domain_size, "inverse-seed");
+    for (uint64_t i = 0; i < domain_size; ++i) {
+      uint64_t permuted = permutation.Permute(i);
+      EXPECT_EQ(permutation.Inverse(permuted), i);
+      EXPECT_EQ(permutation.Permute(permutation.Inverse(i)), i);
+    }
+  }
+  EXPECT_EQ(FeistelPermutation(0, "inverse-seed").Inverse(0), 0);
+}
+
+TEST(FeistelPermutationTest, InverseLargeDomain) {
+  // The size of the largest ranked pools.
+  const uint64_t domain_size = 1500000000;
+  FeistelPermutation permutation(domain_size, "large-seed");
+  for (uint64_t i = 0; i < 1000; ++i) {
+    uint64_t value = i * 1499999;
+    uint64_t permuted = permutation.Permute(value);
+    EXPECT_LT(permuted, domain_size);
+    EXPECT_EQ(permutation.Inverse(permuted), value);
+  }
+}
+
+TEST(FeistelPermutationTest, DomainAboveDoublePrecision) {
+  // The square roots of these sizes are not exact as doubles.
+  for (uint64_t domain_size :
+       {(uint64_t{1} << 54) + 3, (uint64_t{1} << 62) + 1,
+        uint64_t{3037000499} * 3037000499 + 1,
+        static_cast<uint64_t>(std::numeric_limits<int64_t>::max())}) {
+    FeistelPermutation permutation(domain_size, "seed");
+    std::unordered_set<uint64_t> outputs;
+    for (uint64_t i = 0; i < 100; ++i) {
+      for (uint64_t value : {i, domain_size - 1 - i}) {
+        uint64_t permuted = permutation.Permute(value);
+        EXPECT_LT(permuted, domain_size);
+        EXPECT_EQ(permutation.Inverse(permuted), value);
+        outputs.insert(permuted);
+      }
+    }
+    EXPECT_EQ(outputs.size(), 200);
+  }
+}
+
 }  // namespace
 }  // namespace wfa_virtual_people
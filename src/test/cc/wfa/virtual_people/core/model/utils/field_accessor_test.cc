@@ -0,0 +1,105 @@
+// Copyright 2026 The Cross-Media Measurement Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "wfa/virtual_people/core/model/utils/field_accessor.h"
+
+#include <cstdint>
+
+#include "common_cpp/testing/status_macros.h"
+#include "common_cpp/testing/status_matchers.h"
+#include "gmock/gmock.h"
+#include "google/protobuf/text_format.h"
+#include "gtest/gtest.h"
+#include "wfa/virtual_people/common/field_filter/utils/field_util.h"
+#include "wfa/virtual_people/common/model.pb.h"
+
+namespace wfa_virtual_people {
+namespace {
+
+using ::wfa::StatusIs;
+
+TEST(FieldAccessorTest, TestInvalidField) {
+  EXPECT_THAT(FieldAccessor::Build("bad_field").status(),
+              StatusIs(absl::StatusCode::kInvalidArgument, ""));
+  EXPECT_THAT(FieldAccessor::Build("labeler_input").status(),
+              StatusIs(absl::StatusCode::kInvalidArgument, "message field"));
+  EXPECT_THAT(FieldAccessor::Build("virtual_person_activities").status(),
+              StatusIs(absl::StatusCode::kInvalidArgument, ""));
+}
+
+TEST(FieldAccessorTest, TestGetAndSet) {
+  ASSERT_OK_AND_ASSIGN(
+      FieldAccessor accessor,
+      FieldAccessor::Build("labeler_input.event_id.id_fingerprint"));
+  EXPECT_EQ(accessor.path().size(), 3);
+  EXPECT_EQ(accessor.cpp_type(),
+            google::protobuf::FieldDescriptor::CPPTYPE_UINT64);
+
+  // Not set when any message field along the path is not set.
+  LabelerEvent event;
+  EXPECT_FALSE(accessor.Get<uint64_t>(event).is_set);
+  event.mutable_labeler_input();
+  EXPECT_FALSE(accessor.Get<uint64_t>(event).is_set);
+
+  // Set creates the message fields along the path.
+  LabelerEvent event_2;
+  accessor.Set<uint64_t>(event_2, 10);
+  EXPECT_EQ(event_2.labeler_input().event_id().id_fingerprint(), 10);
+  ProtoFieldValue<uint64_t> value = accessor.Get<uint64_t>(event_2);
+  EXPECT_TRUE(value.is_set);
+  EXPECT_EQ(value.value, 10);
+  ProtoFieldValue<double> double_value = accessor.GetAsDouble(event_2);
+  EXPECT_TRUE(double_value.is_set);
+  EXPECT_EQ(double_value.value, 10.0);
+}
+
+TEST(FieldAccessorTest, TestSetInteger) {
+  ASSERT_OK_AND_ASSIGN(FieldAccessor accessor,
+                       FieldAccessor::Build("multiplicity_person_index"));
+  LabelerEvent event;
+  accessor.SetInteger(event, 3);
+  EXPECT_EQ(event.multiplicity_person_index(), 3);
+  EXPECT_EQ(accessor.Get<int32_t>(event).value, 3);
+}
+
+TEST(FieldAccessorTest, TestCopyTo) {
+  ASSERT_OK_AND_ASSIGN(FieldAccessor country,
+                       FieldAccessor::Build("person_country_code"));
+  ASSERT_OK_AND_ASSIGN(FieldAccessor region,
+                       FieldAccessor::Build("person_region_code"));
+  ASSERT_OK_AND_ASSIGN(FieldAccessor corrected_gender,
+                       FieldAccessor::Build("corrected_demo.gender"));
+  ASSERT_OK_AND_ASSIGN(FieldAccessor acting_gender,
+                       FieldAccessor::Build("acting_demo.gender"));
+
+  LabelerEvent event;
+  ASSERT_TRUE(google::protobuf::TextFormat::ParseFromString(
+      R"pb(
+        person_country_code: "COUNTRY_1"
+        corrected_demo { gender: GENDER_FEMALE }
+      )pb",
+      &event));
+  country.CopyTo(region, event);
+  corrected_gender.CopyTo(acting_gender, event);
+  EXPECT_EQ(event.person_region_code(), "COUNTRY_1");
+  EXPECT_EQ(event.acting_demo().gender(), GENDER_FEMALE);
+
+  // Nothing is copied when the source field is not set.
+  LabelerEvent unset_event;
+  corrected_gender.CopyTo(acting_gender, unset_event);
+  EXPECT_FALSE(unset_event.has_acting_demo());
+}
+
+}  // namespace
+}  // namespace wfa_virtual_people
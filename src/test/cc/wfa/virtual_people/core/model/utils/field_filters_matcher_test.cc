@@ -15,6 +15,8 @@
 #include "wfa/virtual_people/core/model/utils/field_filters_matcher.h"
 
 #include <memory>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "absl/status/statusor.h"
@@ -23,7 +25,9 @@
 #include "gmock/gmock.h"
 #include "google/protobuf/text_format.h"
 #include "gtest/gtest.h"
+#include "wfa/virtual_people/common/demographic.pb.h"
 #include "wfa/virtual_people/common/field_filter.pb.h"
+#include "wfa/virtual_people/common/field_filter/field_filter.h"
 #include "wfa/virtual_people/common/model.pb.h"
 
 namespace wfa_virtual_people {
@@ -31,6 +35,38 @@ namespace {
 
 using ::wfa::StatusIs;
 
+// Parses each of @filters_text to a FieldFilterProto.
+std::vector<FieldFilterProto> ParseFilters(
+    const std::vector<std::string>& filters_text) {
+  std::vector<FieldFilterProto> filters;
+  for (const std::string& filter_text : filters_text) {
+    FieldFilterProto& filter = filters.emplace_back();
+    EXPECT_TRUE(
+        google::protobuf::TextFormat::ParseFromString(filter_text, &filter));
+  }
+  return filters;
+}
+
+std::vector<const FieldFilterProto*> GetPointers(
+    const std::vector<FieldFilterProto>& filters) {
+  std::vector<const FieldFilterProto*> pointers;
+  for (const FieldFilterProto& filter : filters) {
+    pointers.push_back(&filter);
+  }
+  return pointers;
+}
+
+// Builds a FieldFiltersMatcher without index from @filters.
+std::unique_ptr<FieldFiltersMatcher> BuildUnindexed(
+    const std::vector<FieldFilterProto>& filters) {
+  std::vector<std::unique_ptr<FieldFilter>> field_filters;
+  for (const FieldFilterProto& filter : filters) {
+    field_filters.push_back(
+        *FieldFilter::New(LabelerEvent().GetDescriptor(), filter));
+  }
+  return *FieldFiltersMatcher::Build(std::move(field_filters));
+}
+
 TEST(FieldFiltersMatcherTest, EmptyConfig) {
   std::vector<const FieldFilterProto*> filter_configs;
   EXPECT_THAT(FieldFiltersMatcher::Build(filter_configs).status(),
@@ -87,5 +123,115 @@ TEST(FieldFiltersMatcherTest, TestGetFirstMatch) {
   EXPECT_EQ(matcher->GetFirstMatch(event_2), -1);
 }
 
+TEST(FieldFiltersMatcherTest, TestIndexedStringField) {
+  std::vector<FieldFilterProto> filters = ParseFilters({
+      R"pb(name: "person_country_code" op: EQUAL value: "country_code_1")pb",
+      R"pb(name: "person_country_code" op: EQUAL value: "country_code_2")pb",
+      R"pb(name: "person_country_code" op: EQUAL value: "country_code_3")pb",
+      R"pb(name: "person_country_code" op: EQUAL value: "country_code_2")pb",
+      R"pb(name: "person_country_code" op: EQUAL value: "country_code_4")pb",
+  });
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<FieldFiltersMatcher> matcher,
+                       FieldFiltersMatcher::Build(GetPointers(filters)));
+  EXPECT_TRUE(matcher->is_indexed());
+
+  LabelerEvent event;
+  EXPECT_EQ(matcher->GetFirstMatch(event), -1);
+  event.set_person_country_code("country_code_3");
+  EXPECT_EQ(matcher->GetFirstMatch(event), 2);
+  // The first filter with the value matches.
+  event.set_person_country_code("country_code_2");
+  EXPECT_EQ(matcher->GetFirstMatch(event), 1);
+  event.set_person_country_code("country_code_5");
+  EXPECT_EQ(matcher->GetFirstMatch(event), -1);
+}
+
+TEST(FieldFiltersMatcherTest, TestIndexedEnumFieldWithOtherFilters) {
+  std::vector<FieldFilterProto> filters = ParseFilters({
+      R"pb(name: "person_country_code" op: EQUAL value: "country_code_1")pb",
+      R"pb(name: "corrected_demo.gender" op: EQUAL value: "GENDER_MALE")pb",
+      R"pb(name: "corrected_demo.age.min_age" op: GT value: "50")pb",
+      R"pb(name: "corrected_demo.gender" op: EQUAL value: "GENDER_FEMALE")pb",
+      R"pb(name: "corrected_demo.gender" op: EQUAL value: "3")pb",
+      R"pb(name: "corrected_demo.gender" op: EQUAL value: "GENDER_MALE")pb",
+      R"pb(op: TRUE)pb",
+  });
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<FieldFiltersMatcher> matcher,
+                       FieldFiltersMatcher::Build(GetPointers(filters)));
+  EXPECT_TRUE(matcher->is_indexed());
+
+  // Only the last filter matches an event without gender.
+  LabelerEvent event;
+  EXPECT_EQ(matcher->GetFirstMatch(event), 6);
+
+  // An unindexed filter before the indexed match wins.
+  event.set_person_country_code("country_code_1");
+  event.mutable_corrected_demo()->set_gender(GENDER_MALE);
+  EXPECT_EQ(matcher->GetFirstMatch(event), 0);
+
+  event.clear_person_country_code();
+  EXPECT_EQ(matcher->GetFirstMatch(event), 1);
+
+  event.mutable_corrected_demo()->set_gender(GENDER_FEMALE);
+  EXPECT_EQ(matcher->GetFirstMatch(event), 3);
+  event.mutable_corrected_demo()->mutable_age()->set_min_age(60);
+  EXPECT_EQ(matcher->GetFirstMatch(event), 2);
+
+  event.mutable_corrected_demo()->clear_age();
+  event.mutable_corrected_demo()->set_gender(GENDER_OTHER);
+  EXPECT_EQ(matcher->GetFirstMatch(event), 4);
+}
+
+TEST(FieldFiltersMatcherTest, TestNotIndexedWithFewEqualFilters) {
+  std::vector<FieldFilterProto> filters = ParseFilters({
+      R"pb(name: "person_country_code" op: EQUAL value: "country_code_1")pb",
+      R"pb(name: "person_country_code" op: EQUAL value: "country_code_2")pb",
+      R"pb(name: "person_region_code" op: EQUAL value: "region_code_1")pb",
+      R"pb(name: "person_region_code" op: EQUAL value: "region_code_2")pb",
+  });
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<FieldFiltersMatcher> matcher,
+                       FieldFiltersMatcher::Build(GetPointers(filters)));
+  EXPECT_FALSE(matcher->is_indexed());
+
+  LabelerEvent event;
+  event.set_person_region_code("region_code_2");
+  EXPECT_EQ(matcher->GetFirstMatch(event), 3);
+}
+
+TEST(FieldFiltersMatcherTest, TestIndexedMatchesLinearScan) {
+  std::vector<FieldFilterProto> filters = ParseFilters({
+      R"pb(name: "multiplicity_person_index" op: EQUAL value: "3")pb",
+      R"pb(name: "multiplicity_person_index" op: EQUAL value: "-1")pb",
+      R"pb(name: "multiplicity_person_index" op: LT value: "0")pb",
+      R"pb(name: "multiplicity_person_index" op: EQUAL value: "0")pb",
+      R"pb(name: "multiplicity_person_index" op: EQUAL value: "5")pb",
+      R"pb(name: "multiplicity_person_index" op: EQUAL value: "3")pb",
+      R"pb(name: "acting_fingerprint" op: EQUAL value: "1")pb",
+      R"pb(name: "multiplicity_person_index" op: EQUAL value: "1")pb",
+      R"pb(name: "multiplicity_person_index" op: HAS)pb",
+  });
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<FieldFiltersMatcher> matcher,
+                       FieldFiltersMatcher::Build(GetPointers(filters)));
+  EXPECT_TRUE(matcher->is_indexed());
+  std::unique_ptr<FieldFiltersMatcher> unindexed_matcher =
+      BuildUnindexed(filters);
+  EXPECT_FALSE(unindexed_matcher->is_indexed());
+
+  for (int fingerprint = 0; fingerprint < 3; ++fingerprint) {
+    for (int index = -3; index < 8; ++index) {
+      LabelerEvent event;
+      if (fingerprint > 0) {
+        event.set_acting_fingerprint(fingerprint);
+      }
+      if (index > -3) {
+        event.set_multiplicity_person_index(index);
+      }
+      EXPECT_EQ(matcher->GetFirstMatch(event),
+                unindexed_matcher->GetFirstMatch(event))
+          << event.DebugString();
+    }
+  }
+}
+
 }  // namespace
 }  // namespace wfa_virtual_people
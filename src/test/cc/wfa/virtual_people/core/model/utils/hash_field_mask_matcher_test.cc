@@ -26,6 +26,7 @@
 #include "gmock/gmock.h"
 #include "google/protobuf/text_format.h"
 #include "gtest/gtest.h"
+#include "wfa/virtual_people/common/demographic.pb.h"
 #include "wfa/virtual_people/common/model.pb.h"
 
 namespace wfa_virtual_people {
@@ -156,5 +157,94 @@ TEST(HashFieldMaskMatcherTest, TestUnsetField) {
   EXPECT_EQ(matcher->GetMatch(event_2), -1);
 }
 
+TEST(HashFieldMaskMatcherTest, InvalidPath) {
+  LabelerEvent input_event;
+  input_event.set_person_country_code("COUNTRY_1");
+  std::vector<const LabelerEvent*> events = {&input_event};
+  EXPECT_THAT(
+      HashFieldMaskMatcher::Build(events, MakeFieldMask({"invalid_field"}))
+          .status(),
+      StatusIs(absl::StatusCode::kInvalidArgument, ""));
+  EXPECT_THAT(HashFieldMaskMatcher::Build(
+                  events, MakeFieldMask({"person_country_code.invalid"}))
+                  .status(),
+              StatusIs(absl::StatusCode::kInvalidArgument, ""));
+  EXPECT_THAT(HashFieldMaskMatcher::Build(
+                  events,
+                  MakeFieldMask({"virtual_person_activities.virtual_person_id"}))
+                  .status(),
+              StatusIs(absl::StatusCode::kInvalidArgument, ""));
+}
+
+TEST(HashFieldMaskMatcherTest, TestNestedFields) {
+  std::vector<LabelerEvent> input_events(4);
+  input_events[1].mutable_corrected_demo()->mutable_age()->set_min_age(0);
+  input_events[2].mutable_corrected_demo()->set_gender(GENDER_FEMALE);
+  input_events[3].mutable_corrected_demo()->mutable_age()->set_min_age(18);
+  input_events[3].mutable_corrected_demo()->set_gender(GENDER_FEMALE);
+  input_events[3].set_acting_fingerprint(1);
+  std::vector<const LabelerEvent*> events;
+  for (const LabelerEvent& input_event : input_events) {
+    events.push_back(&input_event);
+  }
+
+  // The duplicated path is ignored.
+  FieldMask hash_field_mask =
+      MakeFieldMask({"corrected_demo.gender", "acting_fingerprint",
+                     "corrected_demo.age.min_age", "acting_fingerprint"});
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<HashFieldMaskMatcher> matcher,
+                       HashFieldMaskMatcher::Build(events, hash_field_mask));
+
+  for (int i = 0; i < input_events.size(); ++i) {
+    EXPECT_EQ(matcher->GetMatch(input_events[i]), i);
+  }
+
+  // Unset parent messages are the same as unset fields.
+  LabelerEvent event_1;
+  event_1.mutable_corrected_demo()->mutable_age();
+  EXPECT_EQ(matcher->GetMatch(event_1), 0);
+
+  // Fields not in the mask are ignored.
+  LabelerEvent event_2;
+  event_2.set_person_country_code("COUNTRY_1");
+  event_2.mutable_corrected_demo()->mutable_age()->set_max_age(30);
+  event_2.mutable_corrected_demo()->set_gender(GENDER_FEMALE);
+  EXPECT_EQ(matcher->GetMatch(event_2), 2);
+
+  // No matches. Returns -1.
+  LabelerEvent event_3 = input_events[3];
+  event_3.set_acting_fingerprint(2);
+  EXPECT_EQ(matcher->GetMatch(event_3), -1);
+  LabelerEvent event_4;
+  event_4.mutable_corrected_demo()->set_gender(GENDER_MALE);
+  EXPECT_EQ(matcher->GetMatch(event_4), -1);
+}
+
+TEST(HashFieldMaskMatcherTest, TestMessageField) {
+  LabelerEvent input_event_1;
+  input_event_1.mutable_corrected_demo()->set_gender(GENDER_FEMALE);
+  LabelerEvent input_event_2;
+  input_event_2.mutable_corrected_demo();
+  LabelerEvent input_event_3;
+  std::vector<const LabelerEvent*> events = {&input_event_1, &input_event_2,
+                                             &input_event_3};
+
+  // The path corrected_demo.gender is covered by corrected_demo.
+  FieldMask hash_field_mask =
+      MakeFieldMask({"corrected_demo.gender", "corrected_demo"});
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<HashFieldMaskMatcher> matcher,
+                       HashFieldMaskMatcher::Build(events, hash_field_mask));
+
+  EXPECT_EQ(matcher->GetMatch(input_event_1), 0);
+  EXPECT_EQ(matcher->GetMatch(input_event_2), 1);
+  EXPECT_EQ(matcher->GetMatch(input_event_3), 2);
+
+  // All the fields in the message are included.
+  LabelerEvent event;
+  event.mutable_corrected_demo()->set_gender(GENDER_FEMALE);
+  event.mutable_corrected_demo()->mutable_age()->set_min_age(18);
+  EXPECT_EQ(matcher->GetMatch(event), -1);
+}
+
 }  // namespace
 }  // namespace wfa_virtual_people
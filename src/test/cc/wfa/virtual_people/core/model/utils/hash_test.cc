@@ -0,0 +1,129 @@
+// Copyright 2026 The Cross-Media Measurement Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "wfa/virtual_people/core/model/utils/hash.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
+#include "gtest/gtest.h"
+#include "src/farmhash.h"
+
+namespace wfa_virtual_people {
+namespace {
+
+using internal::FloatHashKernel;
+
+constexpr int kSeedNumber = 10000;
+
+// Compares the bits, so that e.g. 0.0 and -0.0 are different.
+uint64_t ToBits(double value) {
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+// Fingerprints of seeds, and edge cases of the conversion to double. The size
+// is not a multiple of any vector width, so the scalar tails are covered.
+std::vector<uint64_t> GetFingerprints() {
+  std::vector<uint64_t> fingerprints = {
+      0,
+      1,
+      (uint64_t{1} << 53) - 1,
+      uint64_t{1} << 53,
+      (uint64_t{1} << 53) + 1,
+      (uint64_t{1} << 63) - 1,
+      uint64_t{1} << 63,
+      (uint64_t{1} << 63) + 1,
+      // Halfway between 2 doubles, which rounds to even.
+      (uint64_t{1} << 63) + (uint64_t{1} << 10),
+      (uint64_t{1} << 63) + (uint64_t{3} << 10),
+      std::numeric_limits<uint64_t>::max() - 1024,
+      std::numeric_limits<uint64_t>::max(),
+  };
+  for (int seed = 0; seed < kSeedNumber; ++seed) {
+    fingerprints.push_back(util::Fingerprint64(absl::StrCat("seed-", seed)));
+  }
+  fingerprints.push_back(util::Fingerprint64(std::string("last")));
+  return fingerprints;
+}
+
+TEST(HashTest, TestFloatHashBatchMatchesFloatHash) {
+  std::vector<std::string> seeds;
+  std::vector<uint64_t> fingerprints;
+  for (int seed = 0; seed < kSeedNumber + 3; ++seed) {
+    seeds.push_back(absl::StrCat("seed-", seed));
+    fingerprints.push_back(util::Fingerprint64(seeds.back()));
+  }
+  std::vector<double> float_hashes(fingerprints.size());
+  FloatHashBatch(fingerprints, absl::MakeSpan(float_hashes));
+  std::vector<double> exp_hashes(fingerprints.size());
+  ExpHashBatch(fingerprints, absl::MakeSpan(exp_hashes));
+
+  for (size_t i = 0; i < seeds.size(); ++i) {
+    EXPECT_EQ(ToBits(float_hashes[i]), ToBits(FloatHash(seeds[i])));
+    EXPECT_EQ(ToBits(exp_hashes[i]), ToBits(ExpHash(seeds[i])));
+  }
+}
+
+TEST(HashTest, TestKernelsAreBitIdentical) {
+  std::vector<uint64_t> fingerprints = GetFingerprints();
+  std::vector<double> expected(fingerprints.size());
+  for (size_t i = 0; i < fingerprints.size(); ++i) {
+    expected[i] =
+        static_cast<double>(fingerprints[i]) /
+        static_cast<double>(std::numeric_limits<uint64_t>::max());
+  }
+
+  for (FloatHashKernel kernel :
+       {FloatHashKernel::kScalar, FloatHashKernel::kAvx2,
+        FloatHashKernel::kAvx512}) {
+    if (!internal::IsFloatHashKernelSupported(kernel)) {
+      continue;
+    }
+    // All the sizes up to 2 full vectors, to cover every tail length.
+    for (size_t size = 0; size <= 32; ++size) {
+      std::vector<double> output(size);
+      internal::FloatHashBatchWithKernel(
+          kernel, absl::MakeConstSpan(fingerprints.data(), size),
+          absl::MakeSpan(output));
+      for (size_t i = 0; i < size; ++i) {
+        EXPECT_EQ(ToBits(output[i]), ToBits(expected[i]))
+            << "kernel " << static_cast<int>(kernel) << ", fingerprint "
+            << fingerprints[i];
+      }
+    }
+    std::vector<double> output(fingerprints.size());
+    internal::FloatHashBatchWithKernel(kernel, fingerprints,
+                                       absl::MakeSpan(output));
+    for (size_t i = 0; i < fingerprints.size(); ++i) {
+      EXPECT_EQ(ToBits(output[i]), ToBits(expected[i]))
+          << "kernel " << static_cast<int>(kernel) << ", fingerprint "
+          << fingerprints[i];
+    }
+  }
+}
+
+TEST(HashTest, TestScalarKernelIsAlwaysSupported) {
+  EXPECT_TRUE(internal::IsFloatHashKernelSupported(FloatHashKernel::kScalar));
+}
+
+}  // namespace
+}  // namespace wfa_virtual_people
@@ -0,0 +1,109 @@
+// Copyright 2026 The Cross-Media Measurement Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "wfa/virtual_people/core/model/utils/path_trace.h"
+
+#include <string>
+
+#include "common_cpp/testing/status_macros.h"
+#include "common_cpp/testing/status_matchers.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace wfa_virtual_people {
+namespace {
+
+using ::wfa::StatusIs;
+
+TEST(PathTraceTest, SerializeAndRender) {
+  std::string root_name = "Root";
+  std::string child_name = "";
+  PathTrace trace;
+  trace.RecordNode(root_name);
+  trace.RecordUpdate(2, -1);
+  trace.RecordBranch(1);
+  trace.RecordNode(child_name);
+  trace.RecordMultiplicity(300);
+  trace.RecordBranch(0);
+  trace.RecordNode(root_name);
+
+  ASSERT_OK_AND_ASSIGN(std::string rendered,
+                       PathTrace::Render(trace.Serialize()));
+  EXPECT_EQ(rendered,
+            "node: Root\n"
+            "update: row=2 column=-1\n"
+            "branch: 1\n"
+            "node: <unnamed>\n"
+            "multiplicity: clones=300\n"
+            "branch: 0\n"
+            "node: Root\n");
+}
+
+TEST(PathTraceTest, ClearKeepsNothing) {
+  std::string name = "Root";
+  PathTrace trace;
+  trace.RecordNode(name);
+  trace.Clear();
+  EXPECT_TRUE(trace.entries().empty());
+  ASSERT_OK_AND_ASSIGN(std::string rendered,
+                       PathTrace::Render(trace.Serialize()));
+  EXPECT_EQ(rendered, "");
+}
+
+TEST(PathTraceTest, RecordsOnlyInScope) {
+  std::string name = "Root";
+  PathTrace outer;
+  PathTrace inner;
+  TraceNode(name);
+  EXPECT_EQ(PathTrace::Current(), nullptr);
+  {
+    ScopedPathTrace outer_scope(&outer);
+    TraceBranch(1);
+    {
+      ScopedPathTrace inner_scope(&inner);
+      TraceNode(name);
+      TraceUpdate(0, 1);
+    }
+    EXPECT_EQ(PathTrace::Current(), &outer);
+    TraceMultiplicity(2);
+  }
+  EXPECT_EQ(PathTrace::Current(), nullptr);
+  TraceBranch(3);
+
+  EXPECT_EQ(outer.entries().size(), 2);
+  EXPECT_EQ(inner.entries().size(), 2);
+}
+
+TEST(PathTraceTest, RenderMalformed) {
+  EXPECT_THAT(PathTrace::Render("").status(),
+              StatusIs(absl::StatusCode::kInvalidArgument, "malformed"));
+
+  std::string name = "Root";
+  PathTrace trace;
+  trace.RecordNode(name);
+  std::string serialized = trace.Serialize();
+  EXPECT_THAT(
+      PathTrace::Render(serialized.substr(0, serialized.size() - 1)).status(),
+      StatusIs(absl::StatusCode::kInvalidArgument, "malformed"));
+  EXPECT_THAT(PathTrace::Render(serialized + "x").status(),
+              StatusIs(absl::StatusCode::kInvalidArgument, "malformed"));
+}
+
+TEST(PathTraceTest, RenderUnsupportedVersion) {
+  EXPECT_THAT(PathTrace::Render(std::string(1, '\x7f')).status(),
+              StatusIs(absl::StatusCode::kInvalidArgument, "version"));
+}
+
+}  // namespace
+}  // namespace wfa_virtual_people
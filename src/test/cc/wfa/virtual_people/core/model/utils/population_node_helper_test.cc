@@ -0,0 +1,171 @@
+// Copyright 2026 The Cross-Media Measurement Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "wfa/virtual_people/core/model/utils/population_node_helper.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "absl/strings/str_cat.h"
+#include "common_cpp/testing/common_matchers.h"
+#include "common_cpp/testing/status_matchers.h"
+#include "gmock/gmock.h"
+#include "google/protobuf/text_format.h"
+#include "gtest/gtest.h"
+#include "wfa/virtual_people/common/label.pb.h"
+#include "wfa/virtual_people/common/model.pb.h"
+
+namespace wfa_virtual_people {
+namespace {
+
+using ::wfa::EqualsProto;
+using ::wfa::IsOk;
+using ::wfa::StatusIs;
+
+constexpr int kSeedNumber = 1000;
+
+QuantumLabel GetQuantumLabel(absl::string_view seed) {
+  QuantumLabel quantum_label;
+  EXPECT_TRUE(google::protobuf::TextFormat::ParseFromString(
+      R"pb(
+        labels { demo { gender: GENDER_FEMALE } }
+        labels { demo { gender: GENDER_MALE } }
+        labels { demo { age { min_age: 1 max_age: 10 } } }
+        probabilities: 0.5
+        probabilities: 0.3
+        probabilities: 0.2
+      )pb",
+      &quantum_label));
+  quantum_label.set_seed(std::string(seed));
+  return quantum_label;
+}
+
+TEST(QuantumLabelCollapserTest, TestMatchesCollapseQuantumLabel) {
+  QuantumLabelCollapser collapser;
+  QuantumLabel quantum_label = GetQuantumLabel("TestSeed");
+  for (uint64_t seed_suffix = 0; seed_suffix < kSeedNumber; ++seed_suffix) {
+    PersonLabelAttributes expected;
+    ASSERT_THAT(CollapseQuantumLabel(quantum_label, absl::StrCat(seed_suffix),
+                                     expected),
+                IsOk());
+    PersonLabelAttributes output;
+    ASSERT_THAT(collapser.Collapse(quantum_label, seed_suffix, output), IsOk());
+    EXPECT_THAT(output, EqualsProto(expected));
+  }
+  EXPECT_EQ(collapser.cache_size(), 1);
+}
+
+TEST(QuantumLabelCollapserTest, TestDistinctQuantumLabels) {
+  QuantumLabelCollapser collapser;
+  QuantumLabel quantum_label_1 = GetQuantumLabel("TestSeed1");
+  QuantumLabel quantum_label_2 = GetQuantumLabel("TestSeed1");
+  quantum_label_2.set_probabilities(0, 0.2);
+  quantum_label_2.set_probabilities(2, 0.5);
+  QuantumLabel quantum_label_3 = GetQuantumLabel("TestSeed3");
+  for (uint64_t seed_suffix = 0; seed_suffix < kSeedNumber; ++seed_suffix) {
+    for (const QuantumLabel* quantum_label :
+         {&quantum_label_1, &quantum_label_2, &quantum_label_3}) {
+      PersonLabelAttributes expected;
+      ASSERT_THAT(CollapseQuantumLabel(*quantum_label,
+                                       absl::StrCat(seed_suffix), expected),
+                  IsOk());
+      PersonLabelAttributes output;
+      ASSERT_THAT(collapser.Collapse(*quantum_label, seed_suffix, output),
+                  IsOk());
+      EXPECT_THAT(output, EqualsProto(expected));
+    }
+  }
+  EXPECT_EQ(collapser.cache_size(), 3);
+}
+
+TEST(QuantumLabelCollapserTest, TestCacheIsBounded) {
+  QuantumLabelCollapser collapser;
+  for (int i = 0; i < QuantumLabelCollapser::kMaxCacheSize + 10; ++i) {
+    QuantumLabel quantum_label = GetQuantumLabel(absl::StrCat("Seed", i));
+    PersonLabelAttributes expected;
+    ASSERT_THAT(CollapseQuantumLabel(quantum_label, "12345", expected), IsOk());
+    PersonLabelAttributes output;
+    ASSERT_THAT(collapser.Collapse(quantum_label, 12345, output), IsOk());
+    EXPECT_THAT(output, EqualsProto(expected));
+  }
+  EXPECT_EQ(collapser.cache_size(), QuantumLabelCollapser::kMaxCacheSize);
+}
+
+TEST(QuantumLabelCollapserTest, TestInvalidQuantumLabels) {
+  QuantumLabelCollapser collapser;
+  PersonLabelAttributes output;
+
+  QuantumLabel empty;
+  EXPECT_THAT(collapser.Collapse(empty, 1, output),
+              StatusIs(absl::StatusCode::kInvalidArgument, ""));
+
+  QuantumLabel size_mismatch = GetQuantumLabel("TestSeed");
+  size_mismatch.add_probabilities(0);
+  EXPECT_THAT(collapser.Collapse(size_mismatch, 1, output),
+              StatusIs(absl::StatusCode::kInvalidArgument, ""));
+
+  QuantumLabel invalid_probabilities = GetQuantumLabel("TestSeed");
+  invalid_probabilities.set_probabilities(0, 0.9);
+  EXPECT_THAT(collapser.Collapse(invalid_probabilities, 1, output),
+              StatusIs(absl::StatusCode::kInvalidArgument, ""));
+
+  EXPECT_EQ(collapser.cache_size(), 0);
+}
+
+TEST(QuantumLabelCollapserTest, TestPrecompiled) {
+  QuantumLabel quantum_label_1 = GetQuantumLabel("TestSeed1");
+  QuantumLabel quantum_label_1_copy = GetQuantumLabel("TestSeed1");
+  QuantumLabel quantum_label_2 = GetQuantumLabel("TestSeed2");
+  QuantumLabel not_precompiled = GetQuantumLabel("TestSeed3");
+  QuantumLabel invalid;
+  std::shared_ptr<const QuantumLabelCollapser::Precompiled> precompiled =
+      QuantumLabelCollapser::Precompile(
+          {&quantum_label_1, &quantum_label_1_copy, &quantum_label_2,
+           &invalid});
+  // Equal quantum labels are compiled once, and invalid ones are skipped.
+  EXPECT_EQ(precompiled->size(), 2);
+
+  // The precompiled table is shared by the collapsers.
+  QuantumLabelCollapser collapser_1;
+  QuantumLabelCollapser collapser_2;
+  collapser_1.UsePrecompiled(precompiled);
+  collapser_2.UsePrecompiled(precompiled);
+  for (uint64_t seed_suffix = 0; seed_suffix < kSeedNumber; ++seed_suffix) {
+    for (const QuantumLabel* quantum_label :
+         {&quantum_label_1, &quantum_label_2, &not_precompiled}) {
+      PersonLabelAttributes expected;
+      ASSERT_THAT(CollapseQuantumLabel(*quantum_label,
+                                       absl::StrCat(seed_suffix), expected),
+                  IsOk());
+      for (const QuantumLabelCollapser* collapser :
+           {&collapser_1, &collapser_2}) {
+        PersonLabelAttributes output;
+        ASSERT_THAT(collapser->Collapse(*quantum_label, seed_suffix, output),
+                    IsOk());
+        EXPECT_THAT(output, EqualsProto(expected));
+      }
+    }
+  }
+  // Only the quantum label not precompiled is cached.
+  EXPECT_EQ(collapser_1.cache_size(), 1);
+  EXPECT_EQ(collapser_2.cache_size(), 1);
+
+  PersonLabelAttributes output;
+  EXPECT_THAT(collapser_1.Collapse(invalid, 1, output),
+              StatusIs(absl::StatusCode::kInvalidArgument, ""));
+}
+
+}  // namespace
+}  // namespace wfa_virtual_people
@@ -0,0 +1,157 @@
+// Copyright 2026 The Cross-Media Measurement Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "wfa/virtual_people/core/model/utils/predicate_cache.h"
+
+#include <memory>
+#include <string>
+
+#include "common_cpp/testing/status_macros.h"
+#include "gmock/gmock.h"
+#include "google/protobuf/text_format.h"
+#include "gtest/gtest.h"
+#include "wfa/virtual_people/common/field_filter.pb.h"
+#include "wfa/virtual_people/common/field_filter/field_filter.h"
+#include "wfa/virtual_people/common/model.pb.h"
+
+namespace wfa_virtual_people {
+namespace {
+
+FieldFilterProto ParseFilter(const std::string& filter_text) {
+  FieldFilterProto filter;
+  EXPECT_TRUE(
+      google::protobuf::TextFormat::ParseFromString(filter_text, &filter));
+  return filter;
+}
+
+// Returns the mask of the top level field of LabelerEvent named @name.
+EventFieldMask GetFieldMask(const std::string& name) {
+  return EventFieldMask{1}
+         << LabelerEvent::GetDescriptor()->FindFieldByName(name)->index();
+}
+
+TEST(PredicateCacheTest, TestReadFields) {
+  EXPECT_EQ(MakePredicateConfig(ParseFilter(R"pb(
+                                  name: "corrected_demo.gender"
+                                  op: EQUAL
+                                  value: "GENDER_FEMALE"
+                                )pb"))
+                .read_fields,
+            GetFieldMask("corrected_demo"));
+  EXPECT_EQ(MakePredicateConfig(ParseFilter(R"pb(
+                                  op: OR
+                                  sub_filters {
+                                    name: "person_country_code"
+                                    op: HAS
+                                  }
+                                  sub_filters {
+                                    op: NOT
+                                    sub_filters {
+                                      name: "acting_fingerprint"
+                                      op: GT
+                                      value: "10"
+                                    }
+                                  }
+                                )pb"))
+                .read_fields,
+            GetFieldMask("person_country_code") |
+                GetFieldMask("acting_fingerprint"));
+  // The sub filters of PARTIAL are in corrected_demo.
+  EXPECT_EQ(MakePredicateConfig(ParseFilter(R"pb(
+                                  name: "corrected_demo"
+                                  op: PARTIAL
+                                  sub_filters {
+                                    name: "gender"
+                                    op: EQUAL
+                                    value: "GENDER_FEMALE"
+                                  }
+                                )pb"))
+                .read_fields,
+            GetFieldMask("corrected_demo"));
+  EXPECT_EQ(MakePredicateConfig(ParseFilter(R"pb(op: TRUE)pb")).read_fields,
+            0);
+}
+
+TEST(PredicateCacheTest, TestRegisterSharesIds) {
+  PredicateRegistry registry;
+  FieldFilterProto filter_1 = ParseFilter(
+      R"pb(name: "person_country_code" op: EQUAL value: "COUNTRY_1")pb");
+  FieldFilterProto filter_2 = ParseFilter(
+      R"pb(name: "person_country_code" op: EQUAL value: "COUNTRY_2")pb");
+  int id_1 = registry.Register(MakePredicateConfig(filter_1));
+  int id_2 = registry.Register(MakePredicateConfig(filter_2));
+  EXPECT_NE(id_1, id_2);
+  EXPECT_EQ(registry.Register(MakePredicateConfig(filter_1)), id_1);
+  EXPECT_EQ(registry.Register(MakePredicateConfig(filter_2)), id_2);
+  EXPECT_EQ(registry.size(), 2);
+}
+
+TEST(PredicateCacheTest, TestCacheAndInvalidate) {
+  FieldFilterProto filter_config = ParseFilter(
+      R"pb(name: "person_country_code" op: EQUAL value: "COUNTRY_1")pb");
+  ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<FieldFilter> filter,
+      FieldFilter::New(LabelerEvent().GetDescriptor(), filter_config));
+  PredicateRegistry registry;
+  int id = registry.Register(MakePredicateConfig(filter_config));
+
+  LabelerEvent event;
+  event.set_person_country_code("COUNTRY_1");
+  PredicateCache cache;
+  cache.Reset(registry, event);
+  ScopedPredicateCache scoped_cache(&cache);
+  EXPECT_TRUE(MatchPredicate(id, *filter, event));
+
+  // The cached result is used until person_country_code is invalidated.
+  event.set_person_country_code("COUNTRY_2");
+  EXPECT_TRUE(MatchPredicate(id, *filter, event));
+  InvalidatePredicates(event, GetFieldMask("person_region_code"));
+  EXPECT_TRUE(MatchPredicate(id, *filter, event));
+  InvalidatePredicates(event, GetFieldMask("person_country_code"));
+  EXPECT_FALSE(MatchPredicate(id, *filter, event));
+
+  // Other events are not cached.
+  LabelerEvent other_event;
+  other_event.set_person_country_code("COUNTRY_1");
+  EXPECT_TRUE(MatchPredicate(id, *filter, other_event));
+  EXPECT_FALSE(MatchPredicate(id, *filter, event));
+
+  // Unregistered predicates are not cached.
+  event.set_person_country_code("COUNTRY_1");
+  EXPECT_TRUE(MatchPredicate(kNoPredicateId, *filter, event));
+
+  // Reset drops all the results.
+  cache.Reset(registry, event);
+  EXPECT_TRUE(MatchPredicate(id, *filter, event));
+}
+
+TEST(PredicateCacheTest, TestNoCurrentCache) {
+  FieldFilterProto filter_config = ParseFilter(
+      R"pb(name: "person_country_code" op: EQUAL value: "COUNTRY_1")pb");
+  ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<FieldFilter> filter,
+      FieldFilter::New(LabelerEvent().GetDescriptor(), filter_config));
+  PredicateRegistry registry;
+  int id = registry.Register(MakePredicateConfig(filter_config));
+
+  EXPECT_EQ(PredicateCache::Current(), nullptr);
+  LabelerEvent event;
+  event.set_person_country_code("COUNTRY_1");
+  EXPECT_TRUE(MatchPredicate(id, *filter, event));
+  event.set_person_country_code("COUNTRY_2");
+  EXPECT_FALSE(MatchPredicate(id, *filter, event));
+}
+
+}  // namespace
+}  // namespace wfa_virtual_people
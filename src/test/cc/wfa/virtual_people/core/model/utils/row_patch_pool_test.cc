@@ -0,0 +1,102 @@
+// Copyright 2026 The Cross-Media Measurement Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "wfa/virtual_people/core/model/utils/row_patch_pool.h"
+
+#include <cstdint>
+#include <memory>
+
+#include "common_cpp/testing/common_matchers.h"
+#include "common_cpp/testing/status_macros.h"
+#include "common_cpp/testing/status_matchers.h"
+#include "gmock/gmock.h"
+#include "google/protobuf/text_format.h"
+#include "gtest/gtest.h"
+#include "wfa/virtual_people/common/model.pb.h"
+#include "wfa/virtual_people/core/model/utils/row_patch.h"
+
+namespace wfa_virtual_people {
+namespace {
+
+using ::wfa::EqualsProto;
+
+TEST(RowPatchPoolTest, TestAddEqualRows) {
+  LabelerEvent row_1;
+  ASSERT_TRUE(google::protobuf::TextFormat::ParseFromString(
+      R"pb(
+        person_country_code: "COUNTRY_1"
+        corrected_demo { gender: GENDER_FEMALE }
+      )pb",
+      &row_1));
+  LabelerEvent row_2;
+  ASSERT_TRUE(google::protobuf::TextFormat::ParseFromString(
+      R"pb(
+        person_country_code: "COUNTRY_2"
+        corrected_demo { gender: GENDER_FEMALE }
+      )pb",
+      &row_2));
+
+  RowPatchPool pool;
+  ASSERT_OK_AND_ASSIGN(int32_t id_1, pool.Add(row_1));
+  ASSERT_OK_AND_ASSIGN(int32_t id_2, pool.Add(row_2));
+  ASSERT_OK_AND_ASSIGN(int32_t id_3, pool.Add(row_1));
+  EXPECT_EQ(id_1, 0);
+  EXPECT_EQ(id_2, 1);
+  // Equal rows get the same id.
+  EXPECT_EQ(id_3, id_1);
+  ASSERT_EQ(pool.patches().size(), 2);
+  EXPECT_THAT(pool.patches()[id_1]->row(), EqualsProto(row_1));
+  EXPECT_THAT(pool.patches()[id_2]->row(), EqualsProto(row_2));
+}
+
+TEST(RowPatchPoolTest, TestIntern) {
+  LabelerEvent row;
+  ASSERT_TRUE(google::protobuf::TextFormat::ParseFromString(
+      R"pb(
+        person_country_code: "COUNTRY_1"
+        quantum_labels {
+          quantum_labels {
+            labels { demo { gender: GENDER_FEMALE } }
+            probabilities: 1
+          }
+        }
+      )pb",
+      &row));
+
+  // The patches of equal rows built by different updaters.
+  RowPatchPool pool_1;
+  ASSERT_OK_AND_ASSIGN(int32_t id_1, pool_1.Add(row));
+  RowPatchPool pool_2;
+  ASSERT_OK_AND_ASSIGN(int32_t id_2, pool_2.Add(row));
+  std::shared_ptr<const RowPatch> patch_1 = pool_1.patches()[id_1];
+  std::shared_ptr<const RowPatch> patch_2 = pool_2.patches()[id_2];
+  ASSERT_NE(patch_1, patch_2);
+
+  // Both are replaced by the first one interned.
+  RowPatchPool model_pool;
+  EXPECT_EQ(model_pool.Intern(patch_1), patch_1);
+  EXPECT_EQ(model_pool.Intern(patch_2), patch_1);
+  EXPECT_EQ(model_pool.patches().size(), 1);
+
+  // The interned patch stays valid after the pools are destroyed.
+  std::shared_ptr<const RowPatch> interned = model_pool.Intern(patch_2);
+  patch_1.reset();
+  patch_2.reset();
+  LabelerEvent event;
+  interned->Apply(event);
+  EXPECT_THAT(event, EqualsProto(row));
+}
+
+}  // namespace
+}  // namespace wfa_virtual_people
@@ -0,0 +1,95 @@
+// Copyright 2026 The Cross-Media Measurement Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "wfa/virtual_people/core/model/utils/row_patch.h"
+
+#include <string>
+
+#include "common_cpp/testing/common_matchers.h"
+#include "common_cpp/testing/status_macros.h"
+#include "gmock/gmock.h"
+#include "google/protobuf/text_format.h"
+#include "gtest/gtest.h"
+#include "wfa/virtual_people/common/model.pb.h"
+
+namespace wfa_virtual_people {
+namespace {
+
+using ::wfa::EqualsProto;
+
+LabelerEvent ParseEvent(const std::string& event_text) {
+  LabelerEvent event;
+  EXPECT_TRUE(
+      google::protobuf::TextFormat::ParseFromString(event_text, &event));
+  return event;
+}
+
+// Applies the patch of @row to @event, and checks that the result is the same
+// as merging @row into @event.
+void ExpectSameAsMerge(const LabelerEvent& row, const LabelerEvent& event,
+                       bool is_compiled) {
+  ASSERT_OK_AND_ASSIGN(RowPatch patch, RowPatch::Build(row));
+  EXPECT_EQ(patch.is_compiled(), is_compiled);
+  EXPECT_THAT(patch.row(), EqualsProto(row));
+
+  LabelerEvent patched_event = event;
+  patch.Apply(patched_event);
+  LabelerEvent merged_event = event;
+  merged_event.MergeFrom(row);
+  EXPECT_THAT(patched_event, EqualsProto(merged_event));
+}
+
+constexpr char kEvent[] = R"pb(
+  acting_fingerprint: 1
+  person_country_code: "COUNTRY_1"
+  corrected_demo { gender: GENDER_MALE age { min_age: 20 max_age: 30 } }
+  labeler_input { event_id { id: "id" } }
+)pb";
+
+TEST(RowPatchTest, TestScalarFields) {
+  ExpectSameAsMerge(ParseEvent(R"pb(
+                      acting_fingerprint: 2
+                      person_region_code: "REGION_1"
+                      pool_identity_mode: true
+                      expected_multiplicity: 1.5
+                    )pb"),
+                    ParseEvent(kEvent), /*is_compiled=*/true);
+}
+
+TEST(RowPatchTest, TestNestedFields) {
+  LabelerEvent row = ParseEvent(R"pb(
+    corrected_demo { gender: GENDER_FEMALE age { min_age: 10 } }
+    labeler_input { event_id { id_fingerprint: 3 } }
+  )pb");
+  ExpectSameAsMerge(row, ParseEvent(kEvent), /*is_compiled=*/true);
+  ExpectSameAsMerge(row, LabelerEvent(), /*is_compiled=*/true);
+}
+
+TEST(RowPatchTest, TestEmptyRow) {
+  ExpectSameAsMerge(LabelerEvent(), ParseEvent(kEvent), /*is_compiled=*/true);
+}
+
+TEST(RowPatchTest, TestRowsMergedWithMergeFrom) {
+  // Repeated fields are appended.
+  ExpectSameAsMerge(ParseEvent(R"pb(
+                      virtual_person_activities { virtual_person_id: 1 }
+                    )pb"),
+                    ParseEvent(kEvent), /*is_compiled=*/false);
+  // Empty message fields are set.
+  ExpectSameAsMerge(ParseEvent(R"pb(acting_demo {})pb"), ParseEvent(kEvent),
+                    /*is_compiled=*/false);
+}
+
+}  // namespace
+}  // namespace wfa_virtual_people
@@ -0,0 +1,59 @@
+// Copyright 2026 The Cross-Media Measurement Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "wfa/virtual_people/core/model/utils/seeded_fingerprinter.h"
+
+#include <cstdint>
+#include <limits>
+#include <string>
+
+#include "absl/strings/str_cat.h"
+#include "gtest/gtest.h"
+#include "src/farmhash.h"
+
+namespace wfa_virtual_people {
+namespace {
+
+constexpr int kValueNumber = 10000;
+
+TEST(SeededFingerprinterTest, TestMatchesStrCat) {
+  SeededFingerprinter fingerprinter("TestSeed");
+  EXPECT_EQ(fingerprinter.seed(), "TestSeed");
+  for (uint64_t value = 0; value < kValueNumber; ++value) {
+    uint64_t large_value = value * 0x9E3779B97F4A7C15;
+    EXPECT_EQ(fingerprinter.Fingerprint(large_value),
+              util::Fingerprint64(absl::StrCat("TestSeed", large_value)));
+  }
+  uint64_t max_value = std::numeric_limits<uint64_t>::max();
+  EXPECT_EQ(fingerprinter.Fingerprint(max_value),
+            util::Fingerprint64(absl::StrCat("TestSeed", max_value)));
+}
+
+TEST(SeededFingerprinterTest, TestEmptySeed) {
+  SeededFingerprinter fingerprinter("");
+  EXPECT_EQ(fingerprinter.Fingerprint(12345),
+            util::Fingerprint64(std::string("12345")));
+}
+
+TEST(SeededFingerprinterTest, TestLongSeed) {
+  std::string seed(SeededFingerprinter::kInlineSeedSize, 'a');
+  SeededFingerprinter fingerprinter(seed);
+  for (uint64_t value = 0; value < 100; ++value) {
+    EXPECT_EQ(fingerprinter.Fingerprint(value),
+              util::Fingerprint64(absl::StrCat(seed, value)));
+  }
+}
+
+}  // namespace
+}  // namespace wfa_virtual_people
@@ -23,7 +23,7 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "wfa/virtual_people/common/model.pb.h"
-#include "wfa/virtual_people/core/model/utils/distributed_consistent_hashing.h"
+#include "wfa/virtual_people/core/model/utils/column_distributions.h"
 
 namespace wfa_virtual_people {
 namespace {
@@ -31,12 +31,11 @@ namespace {
 using ::wfa::StatusIs;
 
 TEST(SelectFromMatrixTest, NullMatchers) {
-  EXPECT_THAT(SelectFromMatrix(
-                  nullptr, nullptr,
-                  std::vector<std::unique_ptr<DistributedConsistentHashing>>(),
-                  "", LabelerEvent())
-                  .status(),
-              StatusIs(absl::StatusCode::kInternal, ""));
+  ColumnDistributions row_distributions({}, {0});
+  EXPECT_THAT(
+      SelectFromMatrix(nullptr, nullptr, row_distributions, "", LabelerEvent())
+          .status(),
+      StatusIs(absl::StatusCode::kInternal, ""));
 }
 
 }  // namespace
@@ -66,6 +66,44 @@ TEST(VirtualPersonSelectorTest, TestGetVirtualPersonId) {
                              Pair(18446744073709551517u, 995)));
 }
 
+TEST(VirtualPersonSelectorTest, TestLargePopulation) {
+  // The total population exceeds INT32_MAX.
+  PopulationNode population_node;
+  ASSERT_TRUE(google::protobuf::TextFormat::ParseFromString(
+      R"pb(
+        pools { population_offset: 0 total_population: 3000000000 }
+        pools { population_offset: 10000000000 total_population: 3000000000 }
+      )pb",
+      &population_node));
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<VirtualPersonSelector> selector,
+                       VirtualPersonSelector::Build(population_node.pools()));
+
+  double second_pool_count = 0;
+  for (int seed = 0; seed < kSeedNumber; ++seed) {
+    uint64_t id = selector->GetVirtualPersonId(static_cast<uint64_t>(seed));
+    if (id >= 10000000000) {
+      EXPECT_LT(id, 13000000000);
+      ++second_pool_count;
+    } else {
+      EXPECT_LT(id, 3000000000);
+    }
+  }
+  // The expected count is kSeedNumber / 2 = 5000.
+  EXPECT_THAT(second_pool_count, DoubleNear(5000, 250));
+}
+
+TEST(VirtualPersonSelectorTest, TestTotalPopulationTooLarge) {
+  PopulationNode population_node;
+  ASSERT_TRUE(google::protobuf::TextFormat::ParseFromString(
+      R"pb(
+        pools { population_offset: 0 total_population: 9223372036854775807 }
+        pools { population_offset: 0 total_population: 1 }
+      )pb",
+      &population_node));
+  EXPECT_THAT(VirtualPersonSelector::Build(population_node.pools()).status(),
+              StatusIs(absl::StatusCode::kInvalidArgument, ""));
+}
+
 TEST(VirtualPersonSelectorTest, TestInvalidPools) {
   // This is invalid as the total pools size is 0.
   PopulationNode population_node;
@@ -0,0 +1,100 @@
+// Copyright 2026 The Cross-Media Measurement Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "wfa/virtual_people/labeler_runner/bounded_queue.h"
+
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace wfa_virtual_people {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::Optional;
+
+TEST(BoundedQueueTest, TestFifoOrder) {
+  BoundedQueue<int> queue(3);
+  EXPECT_TRUE(queue.Push(1));
+  EXPECT_TRUE(queue.Push(2));
+  EXPECT_TRUE(queue.Push(3));
+  EXPECT_THAT(queue.Pop(), Optional(1));
+  EXPECT_TRUE(queue.Push(4));
+  EXPECT_THAT(queue.Pop(), Optional(2));
+  EXPECT_THAT(queue.Pop(), Optional(3));
+  EXPECT_THAT(queue.Pop(), Optional(4));
+}
+
+TEST(BoundedQueueTest, TestPopAfterClose) {
+  BoundedQueue<int> queue(2);
+  EXPECT_TRUE(queue.Push(1));
+  EXPECT_TRUE(queue.Push(2));
+  queue.Close();
+  // The items pushed before Close are still popped.
+  EXPECT_FALSE(queue.Push(3));
+  EXPECT_THAT(queue.Pop(), Optional(1));
+  EXPECT_THAT(queue.Pop(), Optional(2));
+  EXPECT_EQ(queue.Pop(), std::nullopt);
+  EXPECT_EQ(queue.Pop(), std::nullopt);
+}
+
+TEST(BoundedQueueTest, TestCloseUnblocksConsumer) {
+  BoundedQueue<int> queue(1);
+  std::thread consumer([&queue] { EXPECT_EQ(queue.Pop(), std::nullopt); });
+  queue.Close();
+  consumer.join();
+}
+
+TEST(BoundedQueueTest, TestPushBlocksWhileFull) {
+  BoundedQueue<int> queue(2);
+  std::atomic<int> pushed = 0;
+  std::thread producer([&queue, &pushed] {
+    for (int i = 0; i < 4; ++i) {
+      EXPECT_TRUE(queue.Push(i));
+      ++pushed;
+    }
+    queue.Close();
+  });
+
+  // The producer stops at the capacity until items are popped.
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(pushed, 2);
+
+  std::vector<int> popped;
+  while (std::optional<int> item = queue.Pop()) {
+    popped.push_back(*item);
+  }
+  producer.join();
+  EXPECT_EQ(pushed, 4);
+  EXPECT_THAT(popped, ElementsAre(0, 1, 2, 3));
+}
+
+TEST(BoundedQueueTest, TestCloseUnblocksProducer) {
+  BoundedQueue<int> queue(1);
+  EXPECT_TRUE(queue.Push(1));
+  std::thread producer([&queue] { EXPECT_FALSE(queue.Push(2)); });
+  // The consumer stops early.
+  queue.Close();
+  producer.join();
+  EXPECT_THAT(queue.Pop(), Optional(1));
+  EXPECT_EQ(queue.Pop(), std::nullopt);
+}
+
+}  // namespace
+}  // namespace wfa_virtual_people
@@ -0,0 +1,176 @@
+// Copyright 2026 The Cross-Media Measurement Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "wfa/virtual_people/labeler_runner/labeler_runner.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "common_cpp/protobuf_util/riegeli_io.h"
+#include "common_cpp/protobuf_util/textproto_io.h"
+#include "common_cpp/testing/common_matchers.h"
+#include "common_cpp/testing/status_macros.h"
+#include "common_cpp/testing/status_matchers.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "wfa/virtual_people/common/event.pb.h"
+#include "wfa/virtual_people/common/label.pb.h"
+#include "wfa/virtual_people/common/model.pb.h"
+#include "wfa/virtual_people/core/labeler/labeler.h"
+#include "wfa/virtual_people/core/labeler/parallel_labeler.h"
+
+namespace wfa_virtual_people {
+namespace {
+
+using ::wfa::EqualsProto;
+using ::wfa::IsOk;
+using ::wfa::ReadRiegeliFile;
+using ::wfa::ReadTextProtoFile;
+using ::wfa::StatusIs;
+using ::wfa::WriteRiegeliFile;
+
+const char kTestDataDir[] = "src/main/resources/testing/labeler/";
+const char kToyModelPath[] = "toy_model.textproto";
+
+std::unique_ptr<Labeler> BuildToyModelLabeler() {
+  CompiledNode root;
+  EXPECT_THAT(
+      ReadTextProtoFile(absl::StrCat(kTestDataDir, kToyModelPath), root),
+      IsOk());
+  absl::StatusOr<std::unique_ptr<Labeler>> labeler = Labeler::Build(root);
+  EXPECT_THAT(labeler.status(), IsOk());
+  return labeler.ok() ? *std::move(labeler) : nullptr;
+}
+
+std::vector<LabelerInput> ReadTestInputs() {
+  std::vector<LabelerInput> inputs;
+  for (int i = 1; i < 19; ++i) {
+    EXPECT_THAT(ReadTextProtoFile(
+                    absl::StrFormat("%slabeler_input_%02d.textproto",
+                                    kTestDataDir, i),
+                    inputs.emplace_back()),
+                IsOk());
+  }
+  return inputs;
+}
+
+std::string TempPath(absl::string_view name) {
+  return absl::StrCat(::testing::TempDir(), "/", name);
+}
+
+TEST(LabelerRunnerTest, TestTwoFilesSameAsLabeler) {
+  std::unique_ptr<Labeler> labeler = BuildToyModelLabeler();
+  ASSERT_NE(labeler, nullptr);
+  ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<ParallelLabeler> parallel_labeler,
+      ParallelLabeler::Build(BuildToyModelLabeler(), /*num_threads=*/2));
+
+  // The files are not multiples of the batch size, so that each file ends
+  // with a partial batch.
+  std::vector<LabelerInput> inputs = ReadTestInputs();
+  std::vector<std::vector<LabelerInput>> file_inputs = {
+      std::vector<LabelerInput>(inputs.begin(), inputs.begin() + 7),
+      std::vector<LabelerInput>(inputs.begin() + 7, inputs.end())};
+  std::vector<std::string> input_paths = {TempPath("two_files_input_1"),
+                                          TempPath("two_files_input_2")};
+  std::vector<std::string> output_paths = {TempPath("two_files_output_1"),
+                                           TempPath("two_files_output_2")};
+  for (int i = 0; i < file_inputs.size(); ++i) {
+    ASSERT_THAT(WriteRiegeliFile(input_paths[i], file_inputs[i]), IsOk());
+  }
+
+  LabelerRunnerOptions options;
+  options.batch_size = 3;
+  options.max_pending_batches = 1;
+  ASSERT_OK_AND_ASSIGN(
+      int64_t labeled_records,
+      RunLabeler(*parallel_labeler, input_paths, output_paths, options));
+  EXPECT_EQ(labeled_records, inputs.size());
+
+  for (int i = 0; i < file_inputs.size(); ++i) {
+    std::vector<LabelerOutput> outputs;
+    ASSERT_THAT(ReadRiegeliFile(output_paths[i], outputs), IsOk());
+    ASSERT_EQ(outputs.size(), file_inputs[i].size());
+    for (int j = 0; j < outputs.size(); ++j) {
+      LabelerOutput expected_output;
+      ASSERT_THAT(labeler->Label(file_inputs[i][j], expected_output), IsOk());
+      EXPECT_THAT(outputs[j], EqualsProto(expected_output));
+    }
+  }
+}
+
+TEST(LabelerRunnerTest, TestEmptyFile) {
+  ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<ParallelLabeler> parallel_labeler,
+      ParallelLabeler::Build(BuildToyModelLabeler(), /*num_threads=*/1));
+  std::vector<std::string> input_paths = {TempPath("empty_input")};
+  std::vector<std::string> output_paths = {TempPath("empty_output")};
+  ASSERT_THAT(WriteRiegeliFile(input_paths[0], std::vector<LabelerInput>()),
+              IsOk());
+
+  ASSERT_OK_AND_ASSIGN(int64_t labeled_records,
+                       RunLabeler(*parallel_labeler, input_paths, output_paths,
+                                  LabelerRunnerOptions()));
+  EXPECT_EQ(labeled_records, 0);
+  std::vector<LabelerOutput> outputs;
+  ASSERT_THAT(ReadRiegeliFile(output_paths[0], outputs), IsOk());
+  EXPECT_TRUE(outputs.empty());
+}
+
+TEST(LabelerRunnerTest, TestMissingInputFile) {
+  ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<ParallelLabeler> parallel_labeler,
+      ParallelLabeler::Build(BuildToyModelLabeler(), /*num_threads=*/1));
+  std::vector<std::string> input_paths = {TempPath("missing_input_1"),
+                                          TempPath("missing_input_2")};
+  std::vector<std::string> output_paths = {TempPath("missing_output_1"),
+                                           TempPath("missing_output_2")};
+
+  EXPECT_FALSE(RunLabeler(*parallel_labeler, input_paths, output_paths,
+                          LabelerRunnerOptions())
+                   .ok());
+}
+
+TEST(LabelerRunnerTest, TestInvalidArguments) {
+  ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<ParallelLabeler> parallel_labeler,
+      ParallelLabeler::Build(BuildToyModelLabeler(), /*num_threads=*/1));
+  std::vector<std::string> input_paths = {TempPath("invalid_input")};
+  std::vector<std::string> output_paths = {TempPath("invalid_output")};
+
+  EXPECT_THAT(RunLabeler(*parallel_labeler, input_paths, {},
+                         LabelerRunnerOptions())
+                  .status(),
+              StatusIs(absl::StatusCode::kInvalidArgument, ""));
+  LabelerRunnerOptions zero_batch_size;
+  zero_batch_size.batch_size = 0;
+  EXPECT_THAT(RunLabeler(*parallel_labeler, input_paths, output_paths,
+                         zero_batch_size)
+                  .status(),
+              StatusIs(absl::StatusCode::kInvalidArgument, ""));
+  LabelerRunnerOptions zero_pending_batches;
+  zero_pending_batches.max_pending_batches = 0;
+  EXPECT_THAT(RunLabeler(*parallel_labeler, input_paths, output_paths,
+                         zero_pending_batches)
+                  .status(),
+              StatusIs(absl::StatusCode::kInvalidArgument, ""));
+}
+
+}  // namespace
+}  // namespace wfa_virtual_people
@@ -96,4 +96,14 @@ class FeistelTest {
     assertEquals(392uL, Feistel.permute(1uL, 1000uL, "medium-seed"))
     assertEquals(344uL, Feistel.permute(999uL, 1000uL, "medium-seed"))
   }
+
+  @Test
+  fun `domain above double precision is bijective near the top`() {
+    // The square root of this size is not exact as a double.
+    val domainSize = (1uL shl 62) + 1uL
+    val values = (0uL until 100uL) + (domainSize - 100uL until domainSize)
+    val outputs = values.map { Feistel.permute(it, domainSize, "seed") }.toSet()
+    assertEquals(200, outputs.size)
+    assertTrue(outputs.all { it < domainSize })
+  }
 }